@@ -1,4 +1,5 @@
 from .device import Device
 from .measurement import Measurement
 from .subscriber import PushSubscriber
-from .settings import SubscriberDeviceSettings
\ No newline at end of file
+from .settings import SubscriberDeviceSettings
+from .diagnostics import CycleDiagnostics, DiagPercentile
@@ -0,0 +1,89 @@
+from app.extensions import db
+from datetime import datetime, timezone
+
+
+def utc_now():
+    """Czas UTC bez strefy - tak zapisują go kolumny DateTime w SQLite i PostgreSQL."""
+    return datetime.now(timezone.utc).replace(tzinfo=None)
+
+
+class CycleDiagnostics(db.Model):
+    """Telemetria jednego cyklu urządzenia (firmware: components/diag/diag.h)."""
+    __tablename__ = 'cycle_diagnostics'
+
+    id = db.Column(db.Integer, primary_key=True)
+    # Nazwa urządzenia z tematu MQTT (bez numeru czujnika)
+    unit = db.Column(db.String(50), nullable=False)
+    received_at = db.Column(db.DateTime, default=utc_now, nullable=False)
+
+    # Wybudzenia objęte rekordem (deep sleep) i łączny czas aktywności
+    cycles = db.Column(db.Integer)
+    awake_ms = db.Column(db.BigInteger)
+
+    # {faza: {"us": czas, "calls": wywołania}}
+    phases = db.Column(db.JSON)
+
+    rtt_count = db.Column(db.Integer)
+    rtt_avg_us = db.Column(db.BigInteger)
+    rtt_max_us = db.Column(db.BigInteger)
+
+    heap_free = db.Column(db.BigInteger)
+    heap_min_free = db.Column(db.BigInteger)
+
+    # {task: minimalny zapas stosu w B}
+    tasks = db.Column(db.JSON)
+
+    # Zużycie partycji "storage" od pierwszego uruchomienia (liczniki narastające):
+    # {logical_kb, physical_kb, sectors_erased, records_rewritten, lifetime_days}
+    flash = db.Column(db.JSON)
+
+    __table_args__ = (
+        db.Index('idx_diag_unit_time', 'unit', 'received_at'),
+        db.Index('idx_diag_time', 'received_at'),
+    )
+
+    def to_dict(self):
+        return {
+            "unit": self.unit,
+            "time": self.received_at.strftime('%Y-%m-%dT%H:%M:%SZ'),
+            "cycles": self.cycles,
+            "awake_ms": self.awake_ms,
+            "phases": self.phases,
+            "rtt": {"count": self.rtt_count, "avg_us": self.rtt_avg_us, "max_us": self.rtt_max_us},
+            "heap": {"free": self.heap_free, "min_free": self.heap_min_free},
+            "tasks": self.tasks,
+            "flash": self.flash
+        }
+
+
+class DiagPercentile(db.Model):
+    """Percentyle metryki dla całej floty w jednej godzinie."""
+    __tablename__ = 'diag_percentiles'
+
+    id = db.Column(db.Integer, primary_key=True)
+    period_start = db.Column(db.DateTime, nullable=False)
+    metric = db.Column(db.String(40), nullable=False)
+
+    samples = db.Column(db.Integer, nullable=False)
+    # Dla zapasu stosu i sterty istotne jest minimum, dla czasów - górne percentyle
+    min = db.Column(db.Float)
+    p50 = db.Column(db.Float)
+    p90 = db.Column(db.Float)
+    p99 = db.Column(db.Float)
+    max = db.Column(db.Float)
+
+    __table_args__ = (
+        db.Index('uq_diag_period_metric', 'period_start', 'metric', unique=True),
+    )
+
+    def to_dict(self):
+        return {
+            "period_start": self.period_start.strftime('%Y-%m-%dT%H:%M:%SZ'),
+            "metric": self.metric,
+            "samples": self.samples,
+            "min": self.min,
+            "p50": self.p50,
+            "p90": self.p90,
+            "p99": self.p99,
+            "max": self.max
+        }
@@ -14,16 +14,40 @@ class Measurement(db.Model):
     temperature = db.Column(db.Float)
     pressure = db.Column(db.Float)
 
+    # Agregat okna z ESP (NULL = zwykły pomiar): temperature = średnia, esp_timestamp = początek okna
+    temp_min = db.Column(db.Float)
+    temp_max = db.Column(db.Float)
+    sample_count = db.Column(db.Integer)
+    peak_timestamp = db.Column(db.BigInteger)
+
+    # Numer rekordu z ESP (rośnie przez restarty); NULL = stary firmware bez numeracji
+    seq = db.Column(db.BigInteger)
+    # Epoka numeracji: ESP losuje nową, gdy licznik w NVS przepadł (erase-flash, reset NVS)
+    seq_epoch = db.Column(db.BigInteger, nullable=False, default=0, server_default='0')
+
     __table_args__ = (
         db.Index('idx_device_time', 'device_id', 'timestamp'),
+        # Ponowna wysyłka tego samego rekordu (brak PUBACK, restart w trakcie wysyłki) nie dubluje wiersza
+        db.Index('uq_device_epoch_seq', 'device_id', 'seq_epoch', 'seq', unique=True),
     )
 
     def to_dict(self):
         dt_object = datetime.fromtimestamp(self.esp_timestamp, timezone.utc)
         
-        return {
+        result = {
             "device": self.device_id,
             "temp": self.temperature,
             "press": self.pressure,
             "time": dt_object.strftime('%Y-%m-%dT%H:%M:%S.%f')[:-3] + 'Z'
-        }
\ No newline at end of file
+        }
+
+        if self.sample_count:
+            peak = datetime.fromtimestamp(self.peak_timestamp, timezone.utc)
+            result.update({
+                "min": self.temp_min,
+                "max": self.temp_max,
+                "samples": self.sample_count,
+                "peak_time": peak.strftime('%Y-%m-%dT%H:%M:%S.%f')[:-3] + 'Z'
+            })
+
+        return result
\ No newline at end of file
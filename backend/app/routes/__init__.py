@@ -4,4 +4,6 @@ api_bp = Blueprint('api', __name__)
 
 from . import status
 from . import subscriptions
-from . import measurements
\ No newline at end of file
+from . import measurements
+from . import commands
+from . import diagnostics
\ No newline at end of file
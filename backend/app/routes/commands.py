@@ -0,0 +1,36 @@
+from datetime import datetime
+from flask import request, jsonify
+from app.services.mqtt_service import publish_command
+from . import api_bp
+
+def _parse_time(value):
+    """Czas Unix (liczba) albo ISO 8601."""
+    if isinstance(value, (int, float)):
+        return int(value)
+    return int(datetime.fromisoformat(value).timestamp())
+
+@api_bp.route('/devices/<unit>/resend', methods=['POST'])
+def request_resend(unit):
+    """
+    Odzyskanie utraconych danych (np. po odtworzeniu bazy): urządzenie wysyła ponownie
+    pomiary z zakresu [start, end], o ile wciąż ma je w buforze offline.
+    unit - nazwa urządzenia z tematu MQTT (bez numeru czujnika).
+    Duplikaty odrzuca unikalny indeks (device_id, seq_epoch, seq).
+    """
+    data = request.get_json(silent=True)
+    if not data or 'start' not in data or 'end' not in data:
+        return jsonify({"error": "Wymagane pola start i end"}), 400
+
+    try:
+        start = _parse_time(data['start'])
+        end = _parse_time(data['end'])
+    except (TypeError, ValueError):
+        return jsonify({"error": "Błędny format daty"}), 400
+
+    if end < start:
+        return jsonify({"error": "end wcześniejszy niż start"}), 400
+
+    if not publish_command(unit, f"resend {start} {end}"):
+        return jsonify({"error": "Brak połączenia z brokerem MQTT"}), 503
+
+    return jsonify({"unit": unit, "start": start, "end": end}), 202
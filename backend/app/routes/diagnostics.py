@@ -0,0 +1,56 @@
+from datetime import timedelta
+from flask import request, jsonify
+from app.models import CycleDiagnostics, DiagPercentile
+from app.models.diagnostics import utc_now
+from app.services.diag_service import fleet_percentiles
+from . import api_bp
+
+MAX_HOURS = 24 * 90
+
+@api_bp.route('/diagnostics/percentiles', methods=['GET'])
+def get_diag_percentiles():
+    """
+    Percentyle telemetrii cyklu dla całej floty.
+    hours  - okno wstecz (domyślnie 24)
+    metric - opcjonalnie jedna metryka (np. wifi_ms, awake_ms, stack_uplink)
+    hourly - zapisane percentyle godzinowe; current - policzone teraz z surowych
+             rekordów z całego okna (o ile nie zostały już usunięte)
+    """
+    try:
+        hours = min(int(request.args.get('hours', 24)), MAX_HOURS)
+    except ValueError:
+        return jsonify({"error": "Błędna wartość hours"}), 400
+    metric = request.args.get('metric')
+    since = utc_now() - timedelta(hours=hours)
+
+    query = DiagPercentile.query.filter(DiagPercentile.period_start >= since)
+    if metric:
+        query = query.filter(DiagPercentile.metric == metric)
+    hourly = [p.to_dict() for p in query.order_by(DiagPercentile.period_start.asc()).all()]
+
+    rows = CycleDiagnostics.query.filter(CycleDiagnostics.received_at >= since).all()
+    current = fleet_percentiles(rows)
+    if metric:
+        current = {k: v for k, v in current.items() if k == metric}
+
+    return jsonify({
+        "hours": hours,
+        "records": len(rows),
+        "units": len({row.unit for row in rows}),
+        "current": current,
+        "hourly": hourly
+    })
+
+@api_bp.route('/devices/<unit>/diagnostics', methods=['GET'])
+def get_unit_diagnostics(unit):
+    """Ostatnie rekordy telemetrii urządzenia (limit - liczba rekordów, domyślnie 50)."""
+    try:
+        limit = min(int(request.args.get('limit', 50)), 1000)
+    except ValueError:
+        return jsonify({"error": "Błędna wartość limit"}), 400
+
+    rows = CycleDiagnostics.query.filter_by(unit=unit)\
+        .order_by(CycleDiagnostics.received_at.desc())\
+        .limit(limit).all()
+
+    return jsonify({"unit": unit, "count": len(rows), "data": [r.to_dict() for r in rows]})
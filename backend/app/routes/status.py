@@ -1,13 +1,19 @@
 import os
+import time
 from flask import jsonify
 from app.models import Device
 from app.services.measurement_service import MeasurementService
 from . import api_bp
 
+# Urządzenia z deadbandem przy stałej temperaturze wysyłają pomiar co heartbeat.
+# Brak pomiaru przez dwa heartbeaty = urządzenie uznajemy za martwe, a nie "stabilne".
+DEVICE_HEARTBEAT_S = int(os.getenv("DEVICE_HEARTBEAT_S", 3600))
+
 @api_bp.route('/status', methods=['GET'])
 def get_status():
     devices = Device.query.all()
     devices_data = []
+    now = int(time.time())
     
     for dev in devices:
         last_meas = MeasurementService.get_latest_for_device(dev.id)
@@ -15,7 +21,8 @@ def get_status():
             "device_id": dev.id,
             "name": dev.name,
             "location": dev.location,
-            "last_reading": last_meas.to_dict() if last_meas else None
+            "last_reading": last_meas.to_dict() if last_meas else None,
+            "stale": last_meas is None or now - last_meas.esp_timestamp > 2 * DEVICE_HEARTBEAT_S
         })
 
     return jsonify({
@@ -0,0 +1,142 @@
+import logging
+import math
+import os
+from datetime import timedelta
+from app.extensions import db
+from app.models import CycleDiagnostics, DiagPercentile
+from app.models.diagnostics import utc_now
+
+logger = logging.getLogger(__name__)
+
+# Surowe rekordy trzymamy krótko - na dłużej zostają godzinowe percentyle
+DIAG_RETENTION_DAYS = int(os.getenv("DIAG_RETENTION_DAYS", 14))
+
+# Przy pierwszym uruchomieniu nie liczymy zaległości starszych niż tyle godzin
+ROLLUP_MAX_BACKFILL_H = 7 * 24
+
+_last_rollup_hour = None
+
+
+def _hour_floor(dt):
+    return dt.replace(minute=0, second=0, microsecond=0)
+
+
+def percentile(sorted_values, p):
+    """Percentyl metodą najbliższej rangi (wartość z próby, bez interpolacji)."""
+    if not sorted_values:
+        return None
+    rank = max(1, math.ceil(p / 100 * len(sorted_values)))
+    return sorted_values[rank - 1]
+
+
+def cycle_metrics(row):
+    """
+    Metryki jednego rekordu do percentyli. Faza liczy się tylko w cyklach, w których wystąpiła -
+    cykl bez radia nie zaniża czasu łączenia z WiFi. Odczyt czujnika jako średnia na czujnik.
+    """
+    metrics = {"awake_ms": row.awake_ms}
+
+    for name, phase in (row.phases or {}).items():
+        if not phase.get("calls"):
+            continue
+        if name == "sensor_read":
+            metrics["sensor_read_ms"] = phase["us"] / phase["calls"] / 1000
+        else:
+            metrics[f"{name}_ms"] = phase["us"] / 1000
+
+    if row.rtt_count:
+        metrics["rtt_avg_ms"] = row.rtt_avg_us / 1000
+        metrics["rtt_max_ms"] = row.rtt_max_us / 1000
+
+    metrics["heap_min_free"] = row.heap_min_free
+    for task, stack_free in (row.tasks or {}).items():
+        metrics[f"stack_{task}"] = stack_free
+
+    # Liczniki flasha są narastające - do percentyli idą tylko wielkości względne
+    flash = row.flash or {}
+    if flash.get("logical_kb"):
+        metrics["flash_write_amplification"] = flash["physical_kb"] / flash["logical_kb"]
+    metrics["flash_lifetime_days"] = flash.get("lifetime_days")
+
+    return {k: v for k, v in metrics.items() if v is not None}
+
+
+def fleet_percentiles(rows):
+    """{metryka: {samples, min, p50, p90, p99, max}} dla zbioru rekordów."""
+    values = {}
+    for row in rows:
+        for metric, value in cycle_metrics(row).items():
+            values.setdefault(metric, []).append(value)
+
+    result = {}
+    for metric, vals in values.items():
+        vals.sort()
+        result[metric] = {
+            "samples": len(vals),
+            "min": vals[0],
+            "p50": percentile(vals, 50),
+            "p90": percentile(vals, 90),
+            "p99": percentile(vals, 99),
+            "max": vals[-1]
+        }
+    return result
+
+
+def _rollup_hour(hour_start):
+    rows = CycleDiagnostics.query.filter(
+        CycleDiagnostics.received_at >= hour_start,
+        CycleDiagnostics.received_at < hour_start + timedelta(hours=1)
+    ).all()
+
+    for metric, stats in fleet_percentiles(rows).items():
+        db.session.add(DiagPercentile(period_start=hour_start, metric=metric, **stats))
+    return len(rows)
+
+
+def rollup_pending(app):
+    """
+    Liczy percentyle dla zakończonych godzin, których jeszcze nie ma w diag_percentiles,
+    i kasuje surowe rekordy starsze niż DIAG_RETENTION_DAYS.
+    """
+    with app.app_context():
+        try:
+            current_hour = _hour_floor(utc_now())
+            last_done = db.session.query(db.func.max(DiagPercentile.period_start)).scalar()
+            first_raw = db.session.query(db.func.min(CycleDiagnostics.received_at)).scalar()
+            if first_raw is None:
+                return
+
+            hour = last_done + timedelta(hours=1) if last_done else _hour_floor(first_raw)
+            hour = max(hour, current_hour - timedelta(hours=ROLLUP_MAX_BACKFILL_H))
+
+            while hour < current_hour:
+                count = _rollup_hour(hour)
+                if count:
+                    logger.info(f"📊 Percentyle diagnostyki {hour:%Y-%m-%d %H}:00 z {count} rekordów")
+                hour += timedelta(hours=1)
+
+            cutoff = utc_now() - timedelta(days=DIAG_RETENTION_DAYS)
+            CycleDiagnostics.query.filter(CycleDiagnostics.received_at < cutoff).delete()
+
+            db.session.commit()
+        except Exception as e:
+            db.session.rollback()
+            logger.error(f"Błąd liczenia percentyli diagnostyki: {e}")
+
+
+def save_diagnostics(app, unit, record):
+    """Zapisuje rekord telemetrii cyklu; na początku nowej godziny domyka poprzednie."""
+    global _last_rollup_hour
+
+    try:
+        with app.app_context():
+            db.session.add(CycleDiagnostics(unit=unit, **record))
+            db.session.commit()
+    except Exception as e:
+        logger.error(f"Błąd zapisu diagnostyki {unit}: {e}")
+        return
+
+    hour = _hour_floor(utc_now())
+    if hour != _last_rollup_hour:
+        _last_rollup_hour = hour
+        rollup_pending(app)
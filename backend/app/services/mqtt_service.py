@@ -3,23 +3,69 @@ import json
 import logging
 import time
 import paho.mqtt.client as mqtt
-from app.services.worker import save_measurement_direct, preload_cache
+from app.services.worker import save_measurement_direct, save_measurements_batch, preload_cache
+from app.services.payload_decoder import decode_batch, decode_diag
+from app.services.diag_service import save_diagnostics
 
 logger = logging.getLogger(__name__)
 
+MIN_VALID_TIMESTAMP = 1704067200
+
+# Polecenia do urządzeń (firmware: mqtt_register_command), {unit} = człon tematu z nazwą urządzenia
+CMD_TOPIC = os.getenv("MQTT_CMD_TOPIC", "esp32/smartfridge/{unit}/cmd")
+
+_client = None
+
+def _valid_timestamp(esp_timestamp):
+    if esp_timestamp and int(esp_timestamp) > MIN_VALID_TIMESTAMP:
+        return int(esp_timestamp)
+
+    logger.warning(f"⚠️ Wykryto błędny czas z ESP ({esp_timestamp}). Nadpisuję czasem serwera.")
+    return int(time.time())
+
+def _aggregate_fields(rec):
+    """Pola agregatu okna (firmware: aggregator.h); pusty słownik dla zwykłego pomiaru."""
+    if not rec.get("n"):
+        return {}
+
+    return {
+        'min': float(rec["min"]),
+        'max': float(rec["max"]),
+        'n': int(rec["n"]),
+        'peak': int(rec["peak"])
+    }
+
+def publish_command(unit, command):
+    """
+    Wysyła polecenie do urządzenia jako wiadomość retained - urządzenie w deep sleep
+    odbierze je przy najbliższym połączeniu i samo ją skasuje.
+    """
+    if _client is None or not _client.is_connected():
+        logger.error(f"❌ Brak połączenia MQTT - polecenie '{command}' do {unit} nie wysłane")
+        return False
+
+    topic = CMD_TOPIC.format(unit=unit)
+    info = _client.publish(topic, command, qos=1, retain=True)
+    logger.info(f"📤 Polecenie na {topic}: {command}")
+    return info.rc == mqtt.MQTT_ERR_SUCCESS
+
 def start_mqtt_client(app):
+    global _client
+
     broker = os.getenv("MQTT_BROKER", "127.0.0.1")
     port = int(os.getenv("MQTT_PORT", 1883))
     
     topic = os.getenv("MQTT_TOPIC", "esp32/smartfridge/+/data")
+    batch_topic = os.getenv("MQTT_BATCH_TOPIC", "esp32/smartfridge/+/batch")
+    diag_topic = os.getenv("MQTT_DIAG_TOPIC", "esp32/smartfridge/+/diag")
 
     preload_cache(app)
 
     def on_connect(client, userdata, flags, rc, properties=None):
         if rc == 0:
             logger.info(f"✅ MQTT połączono: {broker}:{port}")
-            client.subscribe(topic)
-            logger.info(f"📡 Nasłuchiwanie na kanale: {topic}")
+            client.subscribe([(topic, 1), (batch_topic, 1), (diag_topic, 0)])
+            logger.info(f"📡 Nasłuchiwanie na kanałach: {topic}, {batch_topic}, {diag_topic}")
         else:
             logger.error(f"❌ Błąd połączenia MQTT: {rc}")
 
@@ -37,25 +83,39 @@ def start_mqtt_client(app):
                 return
 
             device_id_from_topic = topic_parts[2]
+
+            if topic_parts[-1] == "batch":
+                # Paczka binarna: id urządzenia = prefiks z tematu + numer czujnika
+                items = [{
+                    'dev': f"{device_id_from_topic}{rec['id']}",
+                    'ts': _valid_timestamp(rec['ts']),
+                    'temp': rec['temp'],
+                    'press': float(rec['press']),
+                    'seq': rec['seq'],
+                    'epoch': rec['epoch'],
+                    **_aggregate_fields(rec)
+                } for rec in decode_batch(msg.payload)]
+
+                logger.info(f"📦 Paczka {len(items)} pomiarów z {device_id_from_topic}")
+                save_measurements_batch(application, items)
+                return
+
+            if topic_parts[-1] == "diag":
+                # Telemetria cyklu (czasy faz, sterta, stosy) - per urządzenie, nie per czujnik
+                save_diagnostics(application, device_id_from_topic, decode_diag(msg.payload))
+                return
             
             payload = msg.payload.decode()
             data = json.loads(payload)
-            
-            MIN_VALID_TIMESTAMP = 1704067200 
-
-            esp_timestamp = data.get("ts")
-
-            if esp_timestamp and int(esp_timestamp) > MIN_VALID_TIMESTAMP:
-                ts = int(esp_timestamp)
-            else:
-                logger.warning(f"⚠️ Wykryto błędny czas z ESP ({esp_timestamp}). Nadpisuję czasem serwera.")
-                ts = int(time.time())
 
             item = {
                 'dev': device_id_from_topic,
-                'ts': ts,
+                'ts': _valid_timestamp(data.get("ts")),
                 'temp': float(data.get("temp", 0.0)),
-                'press': float(data.get("press", 0.0))
+                'press': float(data.get("press", 0.0)),
+                'seq': data.get("seq"),
+                'epoch': data.get("epoch", 0),
+                **_aggregate_fields(data)
             }
 
             logger.info(f"📥 Dane: {item}")
@@ -63,6 +123,8 @@ def start_mqtt_client(app):
 
         except json.JSONDecodeError:
             logger.error(f"Błąd: Odebrano niepoprawny JSON: {msg.payload}")
+        except ValueError as e:
+            logger.error(f"Błąd: Niepoprawna paczka z {msg.topic}: {e}")
         except Exception as e:
             logger.error(f"Błąd przetwarzania wiadomości MQTT: {e}")
 
@@ -79,6 +141,7 @@ def start_mqtt_client(app):
         client.username_pw_set(user, passwd)
 
     client.user_data_set(app)
+    _client = client
     
     client.on_connect = on_connect
     client.on_message = on_message
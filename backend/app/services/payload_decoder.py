@@ -0,0 +1,166 @@
+import struct
+
+# Format paczki: firmware/components/mqtt_handler/mqtt_payload.h
+BATCH_VERSION = 1
+FLAG_PRESSURE = 0x01
+FLAG_AGGREGATE = 0x02
+FLAG_SEQ = 0x04
+FLAG_EPOCH = 0x08
+
+_HEADER = struct.Struct('<BBHI')   # version, flags, count, base_ts
+_RECORD = struct.Struct('<BHh')    # sensor_id, dt, temp (0.01 C)
+_PRESSURE = struct.Struct('<I')
+_AGGREGATE = struct.Struct('<hhHH')  # min, max (0.01 C), liczba próbek, peak_dt (s od początku okna)
+_SEQ_HEADER = struct.Struct('<I')    # base_seq
+_EPOCH = struct.Struct('<I')         # epoka numeracji (firmware: record_seq.h)
+_SEQ = struct.Struct('<H')           # seq - base_seq
+
+
+def decode_batch(payload):
+    """
+    Dekoduje binarną paczkę pomiarów z ESP32.
+    Zwraca listę słowników {id, ts, temp, press}; rzuca ValueError przy błędnym formacie.
+    Agregat okna ma dodatkowo {min, max, n, peak}: ts = początek okna, temp = średnia,
+    peak = chwila maksimum. Rekordy z numerem mają {seq} (None gdy firmware go nie wysłał)
+    i {epoch} - epokę numeracji, zmienianą przez ESP po resecie licznika (0 = stary firmware).
+    """
+    if len(payload) < _HEADER.size:
+        raise ValueError(f"Za krótka paczka ({len(payload)} B)")
+
+    version, flags, count, base_ts = _HEADER.unpack_from(payload, 0)
+    if version != BATCH_VERSION:
+        raise ValueError(f"Nieobsługiwana wersja paczki: {version}")
+
+    with_pressure = bool(flags & FLAG_PRESSURE)
+    aggregate = bool(flags & FLAG_AGGREGATE)
+    with_seq = bool(flags & FLAG_SEQ)
+    with_epoch = with_seq and bool(flags & FLAG_EPOCH)
+    header_size = _HEADER.size + (_SEQ_HEADER.size if with_seq else 0) + (_EPOCH.size if with_epoch else 0)
+    record_size = (_RECORD.size + (_PRESSURE.size if with_pressure else 0) +
+                   (_AGGREGATE.size if aggregate else 0) + (_SEQ.size if with_seq else 0))
+
+    expected = header_size + count * record_size
+    if len(payload) != expected:
+        raise ValueError(f"Zła długość paczki: {len(payload)} B, oczekiwano {expected} B")
+
+    base_seq = _SEQ_HEADER.unpack_from(payload, _HEADER.size)[0] if with_seq else None
+    epoch = _EPOCH.unpack_from(payload, _HEADER.size + _SEQ_HEADER.size)[0] if with_epoch else 0
+
+    records = []
+    offset = header_size
+    for _ in range(count):
+        sensor_id, dt, temp_centi = _RECORD.unpack_from(payload, offset)
+        offset += _RECORD.size
+
+        press = 0
+        if with_pressure:
+            (press,) = _PRESSURE.unpack_from(payload, offset)
+            offset += _PRESSURE.size
+
+        record = {
+            "id": sensor_id,
+            "ts": base_ts + dt,
+            "temp": temp_centi / 100.0,
+            "press": press,
+            "seq": None,
+            "epoch": epoch
+        }
+
+        if aggregate:
+            min_centi, max_centi, samples, peak_dt = _AGGREGATE.unpack_from(payload, offset)
+            offset += _AGGREGATE.size
+            record.update({
+                "min": min_centi / 100.0,
+                "max": max_centi / 100.0,
+                "n": samples,
+                "peak": record["ts"] + peak_dt
+            })
+
+        if with_seq:
+            (dseq,) = _SEQ.unpack_from(payload, offset)
+            offset += _SEQ.size
+            record["seq"] = base_seq + dseq
+
+        records.append(record)
+
+    return records
+
+# Rekord telemetrii cyklu: firmware/components/diag/diag.h
+DIAG_VERSION = 2   # wersja 1: bez bloku zużycia flasha
+DIAG_PHASES = ('wifi', 'wan_probe', 'sntp', 'mqtt_connect', 'conversion',
+               'sensor_read', 'publish', 'backlog', 'nvs', 'flash')
+
+_DIAG_HEADER = struct.Struct('<BBHI')   # version, phase_count, cycles, awake_ms
+_DIAG_PHASE = struct.Struct('<IH')      # czas (us), liczba wywołań
+_DIAG_TAIL = struct.Struct('<HIIIIB')   # rtt_count, rtt_avg_us, rtt_max_us, heap_free, heap_min_free, task_count
+_DIAG_TASK = struct.Struct('<12sH')      # nazwa, minimalny zapas stosu (B)
+_DIAG_FLASH = struct.Struct('<IIIII')   # logical_kb, physical_kb, sectors_erased, records_rewritten, lifetime_days
+
+DIAG_LIFETIME_UNKNOWN = 0xFFFFFFFF
+
+
+def decode_diag(payload):
+    """
+    Dekoduje rekord telemetrii cyklu z ESP32.
+    Zwraca słownik {cycles, awake_ms, phases: {nazwa: {us, calls}}, rtt_count, rtt_avg_us,
+    rtt_max_us, heap_free, heap_min_free, tasks: {nazwa: zapas stosu}, flash}.
+    flash (od wersji 2, wcześniej None): {logical_kb, physical_kb, sectors_erased,
+    records_rewritten, lifetime_days} - lifetime_days None, gdy firmware nie ma jeszcze szacunku.
+    Fazy spoza DIAG_PHASES (nowszy firmware) dostają nazwę phase<N>.
+    """
+    if len(payload) < _DIAG_HEADER.size:
+        raise ValueError(f"Za krótki rekord diagnostyczny ({len(payload)} B)")
+
+    version, phase_count, cycles, awake_ms = _DIAG_HEADER.unpack_from(payload, 0)
+    if version not in (1, DIAG_VERSION):
+        raise ValueError(f"Nieobsługiwana wersja rekordu diagnostycznego: {version}")
+
+    offset = _DIAG_HEADER.size
+    if len(payload) < offset + phase_count * _DIAG_PHASE.size + _DIAG_TAIL.size:
+        raise ValueError(f"Za krótki rekord diagnostyczny ({len(payload)} B)")
+
+    phases = {}
+    for i in range(phase_count):
+        us, calls = _DIAG_PHASE.unpack_from(payload, offset)
+        offset += _DIAG_PHASE.size
+        name = DIAG_PHASES[i] if i < len(DIAG_PHASES) else f"phase{i}"
+        phases[name] = {"us": us, "calls": calls}
+
+    rtt_count, rtt_avg_us, rtt_max_us, heap_free, heap_min_free, task_count = \
+        _DIAG_TAIL.unpack_from(payload, offset)
+    offset += _DIAG_TAIL.size
+
+    expected = offset + task_count * _DIAG_TASK.size + (_DIAG_FLASH.size if version >= 2 else 0)
+    if len(payload) != expected:
+        raise ValueError(f"Zła długość rekordu diagnostycznego: {len(payload)} B, oczekiwano {expected} B")
+
+    tasks = {}
+    for _ in range(task_count):
+        raw_name, stack_free = _DIAG_TASK.unpack_from(payload, offset)
+        offset += _DIAG_TASK.size
+        tasks[raw_name.rstrip(b'\0').decode(errors='replace')] = stack_free
+
+    flash = None
+    if version >= 2:
+        logical_kb, physical_kb, sectors_erased, records_rewritten, lifetime_days = \
+            _DIAG_FLASH.unpack_from(payload, offset)
+        flash = {
+            "logical_kb": logical_kb,
+            "physical_kb": physical_kb,
+            "sectors_erased": sectors_erased,
+            "records_rewritten": records_rewritten,
+            "lifetime_days": None if lifetime_days == DIAG_LIFETIME_UNKNOWN else lifetime_days
+        }
+
+    return {
+        "cycles": cycles,
+        "awake_ms": awake_ms,
+        "phases": phases,
+        "rtt_count": rtt_count,
+        "rtt_avg_us": rtt_avg_us,
+        "rtt_max_us": rtt_max_us,
+        "heap_free": heap_free,
+        "heap_min_free": heap_min_free,
+        "tasks": tasks,
+        "flash": flash
+    }
@@ -1,5 +1,6 @@
 import logging
-from sqlalchemy import insert
+from sqlalchemy.dialects.postgresql import insert as postgresql_insert
+from sqlalchemy.dialects.sqlite import insert as sqlite_insert
 from sqlalchemy.exc import IntegrityError
 from app.extensions import db
 from app.models import Device, Measurement
@@ -22,6 +23,40 @@ def preload_cache(app):
             logger.warning(f"Nie udało się załadować cache urządzeń: {e}")
 
 
+def _alert_temperature(row):
+    """Dla agregatu okna alarmujemy po maksimum - krótki skok nie ginie w średniej."""
+    return row.temp_max if row.temp_max is not None else row.temperature
+
+
+def _measurement_values(item):
+    return {
+        'device_id': item['dev'],
+        'esp_timestamp': item['ts'],
+        'temperature': item['temp'],
+        'pressure': item['press'],
+        'temp_min': item.get('min'),
+        'temp_max': item.get('max'),
+        'sample_count': item.get('n'),
+        'peak_timestamp': item.get('peak'),
+        'seq': item.get('seq'),
+        'seq_epoch': item.get('epoch') or 0
+    }
+
+
+def _insert_new_measurements():
+    """
+    INSERT pomijający rekordy, które już są w bazie (ten sam device_id, epoka i seq) - ESP ponawia
+    wysyłkę po braku PUBACK albo restarcie. Po resecie NVS numeracja w ESP startuje od 1 z nową
+    epoką, więc nowe rekordy nie giną na starych numerach. Zwraca tylko faktycznie wstawione wiersze,
+    więc powtórka nie wywoła drugiego alertu.
+    """
+    dialect_insert = postgresql_insert if db.engine.dialect.name == 'postgresql' else sqlite_insert
+    return dialect_insert(Measurement)\
+        .on_conflict_do_nothing(index_elements=['device_id', 'seq_epoch', 'seq'])\
+        .returning(Measurement.device_id, Measurement.esp_timestamp,
+                   Measurement.temperature, Measurement.temp_max)
+
+
 def save_measurement_direct(app, item):
     """
     Zapisuje pomiar i uruchamia sprawdzanie alertów dla konkretnych subskrybentów.
@@ -30,24 +65,61 @@ def save_measurement_direct(app, item):
         _get_or_create_device(app, item['dev'])
 
         with app.app_context():
-            stmt = insert(Measurement).values(
-                device_id=item['dev'],
-                esp_timestamp=item['ts'],
-                temperature=item['temp'],
-                pressure=item['press']
-            )
-            db.session.execute(stmt)
+            inserted = db.session.execute(
+                _insert_new_measurements().values(**_measurement_values(item))).all()
             
             device_obj = db.session.get(Device, item['dev'])
             
             db.session.commit()
+
+            if not inserted:
+                print(f"[{item['dev']}] Duplikat seq={item.get('seq')} - pominięty")
+                return
             
             print(f"[{item['dev']}] Zapisano: {item['temp']}°C")
 
             if device_obj:
-                send_alert(item['temp'], device_obj, app)
+                send_alert(_alert_temperature(inserted[0]), device_obj, app)
             else:
                 logger.warning(f"Nie znaleziono urządzenia {item['dev']} podczas wysyłania alertu")
 
     except Exception as e:
-        logger.error(f"Błąd zapisu bezpośredniego: {e}")
\ No newline at end of file
+        logger.error(f"Błąd zapisu bezpośredniego: {e}")
+
+
+def save_measurements_batch(app, items):
+    """
+    Zapisuje paczkę pomiarów jednym INSERT-em (duplikaty po seq pomijane).
+    Alerty sprawdzane raz na urządzenie - dla najwyższej temperatury spośród jego nowych pomiarów,
+    więc przekroczenie w starszych zaległościach z paczki też wywoła alert.
+    """
+    if not items:
+        return
+
+    try:
+        for device_id in {item['dev'] for item in items}:
+            _get_or_create_device(app, device_id)
+
+        with app.app_context():
+            inserted = db.session.execute(_insert_new_measurements(),
+                                          [_measurement_values(item) for item in items]).all()
+
+            db.session.commit()
+
+            print(f"Zapisano paczkę: {len(inserted)} pomiarów")
+            if len(inserted) < len(items):
+                logger.info(f"Pominięto {len(items) - len(inserted)} powtórzonych pomiarów")
+
+            hottest = {}
+            for row in inserted:
+                temperature = _alert_temperature(row)
+                if row.device_id not in hottest or temperature > hottest[row.device_id]:
+                    hottest[row.device_id] = temperature
+
+            for device_id, temperature in hottest.items():
+                device_obj = db.session.get(Device, device_id)
+                if device_obj:
+                    send_alert(temperature, device_obj, app)
+
+    except Exception as e:
+        logger.error(f"Błąd zapisu paczki: {e}")
@@ -0,0 +1,32 @@
+"""Agregaty okien pomiarów
+
+Revision ID: 3f2a9c1d7e4b
+Revises: ebc4d5633669
+Create Date: 2026-10-17 10:12:40.118203
+
+"""
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision = '3f2a9c1d7e4b'
+down_revision = 'ebc4d5633669'
+branch_labels = None
+depends_on = None
+
+
+def upgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.add_column(sa.Column('temp_min', sa.Float(), nullable=True))
+        batch_op.add_column(sa.Column('temp_max', sa.Float(), nullable=True))
+        batch_op.add_column(sa.Column('sample_count', sa.Integer(), nullable=True))
+        batch_op.add_column(sa.Column('peak_timestamp', sa.BigInteger(), nullable=True))
+
+
+def downgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.drop_column('peak_timestamp')
+        batch_op.drop_column('sample_count')
+        batch_op.drop_column('temp_max')
+        batch_op.drop_column('temp_min')
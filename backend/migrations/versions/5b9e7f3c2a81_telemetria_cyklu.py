@@ -0,0 +1,64 @@
+"""Telemetria cyklu urządzeń
+
+Revision ID: 5b9e7f3c2a81
+Revises: 8d51e0b6a2c7
+Create Date: 2026-10-17 14:21:37.904512
+
+"""
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision = '5b9e7f3c2a81'
+down_revision = '8d51e0b6a2c7'
+branch_labels = None
+depends_on = None
+
+
+def upgrade():
+    op.create_table('cycle_diagnostics',
+    sa.Column('id', sa.Integer(), nullable=False),
+    sa.Column('unit', sa.String(length=50), nullable=False),
+    sa.Column('received_at', sa.DateTime(), nullable=False),
+    sa.Column('cycles', sa.Integer(), nullable=True),
+    sa.Column('awake_ms', sa.BigInteger(), nullable=True),
+    sa.Column('phases', sa.JSON(), nullable=True),
+    sa.Column('rtt_count', sa.Integer(), nullable=True),
+    sa.Column('rtt_avg_us', sa.BigInteger(), nullable=True),
+    sa.Column('rtt_max_us', sa.BigInteger(), nullable=True),
+    sa.Column('heap_free', sa.BigInteger(), nullable=True),
+    sa.Column('heap_min_free', sa.BigInteger(), nullable=True),
+    sa.Column('tasks', sa.JSON(), nullable=True),
+    sa.PrimaryKeyConstraint('id')
+    )
+    with op.batch_alter_table('cycle_diagnostics', schema=None) as batch_op:
+        batch_op.create_index('idx_diag_unit_time', ['unit', 'received_at'], unique=False)
+        batch_op.create_index('idx_diag_time', ['received_at'], unique=False)
+
+    op.create_table('diag_percentiles',
+    sa.Column('id', sa.Integer(), nullable=False),
+    sa.Column('period_start', sa.DateTime(), nullable=False),
+    sa.Column('metric', sa.String(length=40), nullable=False),
+    sa.Column('samples', sa.Integer(), nullable=False),
+    sa.Column('min', sa.Float(), nullable=True),
+    sa.Column('p50', sa.Float(), nullable=True),
+    sa.Column('p90', sa.Float(), nullable=True),
+    sa.Column('p99', sa.Float(), nullable=True),
+    sa.Column('max', sa.Float(), nullable=True),
+    sa.PrimaryKeyConstraint('id')
+    )
+    with op.batch_alter_table('diag_percentiles', schema=None) as batch_op:
+        batch_op.create_index('uq_diag_period_metric', ['period_start', 'metric'], unique=True)
+
+
+def downgrade():
+    with op.batch_alter_table('diag_percentiles', schema=None) as batch_op:
+        batch_op.drop_index('uq_diag_period_metric')
+
+    op.drop_table('diag_percentiles')
+    with op.batch_alter_table('cycle_diagnostics', schema=None) as batch_op:
+        batch_op.drop_index('idx_diag_time')
+        batch_op.drop_index('idx_diag_unit_time')
+
+    op.drop_table('cycle_diagnostics')
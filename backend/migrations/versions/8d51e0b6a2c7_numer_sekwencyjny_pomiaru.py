@@ -0,0 +1,28 @@
+"""Numer sekwencyjny pomiaru
+
+Revision ID: 8d51e0b6a2c7
+Revises: 3f2a9c1d7e4b
+Create Date: 2026-10-17 11:02:15.532871
+
+"""
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision = '8d51e0b6a2c7'
+down_revision = '3f2a9c1d7e4b'
+branch_labels = None
+depends_on = None
+
+
+def upgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.add_column(sa.Column('seq', sa.BigInteger(), nullable=True))
+        batch_op.create_index('uq_device_seq', ['device_id', 'seq'], unique=True)
+
+
+def downgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.drop_index('uq_device_seq')
+        batch_op.drop_column('seq')
@@ -0,0 +1,26 @@
+"""Zużycie flasha w telemetrii cyklu
+
+Revision ID: c4a17d9e0f52
+Revises: 5b9e7f3c2a81
+Create Date: 2026-10-17 16:02:11.318406
+
+"""
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision = 'c4a17d9e0f52'
+down_revision = '5b9e7f3c2a81'
+branch_labels = None
+depends_on = None
+
+
+def upgrade():
+    with op.batch_alter_table('cycle_diagnostics', schema=None) as batch_op:
+        batch_op.add_column(sa.Column('flash', sa.JSON(), nullable=True))
+
+
+def downgrade():
+    with op.batch_alter_table('cycle_diagnostics', schema=None) as batch_op:
+        batch_op.drop_column('flash')
@@ -0,0 +1,30 @@
+"""Epoka numeracji pomiarów
+
+Revision ID: e7b3c9a15d24
+Revises: c4a17d9e0f52
+Create Date: 2026-10-17 18:40:27.104512
+
+"""
+from alembic import op
+import sqlalchemy as sa
+
+
+# revision identifiers, used by Alembic.
+revision = 'e7b3c9a15d24'
+down_revision = 'c4a17d9e0f52'
+branch_labels = None
+depends_on = None
+
+
+def upgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.add_column(sa.Column('seq_epoch', sa.BigInteger(), nullable=False, server_default='0'))
+        batch_op.drop_index('uq_device_seq')
+        batch_op.create_index('uq_device_epoch_seq', ['device_id', 'seq_epoch', 'seq'], unique=True)
+
+
+def downgrade():
+    with op.batch_alter_table('measurements', schema=None) as batch_op:
+        batch_op.drop_index('uq_device_epoch_seq')
+        batch_op.create_index('uq_device_seq', ['device_id', 'seq'], unique=True)
+        batch_op.drop_column('seq_epoch')
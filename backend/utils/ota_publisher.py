@@ -0,0 +1,148 @@
+"""
+Aktualizacja firmware urządzenia przez MQTT (firmware: components/mqtt_handler/mqtt_ota.h).
+
+  python utils/ota_publisher.py --keygen
+      tworzy ota_private.pem i wypisuje klucz publiczny do menuconfig (HIVE_OTA_PUBLIC_KEY)
+
+  python utils/ota_publisher.py <urządzenie> build/firmware.bin [--key ota_private.pem]
+      podpisuje obraz, wysyła polecenie "ota" i obsługuje prośby o kawałki aż urządzenie
+      potwierdzi nowy firmware (albo zgłosi, że już na nim działa). Urządzenie w deep sleep
+      pobiera obraz porcjami przy kolejnych wybudzeniach - skrypt może działać długo; po
+      przerwaniu wystarczy uruchomić go ponownie z tym samym plikiem (transfer wznowi się od
+      ostatniego kawałka). Na koniec, także po przerwaniu, polecenie retained jest kasowane.
+"""
+import argparse
+import hashlib
+import os
+import struct
+import sys
+import threading
+import paho.mqtt.client as mqtt
+from cryptography.hazmat.primitives import hashes, serialization
+from cryptography.hazmat.primitives.asymmetric import ec
+from cryptography.hazmat.primitives.asymmetric.utils import decode_dss_signature
+from dotenv import load_dotenv
+
+load_dotenv()
+
+BROKER = os.getenv("MQTT_BROKER", "localhost")
+PORT = int(os.getenv("MQTT_PORT", 8883))
+MQTT_USER = os.getenv("MQTT_LOGIN")
+MQTT_PASS = os.getenv("MQTT_PASS")
+
+BASE_TOPIC = "esp32/smartfridge"
+
+CHUNK_SIZE = 4096   # MQTT_OTA_CHUNK_SIZE
+
+
+def keygen(path):
+    private_key = ec.generate_private_key(ec.SECP256R1())
+    with open(path, "wb") as f:
+        f.write(private_key.private_bytes(
+            serialization.Encoding.PEM,
+            serialization.PrivateFormat.PKCS8,
+            serialization.NoEncryption()
+        ))
+
+    public_bytes = private_key.public_key().public_bytes(
+        serialization.Encoding.X962,
+        serialization.PublicFormat.UncompressedPoint
+    )
+    print(f"\nKlucz prywatny zapisany w {path} - nie dodawaj go do repozytorium!")
+    print("\nWklej do menuconfig -> Aktualizacja firmware -> Klucz publiczny:\n")
+    print(public_bytes.hex())
+
+
+def sign_image(image, key_path):
+    """Podpis ECDSA P-256 nad SHA-256 obrazu jako r || s (64 B)."""
+    with open(key_path, "rb") as f:
+        private_key = serialization.load_pem_private_key(f.read(), password=None)
+
+    r, s = decode_dss_signature(private_key.sign(image, ec.ECDSA(hashes.SHA256())))
+    return r.to_bytes(32, "big") + s.to_bytes(32, "big")
+
+
+def publish_update(unit, image, signature):
+    prefix = f"{BASE_TOPIC}/{unit}"
+    command = f"ota {len(image)} {hashlib.sha256(image).hexdigest()} {signature.hex()}"
+    finished = threading.Event()
+    result = {"ok": False}
+
+    def on_connect(client, userdata, flags, rc, properties=None):
+        client.subscribe([(f"{prefix}/ota/req", 0), (f"{prefix}/ota/status", 1)])
+        # Retained - urządzenie w deep sleep odbierze polecenie przy najbliższym połączeniu
+        client.publish(f"{prefix}/cmd", command, qos=1, retain=True)
+        print(f"Polecenie wysłane na {prefix}/cmd ({len(image)} B), czekam na urządzenie...")
+
+    def on_message(client, userdata, msg):
+        text = msg.payload.decode(errors="replace")
+
+        if msg.topic.endswith("/ota/req"):
+            offset, length = (int(x) for x in text.split())
+            if offset + length > len(image) or length > CHUNK_SIZE:
+                print(f"Błędna prośba: {text}")
+                return
+            client.publish(f"{prefix}/ota/data", struct.pack("<I", offset) + image[offset:offset + length], qos=1)
+            if (offset // CHUNK_SIZE) % 32 == 0:
+                print(f"  {offset + length}/{len(image)} B ({100 * (offset + length) // len(image)}%)")
+            return
+
+        print(f"Status: {text}")
+        if text.startswith("ok"):
+            result["ok"] = True
+            finished.set()
+        elif text.startswith("error"):
+            finished.set()
+
+    try:
+        client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2)
+    except AttributeError:
+        client = mqtt.Client()
+
+    client.tls_set()
+    if MQTT_USER and MQTT_PASS:
+        client.username_pw_set(MQTT_USER, MQTT_PASS)
+
+    client.on_connect = on_connect
+    client.on_message = on_message
+    client.connect(BROKER, PORT, keepalive=60)
+    client.loop_start()
+
+    try:
+        finished.wait()
+    except KeyboardInterrupt:
+        print("\nPrzerwano - urządzenie zachowa postęp i wznowi transfer po ponownym uruchomieniu.")
+    finally:
+        # Bez skasowania broker podawałby polecenie przy każdym połączeniu - także nowemu firmware
+        client.publish(f"{prefix}/cmd", b"", qos=1, retain=True).wait_for_publish(timeout=5)
+        client.loop_stop()
+        client.disconnect()
+
+    return result["ok"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Aktualizacja firmware przez MQTT")
+    parser.add_argument("unit", nargs="?", help="nazwa urządzenia z tematu MQTT")
+    parser.add_argument("image", nargs="?", help="plik .bin z idf.py build")
+    parser.add_argument("--key", default="ota_private.pem", help="klucz prywatny podpisu")
+    parser.add_argument("--keygen", action="store_true", help="utwórz nową parę kluczy")
+    args = parser.parse_args()
+
+    if args.keygen:
+        keygen(args.key)
+        return
+
+    if not args.unit or not args.image:
+        parser.error("wymagane: urządzenie i plik obrazu")
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    ok = publish_update(args.unit, image, sign_image(image, args.key))
+    print("Aktualizacja zakończona." if ok else "Aktualizacja nieudana.")
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,97 @@
+#include "aggregator.h"
+#include "storage_manager.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <inttypes.h>
+
+static const char *TAG = "AGGREGATOR";
+
+#define AGG_NVS_NAMESPACE    "agg"
+#define AGG_MAX_SENSORS      32
+#define AGG_MAX_WINDOW_S     UINT16_MAX   // peak_dt w rekordzie to u16
+#define INVALID_TEMP_LIMIT   -127.0f
+
+typedef struct {
+    int64_t start;      // początek okna (Unix, wyrównany do długości okna)
+    int64_t end;
+    int64_t peak_ts;
+    float sum;
+    float min;
+    float max;
+    uint16_t count;
+} agg_window_t;
+
+static uint32_t s_window_s = CONFIG_HIVE_AGGREGATION_WINDOW_S;
+
+static RTC_DATA_ATTR agg_window_t s_windows[AGG_MAX_SENSORS];
+
+esp_err_t aggregator_init(void) {
+    int32_t window;
+    storage_load_i32(AGG_NVS_NAMESPACE, "window", &window, CONFIG_HIVE_AGGREGATION_WINDOW_S);
+
+    s_window_s = (window > 0 && window <= AGG_MAX_WINDOW_S) ? window : CONFIG_HIVE_AGGREGATION_WINDOW_S;
+    ESP_LOGI(TAG, "Okno agregacji %lu s", (unsigned long)s_window_s);
+    return ESP_OK;
+}
+
+esp_err_t aggregator_set_window(uint32_t window_s) {
+    if (window_s == 0 || window_s > AGG_MAX_WINDOW_S) return ESP_ERR_INVALID_ARG;
+
+    s_window_s = window_s;
+    return storage_save_i32(AGG_NVS_NAMESPACE, "window", (int32_t)window_s);
+}
+
+static SensorData close_window(agg_window_t *w, int sensor_id) {
+    SensorData rec = {
+        .timestamp = w->start,
+        .temp = w->sum / w->count,
+        .sensor_id = sensor_id,
+        .temp_min = w->min,
+        .temp_max = w->max,
+        .count = w->count,
+        .peak_dt = (uint16_t)(w->peak_ts - w->start),
+    };
+    ESP_LOGI(TAG, "ID[%d] okno %" PRId64 ": sr %.2f, min %.2f, max %.2f (%d probek)",
+             sensor_id, w->start, rec.temp, rec.temp_min, rec.temp_max, w->count);
+    w->count = 0;
+    return rec;
+}
+
+size_t aggregator_add(const SensorData *readings, size_t count, SensorData *out, size_t max) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const SensorData *d = &readings[i];
+        if (d->sensor_id < 0 || d->sensor_id >= AGG_MAX_SENSORS) continue;
+        if (d->temp <= INVALID_TEMP_LIMIT) continue;    // błąd odczytu nie psuje statystyk
+
+        agg_window_t *w = &s_windows[d->sensor_id];
+
+        // Pomiar spoza bieżącego okna (także cofnięty zegar po SNTP) zamyka okno
+        if (w->count > 0 && (d->timestamp < w->start || d->timestamp >= w->end)) {
+            if (n < max) {
+                out[n++] = close_window(w, d->sensor_id);
+            } else {
+                ESP_LOGW(TAG, "ID[%d]: brak miejsca na agregat - okno porzucone", d->sensor_id);
+                w->count = 0;
+            }
+        }
+
+        if (w->count == 0) {
+            w->start = d->timestamp - (d->timestamp % s_window_s);
+            w->end = w->start + s_window_s;
+            w->sum = 0.0f;
+            w->min = d->temp;
+            w->max = d->temp;
+            w->peak_ts = d->timestamp;
+        }
+
+        w->sum += d->temp;
+        if (d->temp < w->min) w->min = d->temp;
+        if (d->temp > w->max) {
+            w->max = d->temp;
+            w->peak_ts = d->timestamp;
+        }
+        if (w->count < UINT16_MAX) w->count++;
+    }
+    return n;
+}
@@ -0,0 +1,24 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include "esp_err.h"
+#include "offline_buffer.h"
+#include <stdint.h>
+#include <stddef.h>
+
+// Agregacja okienkowa: przy gęstym próbkowaniu (np. co 10-30 s) zamiast surowych pomiarów
+// dalej idzie jeden rekord na czujnik i okno (wariant agregatu SensorData: średnia, min, max,
+// liczba próbek i chwila maksimum). Krótkie skoki (otwarte drzwi) zostają widoczne w min/max.
+// Okna wyrównane do zegara (jak scheduler.h), długość w NVS (namespace "agg", klucz "window"),
+// domyślnie z Kconfig. Stan okien trzymany w pamięci RTC (przetrwa deep sleep).
+
+esp_err_t aggregator_init(void);
+
+// Dodaje pomiary do okien ich czujników. Okna zamknięte przez te pomiary (pomiar z nowego okna)
+// trafiają do out[] jako agregaty; zwraca ich liczbę (max. jeden na czujnik).
+size_t aggregator_add(const SensorData *readings, size_t count, SensorData *out, size_t max);
+
+// Zmiana długości okna (s); bieżące okna liczone są dalej do swojego końca
+esp_err_t aggregator_set_window(uint32_t window_s);
+
+#endif // AGGREGATOR_H
@@ -0,0 +1,145 @@
+#include "alarm_engine.h"
+#include "storage_manager.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <stdio.h>
+
+static const char *TAG = "ALARM";
+
+#define ALARM_NVS_NAMESPACE  "alarm"
+#define INVALID_TEMP_LIMIT   -127.0f
+
+typedef struct {
+    uint8_t level;          // alarm_level_t - aktywny alarm
+    uint8_t pending_level;  // przekroczenie, które jeszcze nie trwa min_duration_s
+    int64_t pending_since;
+} alarm_state_t;
+
+static alarm_config_t s_config[ALARM_MAX_SENSORS];
+static int s_sensor_count = 0;
+
+// Zerowane przy zimnym starcie, zachowane w deep sleep
+static RTC_DATA_ATTR alarm_state_t s_state[ALARM_MAX_SENSORS];
+
+static const char *level_name(uint8_t level) {
+    switch (level) {
+        case ALARM_HIGH: return "WYSOKA";
+        case ALARM_LOW:  return "NISKA";
+        default:         return "OK";
+    }
+}
+
+static void config_key(int id, char *key, size_t len) {
+    snprintf(key, len, "cfg%d", id);
+}
+
+static void default_config(alarm_config_t *cfg) {
+    cfg->high_c10 = CONFIG_HIVE_ALARM_HIGH;
+    cfg->low_c10 = CONFIG_HIVE_ALARM_LOW;
+    cfg->hysteresis_c10 = CONFIG_HIVE_ALARM_HYSTERESIS;
+    cfg->min_duration_s = CONFIG_HIVE_ALARM_MIN_DURATION_S;
+    cfg->enabled = 1;
+}
+
+esp_err_t alarm_engine_init(int sensor_count) {
+    s_sensor_count = (sensor_count < ALARM_MAX_SENSORS) ? sensor_count : ALARM_MAX_SENSORS;
+
+    char key[16];
+    for (int i = 0; i < s_sensor_count; i++) {
+        config_key(i, key, sizeof(key));
+        if (storage_load_blob(ALARM_NVS_NAMESPACE, key, &s_config[i], sizeof(alarm_config_t)) != ESP_OK) {
+            default_config(&s_config[i]);
+        }
+        ESP_LOGI(TAG, "ID[%d]: %s, zakres %.1f..%.1f C, histereza %.1f C, min. %d s", i,
+                 s_config[i].enabled ? "aktywny" : "wylaczony",
+                 s_config[i].low_c10 / 10.0f, s_config[i].high_c10 / 10.0f,
+                 s_config[i].hysteresis_c10 / 10.0f, s_config[i].min_duration_s);
+    }
+    return ESP_OK;
+}
+
+// Zwraca true przy zmianie aktywnego alarmu
+static bool update_sensor(int id, float temp, int64_t now) {
+    const alarm_config_t *cfg = &s_config[id];
+    alarm_state_t *st = &s_state[id];
+
+    if (!cfg->enabled) {
+        bool was_active = (st->level != ALARM_NONE);
+        st->level = ALARM_NONE;
+        st->pending_level = ALARM_NONE;
+        return was_active;
+    }
+
+    float high = cfg->high_c10 / 10.0f;
+    float low = cfg->low_c10 / 10.0f;
+    float hyst = cfg->hysteresis_c10 / 10.0f;
+
+    uint8_t breach = (temp > high) ? ALARM_HIGH : (temp < low) ? ALARM_LOW : ALARM_NONE;
+
+    if (st->level == ALARM_NONE) {
+        if (breach == ALARM_NONE) {
+            st->pending_level = ALARM_NONE;
+            return false;
+        }
+        if (st->pending_level != breach) {
+            st->pending_level = breach;
+            st->pending_since = now;
+        }
+        if (now - st->pending_since < cfg->min_duration_s) {
+            return false;
+        }
+        st->level = breach;
+        st->pending_level = ALARM_NONE;
+        ESP_LOGW(TAG, "ID[%d]: ALARM - temperatura %s (%.2f C)", id, level_name(breach), temp);
+        return true;
+    }
+
+    bool clear = (st->level == ALARM_HIGH) ? (temp <= high - hyst) : (temp >= low + hyst);
+    if (clear) {
+        ESP_LOGW(TAG, "ID[%d]: koniec alarmu (%.2f C)", id, temp);
+        st->level = ALARM_NONE;
+        st->pending_level = ALARM_NONE;
+        return true;
+    }
+    return false;
+}
+
+bool alarm_engine_update(const SensorData *readings, size_t count, int64_t now) {
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        int id = readings[i].sensor_id;
+        if (id < 0 || id >= s_sensor_count) continue;
+        if (readings[i].temp <= INVALID_TEMP_LIMIT) continue; // błąd odczytu
+        changed |= update_sensor(id, readings[i].temp, now);
+    }
+    return changed;
+}
+
+bool alarm_engine_pending(void) {
+    for (int i = 0; i < s_sensor_count; i++) {
+        if (s_state[i].pending_level != ALARM_NONE) return true;
+    }
+    return false;
+}
+
+alarm_level_t alarm_engine_level(int sensor_id) {
+    if (sensor_id < 0 || sensor_id >= s_sensor_count) return ALARM_NONE;
+    return (alarm_level_t)s_state[sensor_id].level;
+}
+
+esp_err_t alarm_engine_get_config(int sensor_id, alarm_config_t *cfg) {
+    if (sensor_id < 0 || sensor_id >= s_sensor_count) return ESP_ERR_INVALID_ARG;
+    *cfg = s_config[sensor_id];
+    return ESP_OK;
+}
+
+esp_err_t alarm_engine_set_config(int sensor_id, const alarm_config_t *cfg) {
+    if (sensor_id < 0 || sensor_id >= ALARM_MAX_SENSORS || cfg->low_c10 >= cfg->high_c10) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_config[sensor_id] = *cfg;
+
+    char key[16];
+    config_key(sensor_id, key, sizeof(key));
+    return storage_save_blob(ALARM_NVS_NAMESPACE, key, cfg, sizeof(alarm_config_t));
+}
@@ -0,0 +1,47 @@
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+#include "esp_err.h"
+#include "offline_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Alarmy temperatury liczone na urządzeniu (niezależnie od backendu).
+// Alarm włącza się, gdy temperatura jest poza [low, high] nieprzerwanie przez min_duration_s,
+// a wyłącza dopiero po powrocie o hysteresis do środka zakresu.
+// Konfiguracja per czujnik w NVS (namespace "alarm", klucz "cfg<ID>"), stan w pamięci RTC
+// (przetrwa deep sleep).
+
+#define ALARM_MAX_SENSORS   32
+
+typedef struct {
+    int16_t high_c10;           // górny próg (0.1 C)
+    int16_t low_c10;            // dolny próg (0.1 C)
+    uint16_t hysteresis_c10;    // histereza kasowania alarmu (0.1 C)
+    uint16_t min_duration_s;    // minimalny czas trwania przekroczenia
+    uint8_t enabled;
+} alarm_config_t;
+
+typedef enum {
+    ALARM_NONE = 0,
+    ALARM_HIGH,
+    ALARM_LOW,
+} alarm_level_t;
+
+esp_err_t alarm_engine_init(int sensor_count);
+
+// Przetwarza pomiary (now = czas w sekundach). Zwraca true, gdy któryś alarm się włączył lub wyłączył.
+bool alarm_engine_update(const SensorData *readings, size_t count, int64_t now);
+
+// Czy jakieś przekroczenie trwa, ale jeszcze nie dość długo (warto sprawdzić wcześniej niż zwykle)
+bool alarm_engine_pending(void);
+
+alarm_level_t alarm_engine_level(int sensor_id);
+
+esp_err_t alarm_engine_get_config(int sensor_id, alarm_config_t *cfg);
+
+// Zmienia konfigurację czujnika i zapisuje ją w NVS
+esp_err_t alarm_engine_set_config(int sensor_id, const alarm_config_t *cfg);
+
+#endif // ALARM_ENGINE_H
@@ -153,8 +153,11 @@ static void gatts_event_handler(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_
             if (param->write.handle == s_handle_action && !param->write.is_prep) {
                 if (param->write.len > 0 && param->write.value[0] == '1') {
                     ESP_LOGW(TAG, "ZAPIS I RESTART...");
+                    // SSID i hasło razem - jeden commit
+                    storage_begin("wifi");
                     storage_save_str("wifi", "ssid", s_wifi_ssid);
                     storage_save_str("wifi", "pass", s_wifi_pass);
+                    storage_commit("wifi");
                     vTaskDelay(pdMS_TO_TICKS(500)); 
                     esp_restart();
                 }
@@ -230,6 +233,10 @@ void ble_config_stop(void) {
     ble_config_stop_internal();
 }
 
+bool ble_config_is_active(void) {
+    return s_ble_is_active;
+}
+
 // ----------------------------------------------------------------------------
 //                              TASK PRZYCISKU
 // ----------------------------------------------------------------------------
@@ -2,6 +2,7 @@
 #define BLE_CONFIG_H
 
 #include "driver/gpio.h"
+#include <stdbool.h>
 
 // Inicjalizacja komponentu i start taska przycisku
 void ble_config_init(gpio_num_t boot_btn_gpio);
@@ -9,4 +10,7 @@ void ble_config_init(gpio_num_t boot_btn_gpio);
 // Ręczne zatrzymanie
 void ble_config_stop(void);
 
+// Czy trwa sesja konfiguracji BLE (np. żeby nie usypiać urządzenia)
+bool ble_config_is_active(void);
+
 #endif // BLE_CONFIG_H
\ No newline at end of file
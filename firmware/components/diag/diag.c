@@ -0,0 +1,188 @@
+#include "diag.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include <stdbool.h>
+#include <string.h>
+
+// Liczniki od ostatniego rekordu; w RTC, żeby przetrwały deep sleep
+typedef struct {
+    uint64_t awake_us;
+    uint32_t phase_us[DIAG_PHASE_COUNT];
+    uint16_t phase_calls[DIAG_PHASE_COUNT];
+    uint16_t cycles;
+    uint16_t rtt_count;
+    uint64_t rtt_sum_us;
+    uint32_t rtt_max_us;
+} diag_counters_t;
+
+static RTC_DATA_ATTR diag_counters_t s_acc;
+
+static int64_t s_cycle_start_us = 0;
+static diag_flash_wear_t s_wear = { .lifetime_days = UINT32_MAX };
+// Śledzone taski; NULL = task już nie istnieje (diag_unwatch_task), zostaje jego ostatni pomiar
+static TaskHandle_t s_tasks[DIAG_MAX_TASKS];
+static char s_task_names[DIAG_MAX_TASKS][DIAG_TASK_NAME_LEN];
+static uint16_t s_task_min_free[DIAG_MAX_TASKS];
+static int s_task_count = 0;
+
+// Fazy liczą taski pomiarów, wysyłki i esp-mqtt jednocześnie
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static inline uint32_t sat_u32(uint64_t v) {
+    return v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+}
+
+void diag_cycle_start(void) {
+    portENTER_CRITICAL(&s_lock);
+    s_cycle_start_us = esp_timer_get_time();
+    if (s_acc.cycles < UINT16_MAX) s_acc.cycles++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void diag_cycle_end(void) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    s_acc.awake_us += now - s_cycle_start_us;
+    s_cycle_start_us = now;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void diag_phase_add(diag_phase_t phase, int64_t start_us) {
+    if (phase >= DIAG_PHASE_COUNT) return;
+    int64_t elapsed = esp_timer_get_time() - start_us;
+    if (elapsed < 0) elapsed = 0;
+
+    portENTER_CRITICAL(&s_lock);
+    s_acc.phase_us[phase] = sat_u32((uint64_t)s_acc.phase_us[phase] + (uint64_t)elapsed);
+    if (s_acc.phase_calls[phase] < UINT16_MAX) s_acc.phase_calls[phase]++;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void diag_rtt_add(uint32_t rtt_us) {
+    portENTER_CRITICAL(&s_lock);
+    if (s_acc.rtt_count < UINT16_MAX) {
+        s_acc.rtt_count++;
+        s_acc.rtt_sum_us += rtt_us;
+    }
+    if (rtt_us > s_acc.rtt_max_us) s_acc.rtt_max_us = rtt_us;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void diag_set_flash_wear(const diag_flash_wear_t *wear) {
+    portENTER_CRITICAL(&s_lock);
+    s_wear = *wear;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static inline uint16_t stack_free(TaskHandle_t task) {
+    UBaseType_t free = uxTaskGetStackHighWaterMark(task);
+    return free > UINT16_MAX ? UINT16_MAX : (uint16_t)free;
+}
+
+void diag_watch_task(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    const char *name = pcTaskGetName(task);
+
+    portENTER_CRITICAL(&s_lock);
+    int slot = -1;
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i] == task) {
+            portEXIT_CRITICAL(&s_lock);
+            return;
+        }
+        // Nowe wcielenie taska o tej nazwie (np. esp-mqtt po ponownym połączeniu) - wspólny wpis
+        if (s_tasks[i] == NULL && strncmp(s_task_names[i], name, DIAG_TASK_NAME_LEN) == 0) slot = i;
+    }
+    if (slot < 0 && s_task_count < DIAG_MAX_TASKS) {
+        slot = s_task_count++;
+        strncpy(s_task_names[slot], name, DIAG_TASK_NAME_LEN);
+        s_task_min_free[slot] = UINT16_MAX;
+    }
+    if (slot >= 0) s_tasks[slot] = task;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void diag_unwatch_task(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    uint16_t free = stack_free(task);
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_task_count; i++) {
+        if (s_tasks[i] == task) {
+            if (free < s_task_min_free[i]) s_task_min_free[i] = free;
+            s_tasks[i] = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+size_t diag_take_record(uint8_t *buf, size_t buf_len) {
+    if (buf_len < DIAG_RECORD_MAX_SIZE) return 0;
+
+    // Migawka i wyzerowanie - dalsze fazy trafią do kolejnego rekordu
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    diag_counters_t c = s_acc;
+    diag_flash_wear_t wear = s_wear;
+    c.awake_us += now - s_cycle_start_us;
+    memset(&s_acc, 0, sizeof(s_acc));
+    s_cycle_start_us = now;
+    portEXIT_CRITICAL(&s_lock);
+
+    uint8_t *p = buf;
+    p[0] = 2;   // wersja
+    p[1] = DIAG_PHASE_COUNT;
+    put_u16(&p[2], c.cycles);
+    put_u32(&p[4], sat_u32(c.awake_us / 1000));
+    p += 8;
+
+    for (int i = 0; i < DIAG_PHASE_COUNT; i++) {
+        put_u32(p, c.phase_us[i]);
+        put_u16(p + 4, c.phase_calls[i]);
+        p += 6;
+    }
+
+    put_u16(p, c.rtt_count);
+    put_u32(p + 2, c.rtt_count ? sat_u32(c.rtt_sum_us / c.rtt_count) : 0);
+    put_u32(p + 6, c.rtt_max_us);
+    p += 10;
+
+    put_u32(p, esp_get_free_heap_size());
+    put_u32(p + 4, esp_get_minimum_free_heap_size());
+    p += 8;
+
+    // Uchwyty są ważne: taski usuwa (po diag_unwatch_task) ten sam task wysyłki, który woła rekord
+    *p++ = (uint8_t)s_task_count;
+    for (int i = 0; i < s_task_count; i++) {
+        uint16_t min_free = s_task_min_free[i];
+        if (s_tasks[i] != NULL) {
+            uint16_t free = stack_free(s_tasks[i]);
+            if (free < min_free) min_free = free;
+        }
+        memcpy(p, s_task_names[i], DIAG_TASK_NAME_LEN);
+        put_u16(p + DIAG_TASK_NAME_LEN, min_free);
+        p += DIAG_TASK_NAME_LEN + 2;
+    }
+
+    put_u32(p, sat_u32(wear.logical_bytes / 1024));
+    put_u32(p + 4, sat_u32(wear.physical_bytes / 1024));
+    put_u32(p + 8, wear.sectors_erased);
+    put_u32(p + 12, wear.records_rewritten);
+    put_u32(p + 16, wear.lifetime_days);
+    p += 20;
+
+    return p - buf;
+}
@@ -0,0 +1,79 @@
+#ifndef DIAG_H
+#define DIAG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Telemetria cyklu: czasy faz (esp_timer), RTT publikacji, sterta i stosy tasków.
+// Liczniki sumują się od ostatniego rekordu - w deep sleep przez kolejne wybudzenia
+// (pamięć RTC), więc rekord wysłany przy połączeniu obejmuje też wybudzenia bez radia.
+//
+// Rekord (little-endian), temat "<prefiks>/diag", wersja 2:
+//
+//   u8 version | u8 phase_count | u16 cycles | u32 awake_ms
+//   phase_count x (u32 czas_us | u16 wywołania)       kolejność wg diag_phase_t
+//   u16 rtt_count | u32 rtt_avg_us | u32 rtt_max_us    PUBLISH -> PUBACK
+//   u32 heap_free | u32 heap_min_free                  B
+//   u8 task_count | task_count x (char name[12] | u16 stack_min_free B)
+//   u32 logical_kb | u32 physical_kb | u32 sectors_erased | u32 records_rewritten
+//   u32 lifetime_days                                  partycja "storage" (flash_wear.h)
+//
+// Wersja 1 to ten sam rekord bez bloku zużycia flasha.
+//
+// Fazy mogą się zawierać (np. zapis NVS w trakcie wysyłki zaległości) - każda liczona osobno.
+
+typedef enum {
+    DIAG_PHASE_WIFI = 0,        // asocjacja + DHCP
+    DIAG_PHASE_WAN_PROBE,       // check_internet_connection
+    DIAG_PHASE_SNTP,            // obtain_time
+    DIAG_PHASE_MQTT_CONNECT,    // TCP + TLS + CONNECT/CONNACK
+    DIAG_PHASE_CONVERSION,      // konwersja DS18B20 (wszystkie magistrale naraz)
+    DIAG_PHASE_SENSOR_READ,     // odczyt scratchpadu - wywołanie = jeden czujnik
+    DIAG_PHASE_PUBLISH,         // wysyłka bieżących pomiarów do ostatniego PUBACK
+    DIAG_PHASE_BACKLOG,         // drain_backlog (bufor offline + resend)
+    DIAG_PHASE_NVS,             // storage_manager: wczytanie namespace, zapis + commit
+    DIAG_PHASE_FLASH,           // flash_ring: kasowanie sektora, zapis wpisu
+    DIAG_PHASE_COUNT
+} diag_phase_t;
+
+#define DIAG_MAX_TASKS      4
+#define DIAG_TASK_NAME_LEN  12
+#define DIAG_RECORD_MAX_SIZE (8 + DIAG_PHASE_COUNT * 6 + 10 + 8 + 1 + DIAG_MAX_TASKS * (DIAG_TASK_NAME_LEN + 2) + 20)
+
+// Liczniki zużycia partycji "storage" - ustawia bufor offline, rekord niesie ostatnią wartość
+typedef struct {
+    uint64_t logical_bytes;
+    uint64_t physical_bytes;
+    uint32_t sectors_erased;
+    uint32_t records_rewritten;
+    uint32_t lifetime_days;     // UINT32_MAX = brak prognozy
+} diag_flash_wear_t;
+
+// Początek cyklu: wybudzenie (deep sleep) albo start wysyłki (tryb ciągły)
+void diag_cycle_start(void);
+
+// Koniec cyklu bez rekordu - czas aktywności przechodzi do następnego (przed esp_deep_sleep_start)
+void diag_cycle_end(void);
+
+// Dolicza do fazy czas od start_us (wartość esp_timer_get_time() z początku fazy).
+// Bezpieczne z wielu tasków.
+void diag_phase_add(diag_phase_t phase, int64_t start_us);
+
+// Czas od publikacji do PUBACK jednej wiadomości
+void diag_rtt_add(uint32_t rtt_us);
+
+void diag_set_flash_wear(const diag_flash_wear_t *wear);
+
+// Dodaje task do śledzenia zapasu stosu; NULL = task wołający
+void diag_watch_task(TaskHandle_t task);
+
+// Ostatni pomiar stosu i koniec śledzenia - przed usunięciem taska (np. esp-mqtt przy
+// mqtt_app_stop). Wpis zostaje w rekordzie; nowy task o tej samej nazwie go przejmuje.
+void diag_unwatch_task(TaskHandle_t task);
+
+// Koduje rekord do buf (min. DIAG_RECORD_MAX_SIZE) i zeruje liczniki. Zwraca długość.
+size_t diag_take_record(uint8_t *buf, size_t buf_len);
+
+#endif // DIAG_H
@@ -1,9 +1,14 @@
 #include "mqtt_handler.h"
 #include "mqtt_client.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/event_groups.h"
+#include "freertos/queue.h"
 #include "esp_crt_bundle.h"
 #include "offline_buffer.h" 
+#include "mqtt_payload.h"
+#include "mqtt_ota.h"
+#include "diag.h"
 #include <string.h>
 
 static const char *TAG = "MQTT_HANDLER";
@@ -13,31 +18,172 @@ static const char *TAG = "MQTT_HANDLER";
 #define MQTT_USERNAME       CONFIG_HIVE_MQTT_USERNAME
 #define MQTT_PASSWORD       CONFIG_HIVE_MQTT_PASSWORD
 #define MQTT_TOPIC_BASE     CONFIG_HIVE_MQTT_TOPIC 
+#define MQTT_INFLIGHT_WINDOW CONFIG_HIVE_MQTT_INFLIGHT_WINDOW
+#define MQTT_ACK_TIMEOUT_MS 5000
 
 // Flagi zdarzeń
 static EventGroupHandle_t s_mqtt_event_group;
 #define MQTT_CONNECTED_BIT  BIT0
-#define MQTT_PUBLISHED_BIT  BIT1
 #define MQTT_FAIL_BIT       BIT2
 
+// Kolejka msg_id z PUBACK (MQTT_EVENT_PUBLISHED); -1 oznacza zerwanie połączenia.
+// Czas odbioru z tasku esp-mqtt - potwierdzenie może czekać w kolejce, aż okno się zapełni.
+typedef struct {
+    int msg_id;
+    int64_t at_us;
+} mqtt_ack_t;
+
+static QueueHandle_t s_ack_queue = NULL;
+#define MQTT_ACK_ABORT      (-1)
+
+// Temat paczek: ostatni człon tematu z Kconfig zamieniony na "batch"
+static char s_batch_topic[128];
+static char s_diag_topic[128];
+static int s_topic_prefix_len = 0;
+
+// Polecenia z serwera: temat ".../cmd", treść "<nazwa> [argumenty]"
+#define MQTT_MAX_COMMANDS   4
+#define MQTT_CMD_MAX_LEN    256     // mieści polecenie "ota" z hashem i podpisem
+
+typedef struct {
+    const char *name;
+    mqtt_command_handler_t handler;
+} mqtt_command_t;
+
+static char s_cmd_topic[128];
+static mqtt_command_t s_commands[MQTT_MAX_COMMANDS];
+static int s_command_count = 0;
+
 static esp_mqtt_client_handle_t client = NULL;
 
+// Pomiar czasu zestawiania połączenia (TCP + TLS handshake + MQTT CONNECT/CONNACK)
+static int64_t s_connect_start_us = 0;
+static uint32_t s_last_connect_ms = 0;
+
+static TaskHandle_t s_mqtt_task = NULL;    // task esp-mqtt śledzony przez diag
+
+static void build_batch_topic(void) {
+    const char *topic_config = MQTT_TOPIC_BASE;
+    char *last_slash = strrchr(topic_config, '/');
+    int prefix_len = last_slash ? last_slash - topic_config : (int)strlen(topic_config);
+
+    s_topic_prefix_len = prefix_len;
+    snprintf(s_batch_topic, sizeof(s_batch_topic), "%.*s/batch", prefix_len, topic_config);
+    snprintf(s_cmd_topic, sizeof(s_cmd_topic), "%.*s/cmd", prefix_len, topic_config);
+    snprintf(s_diag_topic, sizeof(s_diag_topic), "%.*s/diag", prefix_len, topic_config);
+}
+
+bool mqtt_register_command(const char *name, mqtt_command_handler_t handler) {
+    if (s_command_count >= MQTT_MAX_COMMANDS) return false;
+    s_commands[s_command_count++] = (mqtt_command_t){ .name = name, .handler = handler };
+    return true;
+}
+
+// Polecenia są publikowane jako retained (urządzenie z deep sleep odbiera je przy połączeniu).
+// Po obsłudze kasujemy je zawsze: klient już zasubskrybowany dostaje je z retain=0 (MQTT 3.1.1),
+// a mimo to broker trzyma kopię i powtórzyłby polecenie przy następnym połączeniu.
+static void clear_command(void) {
+    esp_mqtt_client_enqueue(client, s_cmd_topic, "", 0, 1, 1, true);
+}
+
+// Wywoływane w tasku esp-mqtt - procedury poleceń nie mogą czekać na sieć
+static void handle_command(esp_mqtt_event_handle_t event) {
+    if (event->topic_len != (int)strlen(s_cmd_topic) ||
+        strncmp(event->topic, s_cmd_topic, event->topic_len) != 0) {
+        return;
+    }
+    if (event->data_len == 0) return; // skasowanie wiadomości retained
+    if (event->current_data_offset != 0 || event->data_len != event->total_data_len ||
+        event->data_len >= MQTT_CMD_MAX_LEN) {
+        ESP_LOGW(TAG, "Polecenie za dlugie (%d B) - pomijam", event->total_data_len);
+        clear_command();
+        return;
+    }
+
+    char cmd[MQTT_CMD_MAX_LEN];
+    memcpy(cmd, event->data, event->data_len);
+    cmd[event->data_len] = '\0';
+
+    char *args = strchr(cmd, ' ');
+    if (args != NULL) *args++ = '\0';
+
+    bool known = false;
+    for (int i = 0; i < s_command_count; i++) {
+        if (strcmp(cmd, s_commands[i].name) == 0) {
+            ESP_LOGI(TAG, "Polecenie: %s %s", cmd, args ? args : "");
+            s_commands[i].handler(args ? args : "");
+            known = true;
+            break;
+        }
+    }
+    if (!known) {
+        ESP_LOGW(TAG, "Nieznane polecenie: %s", cmd);
+    }
+
+    clear_command();
+}
+
+// Temat pojedynczego pomiaru JSON: <prefiks><id>/<ostatni człon>
+static void build_topic(int sensor_id, char *topic, size_t topic_len) {
+    const char *topic_config = MQTT_TOPIC_BASE;
+    char *last_slash = strrchr(topic_config, '/');
+
+    if (last_slash != NULL) {
+        int prefix_len = last_slash - topic_config;
+
+        snprintf(topic, topic_len, "%.*s%d%s", 
+                 prefix_len, topic_config, sensor_id, last_slash);
+    } else {
+        snprintf(topic, topic_len, "%s%d", topic_config, sensor_id);
+    }
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data) {
+    (void)handler_args;
+    (void)base;
     esp_mqtt_event_handle_t event = event_data;
     
     switch ((esp_mqtt_event_id_t)event_id) {
+        case MQTT_EVENT_BEFORE_CONNECT:
+            // Każda próba (także automatyczne wznowienie przez esp-mqtt)
+            s_connect_start_us = esp_timer_get_time();
+            break;
+
         case MQTT_EVENT_CONNECTED:
-            ESP_LOGI(TAG, "MQTT Polaczono z: %s", MQTT_BROKER_URI);
+            s_last_connect_ms = (uint32_t)((esp_timer_get_time() - s_connect_start_us) / 1000);
+            ESP_LOGI(TAG, "MQTT Polaczono z: %s (TCP+TLS+CONNECT: %lu ms)", MQTT_BROKER_URI,
+                     (unsigned long)s_last_connect_ms);
+            diag_phase_add(DIAG_PHASE_MQTT_CONNECT, s_connect_start_us);
+            // Task esp-mqtt żyje do mqtt_app_stop, tam jest wyrejestrowywany
+            if (s_mqtt_task == NULL) {
+                s_mqtt_task = xTaskGetCurrentTaskHandle();
+                diag_watch_task(s_mqtt_task);
+            }
+            if (s_command_count > 0) {
+                esp_mqtt_client_subscribe(client, s_cmd_topic, 1);
+            }
+#if CONFIG_HIVE_OTA
+            mqtt_ota_on_connected(client, MQTT_TOPIC_BASE, s_topic_prefix_len);
+#endif
             xEventGroupSetBits(s_mqtt_event_group, MQTT_CONNECTED_BIT);
             break;
+
+        case MQTT_EVENT_DATA:
+#if CONFIG_HIVE_OTA
+            if (mqtt_ota_on_data(event)) break;
+#endif
+            handle_command(event);
+            break;
             
         case MQTT_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "MQTT Rozlaczono.");
+            xEventGroupClearBits(s_mqtt_event_group, MQTT_CONNECTED_BIT);
+            xQueueSend(s_ack_queue, &(mqtt_ack_t){ .msg_id = MQTT_ACK_ABORT }, 0);
             break;
 
         case MQTT_EVENT_PUBLISHED:
             ESP_LOGD(TAG, "Wiadomosc ID=%d opublikowana", event->msg_id);
-            xEventGroupSetBits(s_mqtt_event_group, MQTT_PUBLISHED_BIT);
+            xQueueSend(s_ack_queue, &(mqtt_ack_t){ event->msg_id, esp_timer_get_time() }, 0);
             break;
 
         case MQTT_EVENT_ERROR:
@@ -60,23 +206,40 @@ bool mqtt_app_start(void) {
     if (s_mqtt_event_group == NULL) {
         s_mqtt_event_group = xEventGroupCreate();
     }
-    xEventGroupClearBits(s_mqtt_event_group, MQTT_CONNECTED_BIT | MQTT_FAIL_BIT);
+    if (s_ack_queue == NULL) {
+        s_ack_queue = xQueueCreate(MQTT_INFLIGHT_WINDOW * 2, sizeof(mqtt_ack_t));
+    }
+    if (s_batch_topic[0] == '\0') {
+        build_batch_topic();
+    }
+    if (client != NULL) {
+        // Klient z poprzedniego cyklu - bez nowego handshake'u TLS
+        if (xEventGroupGetBits(s_mqtt_event_group) & MQTT_CONNECTED_BIT) {
+            ESP_LOGI(TAG, "MQTT: uzywam istniejacego polaczenia.");
+            s_last_connect_ms = 0;
+            return true;
+        }
+        ESP_LOGI(TAG, "MQTT: czekam na wznowienie polaczenia...");
+        xEventGroupClearBits(s_mqtt_event_group, MQTT_FAIL_BIT);
+    } else {
+        xEventGroupClearBits(s_mqtt_event_group, MQTT_CONNECTED_BIT | MQTT_FAIL_BIT);
 
-    esp_mqtt_client_config_t mqtt_cfg = {
-        .broker.address.uri = MQTT_BROKER_URI,
-        .broker.address.port = 8883,
-        .credentials.username = MQTT_USERNAME,
-        .credentials.authentication.password = MQTT_PASSWORD,
-        .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
-        .session.keepalive = 60,
-        .network.timeout_ms = 15000,
-    };
+        esp_mqtt_client_config_t mqtt_cfg = {
+            .broker.address.uri = MQTT_BROKER_URI,
+            .broker.address.port = 8883,
+            .credentials.username = MQTT_USERNAME,
+            .credentials.authentication.password = MQTT_PASSWORD,
+            .broker.verification.crt_bundle_attach = esp_crt_bundle_attach,
+            .session.keepalive = 60,
+            .network.timeout_ms = 15000,
+        };
 
-    client = esp_mqtt_client_init(&mqtt_cfg);
-    if (client == NULL) return false;
+        client = esp_mqtt_client_init(&mqtt_cfg);
+        if (client == NULL) return false;
 
-    esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
-    esp_mqtt_client_start(client);
+        esp_mqtt_client_register_event(client, ESP_EVENT_ANY_ID, mqtt_event_handler, NULL);
+        esp_mqtt_client_start(client);
+    }
 
     EventBits_t bits = xEventGroupWaitBits(s_mqtt_event_group, 
         MQTT_CONNECTED_BIT | MQTT_FAIL_BIT, 
@@ -92,54 +255,164 @@ bool mqtt_app_start(void) {
 }
 
 void mqtt_app_stop(void) {
+#if CONFIG_HIVE_OTA
+    mqtt_ota_on_disconnected();
+#endif
     if (client != NULL) {
+        // Ostatni pomiar stosu, póki task istnieje. s_mqtt_task zerujemy dopiero po destroy,
+        // żeby CONNECTED w trakcie zatrzymywania nie zarejestrował go ponownie.
+        if (s_mqtt_task != NULL) diag_unwatch_task(s_mqtt_task);
         esp_mqtt_client_stop(client);
         esp_mqtt_client_destroy(client);
         client = NULL;
+        s_mqtt_task = NULL;
     }
 }
 
-bool mqtt_send_sensor_data(SensorData data) {
-    if (client == NULL) return false;
-
-    const char *topic_config = CONFIG_HIVE_MQTT_TOPIC; 
-    
+// Jeden pomiar jako JSON na temat czujnika
+static int publish_json(const SensorData *data) {
     char dynamic_topic[128];
-    
-    char *last_slash = strrchr(topic_config, '/');
+    build_topic(data->sensor_id, dynamic_topic, sizeof(dynamic_topic));
 
-    if (last_slash != NULL) {
-        int prefix_len = last_slash - topic_config;
+    char payload[192];
+    mqtt_payload_format_json(data, payload, sizeof(payload));
 
-        snprintf(dynamic_topic, sizeof(dynamic_topic), "%.*s%d%s", 
-                 prefix_len, topic_config, data.sensor_id, last_slash);
-    } else {
-        snprintf(dynamic_topic, sizeof(dynamic_topic), "%s%d", topic_config, data.sensor_id);
+    int msg_id = esp_mqtt_client_publish(client, dynamic_topic, payload, 0, 1, 0);
+    if (msg_id >= 0) {
+        ESP_LOGD(TAG, "Wyslano na [%s]: %s (ID=%d)", dynamic_topic, payload, msg_id);
     }
+    return msg_id;
+}
 
-    char payload[128];
-    snprintf(payload, sizeof(payload), 
-             "{\"id\":%d, \"ts\":%lld, \"temp\":%.2f, \"press\":%lu}", 
-             data.sensor_id, data.timestamp, data.temp, (unsigned long)data.pressure);
-
-    xEventGroupClearBits(s_mqtt_event_group, MQTT_PUBLISHED_BIT);
+// Publikuje pomiary zaczynając od data[0]; w *consumed zwraca ile weszło do wiadomości.
+// Ujemny msg_id = wiadomość nie trafiła do kolejki (-1 błąd, -2 pełny outbox w IDF 5.x).
+static int publish_readings(const SensorData *data, size_t count, size_t *consumed) {
+#if CONFIG_HIVE_MQTT_BATCH_PAYLOAD
+    static uint8_t payload[MQTT_PAYLOAD_MAX_SIZE];
+    size_t len = mqtt_payload_encode_batch(data, count, payload, sizeof(payload), consumed);
+    if (len == 0) {
+        // Poza formatem paczki (np. sensor_id > 255) - ten pomiar idzie jako JSON
+        ESP_LOGW(TAG, "Pomiar czujnika %d poza formatem paczki - wysylka jako JSON", data[0].sensor_id);
+        *consumed = 1;
+        return publish_json(data);
+    }
 
-    int msg_id = esp_mqtt_client_publish(client, dynamic_topic, payload, 0, 1, 0);
-    
-    if (msg_id == -1) {
-        ESP_LOGE(TAG, "Blad kolejkowania wiadomosci");
-        return false;
+    int msg_id = esp_mqtt_client_publish(client, s_batch_topic, (const char *)payload, len, 1, 0);
+    if (msg_id >= 0) {
+        ESP_LOGD(TAG, "Paczka %zu pomiarow (%zu B) na [%s] (ID=%d)", *consumed, len, s_batch_topic, msg_id);
     }
+    return msg_id;
+#else
+    *consumed = 1;
+    return publish_json(data);
+#endif
+}
 
-    EventBits_t bits = xEventGroupWaitBits(s_mqtt_event_group, 
-        MQTT_PUBLISHED_BIT, 
-        pdTRUE, pdFALSE, pdMS_TO_TICKS(5000));
+// Okno wiadomości w locie: sloty [base, sent) indeksowane modulo MQTT_INFLIGHT_WINDOW.
+// Każda wiadomość niesie records[slot] pomiarów; acked_records to potwierdzony prefiks pomiarów.
+typedef struct {
+    int msg_id[MQTT_INFLIGHT_WINDOW];
+    int64_t sent_us[MQTT_INFLIGHT_WINDOW];
+    size_t records[MQTT_INFLIGHT_WINDOW];
+    bool acked[MQTT_INFLIGHT_WINDOW];
+    size_t base;
+    size_t sent;
+    size_t acked_records;
+} publish_window_t;
 
-    if (bits & MQTT_PUBLISHED_BIT) {
-        ESP_LOGI(TAG, "Wyslano na [%s]: %s", dynamic_topic, payload);
-        return true;
-    } else {
+static void retire_acked(publish_window_t *w) {
+    while (w->base < w->sent && w->acked[w->base % MQTT_INFLIGHT_WINDOW]) {
+        w->acked_records += w->records[w->base % MQTT_INFLIGHT_WINDOW];
+        w->base++;
+    }
+}
+
+// Czeka na jeden PUBACK i przesuwa potwierdzony prefiks. false = timeout lub rozłączenie.
+static bool wait_for_ack(publish_window_t *w) {
+    mqtt_ack_t ack;
+    if (xQueueReceive(s_ack_queue, &ack, pdMS_TO_TICKS(MQTT_ACK_TIMEOUT_MS)) != pdTRUE) {
         ESP_LOGE(TAG, "Timeout potwierdzenia wysylki");
         return false;
     }
+    if (ack.msg_id == MQTT_ACK_ABORT) {
+        ESP_LOGE(TAG, "Polaczenie zerwane w trakcie wysylki");
+        return false;
+    }
+
+    for (size_t i = w->base; i < w->sent; i++) {
+        size_t slot = i % MQTT_INFLIGHT_WINDOW;
+        if (w->msg_id[slot] == ack.msg_id) {
+            w->acked[slot] = true;
+            diag_rtt_add((uint32_t)(ack.at_us - w->sent_us[slot]));
+            break;
+        }
+    }
+
+    retire_acked(w);
+    return true;
+}
+
+size_t mqtt_send_sensor_batch(const SensorData *data, size_t count) {
+    if (client == NULL || count == 0) return 0;
+
+    // Spóźnione potwierdzenia z poprzednich wywołań nie dotyczą tej serii
+    xQueueReset(s_ack_queue);
+
+    publish_window_t w = { .base = 0, .sent = 0, .acked_records = 0 };
+    size_t next_record = 0;
+    bool failed = false;
+
+    while (next_record < count && !failed) {
+        if (w.sent - w.base >= MQTT_INFLIGHT_WINDOW) {
+            failed = !wait_for_ack(&w);
+            continue;
+        }
+
+        size_t consumed = 0;
+        int64_t sent_us = esp_timer_get_time();     // przed publikacją - PUBACK może wyprzedzić powrót
+        int msg_id = publish_readings(&data[next_record], count - next_record, &consumed);
+        if (msg_id < 0) {
+            ESP_LOGE(TAG, "Blad kolejkowania wiadomosci (%d)", msg_id);
+            failed = true;
+            break;
+        }
+
+        size_t slot = w.sent % MQTT_INFLIGHT_WINDOW;
+        w.msg_id[slot] = msg_id;
+        w.sent_us[slot] = sent_us;
+        w.records[slot] = consumed;
+        w.acked[slot] = false;
+        w.sent++;
+        next_record += consumed;
+        retire_acked(&w);
+    }
+
+    while (!failed && w.base < w.sent) {
+        failed = !wait_for_ack(&w);
+    }
+
+    ESP_LOGI(TAG, "Potwierdzono %zu/%zu pomiarow w %zu wiadomosciach (okno %d)",
+             w.acked_records, count, w.base, MQTT_INFLIGHT_WINDOW);
+    return w.acked_records;
+}
+
+uint32_t mqtt_last_connect_ms(void) {
+    return s_last_connect_ms;
+}
+
+bool mqtt_send_diag(void) {
+    if (client == NULL) return false;
+
+    uint8_t record[DIAG_RECORD_MAX_SIZE];
+    size_t len = diag_take_record(record, sizeof(record));
+    if (len == 0) return false;
+
+    // QoS 0 - zgubiony rekord diagnostyczny nie jest wart czekania na PUBACK
+    int msg_id = esp_mqtt_client_publish(client, s_diag_topic, (const char *)record, len, 0, 0);
+    ESP_LOGD(TAG, "Diagnostyka cyklu (%zu B) na [%s]", len, s_diag_topic);
+    return msg_id >= 0;
+}
+
+bool mqtt_send_sensor_data(SensorData data) {
+    return mqtt_send_sensor_batch(&data, 1) == 1;
 }
\ No newline at end of file
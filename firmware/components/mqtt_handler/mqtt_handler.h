@@ -2,15 +2,36 @@
 #define MQTT_HANDLER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "offline_buffer.h"
 
-// Inicjalizacja i połączenie z brokerem
+// Procedura polecenia z serwera; args - reszta treści po nazwie (bez spacji wiodącej)
+typedef void (*mqtt_command_handler_t)(const char *args);
+
+// Rejestruje polecenie odbierane na temacie "<prefiks>/cmd" (np. "resend 1700000000 1700003600").
+// Wywołać przed mqtt_app_start. Procedura działa w tasku esp-mqtt - ma tylko zapisać zlecenie.
+bool mqtt_register_command(const char *name, mqtt_command_handler_t handler);
+
+// Inicjalizacja i połączenie z brokerem.
+// Jeśli klient z poprzedniego cyklu nadal istnieje (CONFIG_HIVE_MQTT_PERSISTENT), jest używany ponownie.
 bool mqtt_app_start(void);
 
 // Rozłączenie i zwolnienie zasobów
 void mqtt_app_stop(void);
 
+// Czas ostatniego zestawienia połączenia (TCP + TLS + CONNACK) w ms; 0 = połączenie użyte ponownie
+uint32_t mqtt_last_connect_ms(void);
+
+// Wysyła rekord telemetrii cyklu (diag.h) na temat ".../diag" i zeruje liczniki
+bool mqtt_send_diag(void);
+
 // Funkcja do wysyłania pojedynczego pomiaru
 bool mqtt_send_sensor_data(SensorData data);
 
+// Wysyła serię pomiarów trzymając do CONFIG_HIVE_MQTT_INFLIGHT_WINDOW wiadomości QoS1 w locie.
+// Z CONFIG_HIVE_MQTT_BATCH_PAYLOAD pomiary pakowane są binarnie (mqtt_payload.h)
+// na temat ".../batch", w przeciwnym razie każdy idzie osobnym JSON-em.
+// Zwraca długość potwierdzonego prefiksu: pomiary [0, wynik) dostały PUBACK.
+size_t mqtt_send_sensor_batch(const SensorData *data, size_t count);
+
 #endif // MQTT_HANDLER_H
\ No newline at end of file
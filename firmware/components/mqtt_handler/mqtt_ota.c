@@ -0,0 +1,435 @@
+#include "mqtt_ota.h"
+#include "mqtt_handler.h"
+#include "storage_manager.h"
+#include "esp_ota_ops.h"
+#include "esp_app_desc.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/ecdsa.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "MQTT_OTA";
+
+#define OTA_NVS_NAMESPACE       "ota"
+#define OTA_NVS_KEY             "state"
+#define OTA_STATE_MAGIC         0x4F544131  // "OTA1"
+#define OTA_CHUNK_TIMEOUT_MS    10000
+#define OTA_CHUNK_RETRIES       3
+#define OTA_CHECKIN_TIMEOUT_US  ((uint64_t)CONFIG_HIVE_OTA_CHECKIN_TIMEOUT_S * 1000000ULL)
+#define OTA_NO_CHUNK            UINT32_MAX
+
+// Postęp transferu w NVS
+typedef struct {
+    uint32_t magic;
+    uint32_t size;
+    uint32_t offset;        // bajty zapisane na partycji (wielokrotność MQTT_OTA_CHUNK_SIZE)
+    uint32_t part_addr;     // partycja docelowa - po zmianie działającej partycji transfer od nowa
+    uint8_t sha256[32];
+    uint8_t signature[64];
+} ota_state_t;
+
+static ota_state_t s_state;
+static bool s_active = false;
+static SemaphoreHandle_t s_lock = NULL;     // trzymany przez mqtt_ota_process
+
+// Odbiór kawałka: task esp-mqtt składa fragmenty wiadomości w s_rx_buf, task wysyłki czeka na bit.
+// Jeden bufor na kawałek - zużycie RAM nie zależy od rozmiaru obrazu.
+static EventGroupHandle_t s_rx_events = NULL;
+#define OTA_RX_DONE_BIT         BIT0
+static uint8_t s_rx_buf[MQTT_OTA_CHUNK_SIZE];
+static volatile uint32_t s_rx_offset = OTA_NO_CHUNK;    // offset oczekiwanego kawałka
+static bool s_rx_accept = false;
+static size_t s_rx_len = 0;
+
+static esp_mqtt_client_handle_t s_client = NULL;
+static char s_req_topic[128];
+static char s_data_topic[128];
+static char s_status_topic[128];
+
+#if !CONFIG_HIVE_DEEP_SLEEP
+static esp_timer_handle_t s_checkin_timer = NULL;
+#endif
+
+static int hex_nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool hex_decode(const char *hex, size_t hex_len, uint8_t *out, size_t out_len) {
+    if (hex_len != out_len * 2) return false;
+    for (size_t i = 0; i < out_len; i++) {
+        int hi = hex_nibble(hex[2 * i]);
+        int lo = hex_nibble(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+static void save_state(void) {
+    storage_save_blob(OTA_NVS_NAMESPACE, OTA_NVS_KEY, &s_state, sizeof(s_state));
+}
+
+static void clear_state(void) {
+    s_active = false;
+    memset(&s_state, 0, sizeof(s_state));
+    storage_erase_key(OTA_NVS_NAMESPACE, OTA_NVS_KEY);
+}
+
+// Status dla serwera; enqueue nie blokuje, więc można wołać także z tasku esp-mqtt
+static void publish_status(const char *status) {
+    if (s_client != NULL) {
+        esp_mqtt_client_enqueue(s_client, s_status_topic, status, 0, 1, 0, true);
+    }
+}
+
+static void ota_fail(const char *reason) {
+    ESP_LOGE(TAG, "OTA nieudane: %s - transfer anulowany", reason);
+    char status[48];
+    snprintf(status, sizeof(status), "error %s", reason);
+    publish_status(status);
+    clear_state();
+}
+
+// SHA-256 tego, co faktycznie jest na flashu (bufor kawałka wykorzystany ponownie)
+static bool partition_sha256(const esp_partition_t *part, size_t size, uint8_t hash[32]) {
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    bool ok = mbedtls_sha256_starts(&ctx, 0) == 0;
+
+    for (size_t pos = 0; ok && pos < size; pos += sizeof(s_rx_buf)) {
+        size_t n = (size - pos < sizeof(s_rx_buf)) ? size - pos : sizeof(s_rx_buf);
+        ok = esp_partition_read(part, pos, s_rx_buf, n) == ESP_OK &&
+             mbedtls_sha256_update(&ctx, s_rx_buf, n) == 0;
+    }
+    ok = ok && mbedtls_sha256_finish(&ctx, hash) == 0;
+    mbedtls_sha256_free(&ctx);
+    return ok;
+}
+
+// "ota <rozmiar> <sha256 hex> <podpis hex>" / "ota abort"
+static void ota_command(const char *args) {
+    if (xSemaphoreTake(s_lock, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Transfer w toku - polecenie pominiete");
+        return;
+    }
+
+    if (strcmp(args, "abort") == 0) {
+        ESP_LOGW(TAG, "OTA przerwane przez serwer");
+        clear_state();
+        xSemaphoreGive(s_lock);
+        return;
+    }
+
+    char *p;
+    unsigned long size = strtoul(args, &p, 10);
+    while (*p == ' ') p++;
+    const char *sha_hex = p;
+    const char *sig_hex = strchr(sha_hex, ' ');
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+
+    ota_state_t req = { .magic = OTA_STATE_MAGIC, .size = (uint32_t)size };
+    if (sig_hex == NULL || part == NULL || size == 0 || size > part->size ||
+        !hex_decode(sha_hex, sig_hex - sha_hex, req.sha256, sizeof(req.sha256)) ||
+        !hex_decode(sig_hex + 1, strlen(sig_hex + 1), req.signature, sizeof(req.signature))) {
+        ESP_LOGE(TAG, "Bledne polecenie ota");
+        xSemaphoreGive(s_lock);
+        return;
+    }
+
+    // Polecenie z obrazem, na którym już działamy (np. powtórzone po restarcie do nowego firmware).
+    // Liczymy skrót tylko przy nowym obrazie - przy wznowieniu s_state go potwierdza.
+    bool resume = s_active && s_state.size == req.size &&
+                  memcmp(s_state.sha256, req.sha256, sizeof(req.sha256)) == 0;
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    uint8_t running_sha[32];
+    if (!resume && running != NULL && size <= running->size && partition_sha256(running, size, running_sha) &&
+        memcmp(running_sha, req.sha256, sizeof(running_sha)) == 0) {
+        ESP_LOGI(TAG, "OTA: obraz jest juz uruchomiony (%s) - pomijam", esp_app_get_description()->version);
+        if (s_active) clear_state();
+        char status[48];
+        snprintf(status, sizeof(status), "ok %s", esp_app_get_description()->version);
+        publish_status(status);
+        xSemaphoreGive(s_lock);
+        return;
+    }
+
+    if (resume) {
+        // Ten sam obraz - zachowujemy postęp
+        ESP_LOGI(TAG, "OTA: wznowienie od %lu/%lu B", (unsigned long)s_state.offset, (unsigned long)s_state.size);
+    } else {
+        req.part_addr = part->address;
+        s_state = req;
+        s_active = true;
+        save_state();
+        ESP_LOGW(TAG, "OTA: nowy obraz %lu B -> %s", size, part->label);
+    }
+    xSemaphoreGive(s_lock);
+}
+
+#if !CONFIG_HIVE_DEEP_SLEEP
+static void checkin_timeout(void *arg) {
+    (void)arg;
+    ESP_LOGE(TAG, "Nowy firmware nie polaczyl sie z serwerem - powrot do poprzedniego");
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+}
+#endif
+
+void mqtt_ota_init(void) {
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        s_rx_events = xEventGroupCreate();
+    }
+
+    if (storage_load_blob(OTA_NVS_NAMESPACE, OTA_NVS_KEY, &s_state, sizeof(s_state)) == ESP_OK &&
+        s_state.magic == OTA_STATE_MAGIC) {
+        s_active = true;
+        ESP_LOGI(TAG, "Przerwany transfer OTA: %lu/%lu B", (unsigned long)s_state.offset,
+                 (unsigned long)s_state.size);
+    }
+    mqtt_register_command("ota", ota_command);
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGW(TAG, "Pierwszy start nowego firmware - czekam na polaczenie z serwerem");
+#if !CONFIG_HIVE_DEEP_SLEEP
+        // W deep sleep timer nie jest potrzebny: niepotwierdzony obraz wycofa bootloader
+        // przy następnym wybudzeniu
+        const esp_timer_create_args_t args = { .callback = checkin_timeout, .name = "ota_checkin" };
+        if (esp_timer_create(&args, &s_checkin_timer) == ESP_OK) {
+            esp_timer_start_once(s_checkin_timer, OTA_CHECKIN_TIMEOUT_US);
+        }
+#endif
+    }
+}
+
+bool mqtt_ota_active(void) {
+    return s_active;
+}
+
+void mqtt_ota_on_connected(esp_mqtt_client_handle_t client, const char *topic_prefix, int prefix_len) {
+    s_client = client;
+    snprintf(s_req_topic, sizeof(s_req_topic), "%.*s/ota/req", prefix_len, topic_prefix);
+    snprintf(s_data_topic, sizeof(s_data_topic), "%.*s/ota/data", prefix_len, topic_prefix);
+    snprintf(s_status_topic, sizeof(s_status_topic), "%.*s/ota/status", prefix_len, topic_prefix);
+    esp_mqtt_client_subscribe(client, s_data_topic, 1);
+
+    // Zgłoszenie nowego obrazu: połączenie z brokerem działa, więc zostajemy na nim
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(running, &state) == ESP_OK && state == ESP_OTA_IMG_PENDING_VERIFY) {
+        esp_ota_mark_app_valid_cancel_rollback();
+#if !CONFIG_HIVE_DEEP_SLEEP
+        if (s_checkin_timer != NULL) esp_timer_stop(s_checkin_timer);
+#endif
+        char status[48];
+        snprintf(status, sizeof(status), "ok %s", esp_app_get_description()->version);
+        publish_status(status);
+        ESP_LOGI(TAG, "Nowy firmware potwierdzony (%s)", esp_app_get_description()->version);
+    }
+}
+
+void mqtt_ota_on_disconnected(void) {
+    s_client = NULL;
+}
+
+bool mqtt_ota_on_data(esp_mqtt_event_handle_t event) {
+    if (event->topic_len > 0 && (event->topic_len != (int)strlen(s_data_topic) ||
+                                 strncmp(event->topic, s_data_topic, event->topic_len) != 0)) {
+        return false;
+    }
+    // Kolejne fragmenty długiej wiadomości przychodzą bez tematu
+    if (event->topic_len == 0 && !s_rx_accept) return false;
+
+    const uint8_t *data = (const uint8_t *)event->data;
+    size_t start = event->current_data_offset;
+    size_t len = event->data_len;
+
+    if (start == 0) {
+        s_rx_accept = false;
+        if (len < 4 || event->total_data_len - 4 > MQTT_OTA_CHUNK_SIZE) return true;
+
+        uint32_t offset = (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                          ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+        if (offset != s_rx_offset) return true;    // spóźniony albo nie nasz kawałek
+
+        s_rx_accept = true;
+        s_rx_len = event->total_data_len - 4;
+        data += 4;
+        len -= 4;
+        start = 4;
+    }
+    if (!s_rx_accept) return true;
+
+    memcpy(&s_rx_buf[start - 4], data, len);
+    if (start + len == (size_t)event->total_data_len) {
+        s_rx_accept = false;
+        s_rx_offset = OTA_NO_CHUNK;
+        xEventGroupSetBits(s_rx_events, OTA_RX_DONE_BIT);
+    }
+    return true;
+}
+
+// Prosi serwer o kawałek i czeka na niego
+static bool fetch_chunk(uint32_t offset, size_t len) {
+    char req[32];
+    snprintf(req, sizeof(req), "%lu %u", (unsigned long)offset, (unsigned)len);
+
+    xEventGroupClearBits(s_rx_events, OTA_RX_DONE_BIT);
+    s_rx_offset = offset;
+    if (s_client == NULL || esp_mqtt_client_publish(s_client, s_req_topic, req, 0, 0, 0) < 0) {
+        s_rx_offset = OTA_NO_CHUNK;
+        return false;
+    }
+
+    EventBits_t bits = xEventGroupWaitBits(s_rx_events, OTA_RX_DONE_BIT, pdTRUE, pdTRUE,
+                                           pdMS_TO_TICKS(OTA_CHUNK_TIMEOUT_MS));
+    s_rx_offset = OTA_NO_CHUNK;
+    if (!(bits & OTA_RX_DONE_BIT)) {
+        ESP_LOGW(TAG, "Brak kawalka %lu", (unsigned long)offset);
+        return false;
+    }
+    if (s_rx_len != len) {
+        ESP_LOGW(TAG, "Kawalek %lu: %zu B zamiast %zu", (unsigned long)offset, s_rx_len, len);
+        return false;
+    }
+    return true;
+}
+
+static bool verify_signature(const uint8_t hash[32], const uint8_t sig[64]) {
+    uint8_t pub[65];
+    const char *key_hex = CONFIG_HIVE_OTA_PUBLIC_KEY;
+    if (!hex_decode(key_hex, strlen(key_hex), pub, sizeof(pub))) {
+        ESP_LOGE(TAG, "Brak poprawnego klucza publicznego OTA w konfiguracji");
+        return false;
+    }
+
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point q;
+    mbedtls_mpi r, s;
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&q);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    bool ok = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) == 0 &&
+              mbedtls_ecp_point_read_binary(&grp, &q, pub, sizeof(pub)) == 0 &&
+              mbedtls_mpi_read_binary(&r, sig, 32) == 0 &&
+              mbedtls_mpi_read_binary(&s, sig + 32, 32) == 0 &&
+              mbedtls_ecdsa_verify(&grp, hash, 32, &q, &r, &s) == 0;
+
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&q);
+    mbedtls_ecp_group_free(&grp);
+    return ok;
+}
+
+static void finish_update(esp_ota_handle_t handle, const esp_partition_t *part) {
+    // esp_ota_end sprawdza strukturę obrazu (nagłówek, segmenty, suma kontrolna)
+    if (esp_ota_end(handle) != ESP_OK) {
+        ota_fail("image");
+        return;
+    }
+
+    uint8_t hash[32];
+    if (!partition_sha256(part, s_state.size, hash) || memcmp(hash, s_state.sha256, sizeof(hash)) != 0) {
+        ota_fail("sha256");
+        return;
+    }
+    if (!verify_signature(hash, s_state.signature)) {
+        ota_fail("signature");
+        return;
+    }
+    if (esp_ota_set_boot_partition(part) != ESP_OK) {
+        ota_fail("boot");
+        return;
+    }
+
+    clear_state();
+    publish_status("done");
+    ESP_LOGW(TAG, "OTA zakonczone - restart do nowego firmware");
+    vTaskDelay(pdMS_TO_TICKS(1000));    // status zdąży wyjść
+    esp_restart();
+}
+
+void mqtt_ota_process(uint32_t budget_ms) {
+    if (!s_active || s_client == NULL) return;
+    if (xSemaphoreTake(s_lock, 0) != pdTRUE) return;
+
+    const esp_partition_t *part = esp_ota_get_next_update_partition(NULL);
+    if (part == NULL) {
+        ota_fail("partition");
+        xSemaphoreGive(s_lock);
+        return;
+    }
+    if (part->address != s_state.part_addr) {
+        ESP_LOGW(TAG, "Zmienila sie partycja docelowa - transfer od poczatku");
+        s_state.part_addr = part->address;
+        s_state.offset = 0;
+        save_state();
+    }
+
+    // Wznowienie od granicy sektora: esp_ota_write przy zapisie sekwencyjnym kasuje sektor,
+    // więc kawałek zapisany przed przerwą (ale niezatwierdzony w NVS) zapisze się poprawnie
+    esp_ota_handle_t handle;
+    esp_err_t err = (s_state.offset == 0) ?
+                    esp_ota_begin(part, OTA_WITH_SEQUENTIAL_WRITES, &handle) :
+                    esp_ota_resume(part, OTA_WITH_SEQUENTIAL_WRITES, s_state.offset, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Start zapisu OTA nieudany: %s", esp_err_to_name(err));
+        ota_fail("begin");
+        xSemaphoreGive(s_lock);
+        return;
+    }
+
+    ESP_LOGI(TAG, "OTA: %lu/%lu B", (unsigned long)s_state.offset, (unsigned long)s_state.size);
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)budget_ms * 1000;
+    int retries = 0;
+
+    while (s_state.offset < s_state.size && retries <= OTA_CHUNK_RETRIES &&
+           esp_timer_get_time() < deadline_us) {
+        size_t len = s_state.size - s_state.offset;
+        if (len > MQTT_OTA_CHUNK_SIZE) len = MQTT_OTA_CHUNK_SIZE;
+
+        if (!fetch_chunk(s_state.offset, len)) {
+            retries++;
+            continue;
+        }
+        retries = 0;
+
+        err = esp_ota_write(handle, s_rx_buf, len);
+        if (err != ESP_OK) break;
+
+        s_state.offset += len;
+        save_state();
+        if ((s_state.offset / MQTT_OTA_CHUNK_SIZE) % 64 == 0) {
+            ESP_LOGI(TAG, "OTA: %lu/%lu B", (unsigned long)s_state.offset, (unsigned long)s_state.size);
+        }
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Zapis OTA nieudany: %s", esp_err_to_name(err));
+        esp_ota_abort(handle);
+        ota_fail("write");
+    } else if (s_state.offset < s_state.size) {
+        // Zapisane dane zostają na partycji - kolejny cykl wznowi od s_state.offset
+        esp_ota_abort(handle);
+        ESP_LOGI(TAG, "OTA wstrzymane na %lu/%lu B", (unsigned long)s_state.offset, (unsigned long)s_state.size);
+    } else {
+        finish_update(handle, part);
+    }
+    xSemaphoreGive(s_lock);
+}
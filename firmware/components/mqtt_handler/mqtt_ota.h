@@ -0,0 +1,38 @@
+#ifndef MQTT_OTA_H
+#define MQTT_OTA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mqtt_client.h"
+
+// Aktualizacja firmware przez MQTT, kawałkami po MQTT_OTA_CHUNK_SIZE.
+//
+//   serwer -> <prefiks>/cmd       "ota <rozmiar> <sha256 hex> <podpis hex>" albo "ota abort"
+//   ESP    -> <prefiks>/ota/req   "<offset> <długość>"      (prośba o kawałek)
+//   serwer -> <prefiks>/ota/data  u32 offset (LE) | dane
+//   ESP    -> <prefiks>/ota/status "done", "ok <wersja>", "error <powód>"
+//
+// Podpis: ECDSA P-256 (r || s, 64 B) nad SHA-256 obrazu, klucz publiczny z Kconfig.
+// Kawałki zapisywane są od razu do nieaktywnej partycji OTA, postęp w NVS - przerwany
+// transfer wznawia się od ostatniego zapisanego kawałka. Nowy obraz musi się zgłosić
+// (połączenie z MQTT), inaczej bootloader wraca do poprzedniego.
+
+#define MQTT_OTA_CHUNK_SIZE     4096    // = sektor flasha: wznowienie zaczyna się od skasowania sektora
+
+// Wczytuje stan transferu z NVS, rejestruje polecenie "ota", w trybie ciągłym uzbraja
+// timer wycofania niepotwierdzonego obrazu. Wywołać przed mqtt_app_start.
+void mqtt_ota_init(void);
+
+// Czy jest rozpoczęty transfer (także przerwany w poprzednim cyklu)
+bool mqtt_ota_active(void);
+
+// Pobiera kolejne kawałki przez najwyżej budget_ms. Woła task wysyłki (nie task esp-mqtt).
+// Po kompletnym i poprawnie podpisanym obrazie ustawia partycję startową i restartuje.
+void mqtt_ota_process(uint32_t budget_ms);
+
+// Wywołania z mqtt_handler.c (task esp-mqtt)
+void mqtt_ota_on_connected(esp_mqtt_client_handle_t client, const char *topic_prefix, int prefix_len);
+void mqtt_ota_on_disconnected(void);
+bool mqtt_ota_on_data(esp_mqtt_event_handle_t event);
+
+#endif // MQTT_OTA_H
@@ -0,0 +1,126 @@
+#include "mqtt_payload.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <math.h>
+
+static inline void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static int16_t temp_to_centi(float temp) {
+    float scaled = roundf(temp * 100.0f);
+    if (scaled > INT16_MAX) return INT16_MAX;
+    if (scaled < INT16_MIN) return INT16_MIN;
+    return (int16_t)scaled;
+}
+
+size_t mqtt_payload_encode_batch(const SensorData *data, size_t count,
+                                 uint8_t *buf, size_t buf_len, size_t *consumed) {
+    *consumed = 0;
+    if (count == 0 || buf_len < MQTT_PAYLOAD_HEADER_SIZE + MQTT_PAYLOAD_RECORD_SIZE) return 0;
+
+    // 1. Ile pomiarów mieści się w oknie czasu i w limicie rekordów
+    int64_t base_ts = data[0].timestamp;
+    bool aggregate = data[0].count > 0;
+    uint32_t base_seq = data[0].seq;
+    bool with_seq = base_seq != 0;
+    uint32_t epoch = data[0].seq_epoch;
+    bool with_epoch = with_seq && epoch != 0;
+    size_t header_size = MQTT_PAYLOAD_HEADER_SIZE + (with_seq ? MQTT_PAYLOAD_SEQ_HEADER_SIZE : 0) +
+                         (with_epoch ? MQTT_PAYLOAD_EPOCH_SIZE : 0);
+    bool with_pressure = false;
+    size_t n = 0;
+
+    while (n < count && n < MQTT_PAYLOAD_MAX_RECORDS) {
+        int64_t dt = data[n].timestamp - base_ts;
+        if (dt < 0 || dt > UINT16_MAX || data[n].sensor_id < 0 || data[n].sensor_id > UINT8_MAX) break;
+        if ((data[n].count > 0) != aggregate) break;    // agregaty idą osobną wiadomością
+        if ((data[n].seq != 0) != with_seq || data[n].seq - base_seq > UINT16_MAX) break;
+        if (data[n].seq_epoch != epoch) break;          // jedna epoka na wiadomość
+
+        bool pressure = with_pressure || data[n].pressure != 0;
+        size_t record_size = MQTT_PAYLOAD_RECORD_SIZE + (pressure ? 4 : 0) +
+                             (aggregate ? MQTT_PAYLOAD_AGGREGATE_SIZE : 0) +
+                             (with_seq ? MQTT_PAYLOAD_SEQ_SIZE : 0);
+        if (header_size + (n + 1) * record_size > buf_len) break;
+
+        with_pressure = pressure;
+        n++;
+    }
+
+    if (n == 0) {
+        // Pomiar nie do zakodowania (np. zły sensor_id) - wołający wysyła go inaczej (JSON)
+        *consumed = 1;
+        return 0;
+    }
+
+    // 2. Nagłówek i rekordy
+    buf[0] = MQTT_PAYLOAD_VERSION;
+    buf[1] = (with_pressure ? MQTT_PAYLOAD_FLAG_PRESSURE : 0) |
+             (aggregate ? MQTT_PAYLOAD_FLAG_AGGREGATE : 0) |
+             (with_seq ? MQTT_PAYLOAD_FLAG_SEQ : 0) |
+             (with_epoch ? MQTT_PAYLOAD_FLAG_EPOCH : 0);
+    put_u16(&buf[2], (uint16_t)n);
+    put_u32(&buf[4], (uint32_t)base_ts);
+    if (with_seq) {
+        put_u32(&buf[MQTT_PAYLOAD_HEADER_SIZE], base_seq);
+    }
+    if (with_epoch) {
+        put_u32(&buf[MQTT_PAYLOAD_HEADER_SIZE + MQTT_PAYLOAD_SEQ_HEADER_SIZE], epoch);
+    }
+
+    uint8_t *p = buf + header_size;
+    for (size_t i = 0; i < n; i++) {
+        p[0] = (uint8_t)data[i].sensor_id;
+        put_u16(&p[1], (uint16_t)(data[i].timestamp - base_ts));
+        put_u16(&p[3], (uint16_t)temp_to_centi(data[i].temp));
+        p += MQTT_PAYLOAD_RECORD_SIZE;
+        if (with_pressure) {
+            put_u32(p, data[i].pressure);
+            p += 4;
+        }
+        if (aggregate) {
+            put_u16(&p[0], (uint16_t)temp_to_centi(data[i].temp_min));
+            put_u16(&p[2], (uint16_t)temp_to_centi(data[i].temp_max));
+            put_u16(&p[4], data[i].count);
+            put_u16(&p[6], data[i].peak_dt);
+            p += MQTT_PAYLOAD_AGGREGATE_SIZE;
+        }
+        if (with_seq) {
+            put_u16(p, (uint16_t)(data[i].seq - base_seq));
+            p += MQTT_PAYLOAD_SEQ_SIZE;
+        }
+    }
+
+    *consumed = n;
+    return p - buf;
+}
+
+int mqtt_payload_format_json(const SensorData *data, char *buf, size_t buf_len) {
+    int len = snprintf(buf, buf_len,
+                       "{\"id\":%d, \"ts\":%" PRId64 ", \"temp\":%.2f, \"press\":%lu",
+                       data->sensor_id, data->timestamp, data->temp, (unsigned long)data->pressure);
+    if (data->seq != 0 && len < (int)buf_len) {
+        len += snprintf(buf + len, buf_len - len, ", \"seq\":%lu", (unsigned long)data->seq);
+    }
+    if (data->seq != 0 && data->seq_epoch != 0 && len < (int)buf_len) {
+        len += snprintf(buf + len, buf_len - len, ", \"epoch\":%lu", (unsigned long)data->seq_epoch);
+    }
+    if (data->count > 0 && len < (int)buf_len) {
+        len += snprintf(buf + len, buf_len - len,
+                        ", \"min\":%.2f, \"max\":%.2f, \"n\":%u, \"peak\":%" PRId64,
+                        data->temp_min, data->temp_max, data->count, data->timestamp + data->peak_dt);
+    }
+    if (len < (int)buf_len) {
+        len += snprintf(buf + len, buf_len - len, "}");
+    }
+    return len;
+}
@@ -0,0 +1,49 @@
+#ifndef MQTT_PAYLOAD_H
+#define MQTT_PAYLOAD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "offline_buffer.h"
+
+// Binarny format paczki pomiarów (little-endian), wersja 1:
+//
+//   nagłówek (8 B):  u8 version | u8 flags | u16 count | u32 base_ts
+//                    [+ u32 base_seq, jeśli flags & MQTT_PAYLOAD_FLAG_SEQ]
+//                    [+ u32 epoch (SensorData.seq_epoch, wspólna dla paczki),
+//                     jeśli flags & MQTT_PAYLOAD_FLAG_EPOCH]
+//   rekord   (5 B):  u8 sensor_id | u16 dt (s od base_ts) | i16 temp (0.01 C)
+//                    [+ u32 pressure, jeśli flags & MQTT_PAYLOAD_FLAG_PRESSURE]
+//                    [+ i16 min | i16 max (0.01 C) | u16 count | u16 peak_dt,
+//                       jeśli flags & MQTT_PAYLOAD_FLAG_AGGREGATE; temp = średnia z okna]
+//                    [+ u16 dseq (seq = base_seq + dseq), jeśli flags & MQTT_PAYLOAD_FLAG_SEQ]
+//
+// Wiadomość zawiera albo same zwykłe pomiary, albo same agregaty (aggregator.h).
+// Jedna wiadomość mieści pomiary z okna 65535 s od pierwszego z nich.
+
+#define MQTT_PAYLOAD_VERSION          1
+#define MQTT_PAYLOAD_FLAG_PRESSURE    0x01
+#define MQTT_PAYLOAD_FLAG_AGGREGATE   0x02
+#define MQTT_PAYLOAD_FLAG_SEQ         0x04
+#define MQTT_PAYLOAD_FLAG_EPOCH       0x08
+
+#define MQTT_PAYLOAD_HEADER_SIZE      8
+#define MQTT_PAYLOAD_RECORD_SIZE      5
+#define MQTT_PAYLOAD_AGGREGATE_SIZE   8
+#define MQTT_PAYLOAD_SEQ_HEADER_SIZE  4
+#define MQTT_PAYLOAD_EPOCH_SIZE       4
+#define MQTT_PAYLOAD_SEQ_SIZE         2
+#define MQTT_PAYLOAD_MAX_RECORDS      64
+#define MQTT_PAYLOAD_MAX_SIZE         (MQTT_PAYLOAD_HEADER_SIZE + MQTT_PAYLOAD_SEQ_HEADER_SIZE + \
+                                       MQTT_PAYLOAD_EPOCH_SIZE + \
+                                       MQTT_PAYLOAD_MAX_RECORDS * (MQTT_PAYLOAD_RECORD_SIZE + 4 + \
+                                       MQTT_PAYLOAD_AGGREGATE_SIZE + MQTT_PAYLOAD_SEQ_SIZE))
+
+// Koduje początek data[] do buf. Zwraca długość wiadomości, w *consumed liczbę pomiarów,
+// które się zmieściły. 0 z *consumed = 1: data[0] jest poza formatem paczki.
+size_t mqtt_payload_encode_batch(const SensorData *data, size_t count,
+                                 uint8_t *buf, size_t buf_len, size_t *consumed);
+
+// Pojedynczy pomiar jako JSON (stary format, temat per czujnik)
+int mqtt_payload_format_json(const SensorData *data, char *buf, size_t buf_len);
+
+#endif // MQTT_PAYLOAD_H
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "block_codec.h"
+#include <math.h>
+
+// BLOCK_MAX_RECORD_SIZE liczy pola count i peak_dt jako 16-bitowe, resztę jako 32-bitowe
+_Static_assert(sizeof(((SensorData *)0)->count) == 2 && sizeof(((SensorData *)0)->peak_dt) == 2,
+               "count/peak_dt szersze niz 16 bitow - popraw BLOCK_MAX_RECORD_SIZE");
+_Static_assert(sizeof(((SensorData *)0)->sensor_id) <= 4 && sizeof(((SensorData *)0)->pressure) <= 4 &&
+               sizeof(((SensorData *)0)->seq) <= 4,
+               "pole rekordu szersze niz 32 bity - popraw BLOCK_MAX_RECORD_SIZE");
+_Static_assert(BLOCK_MAX_RECORD_SIZE == 7 * 5 + 2 * 3, "BLOCK_MAX_RECORD_SIZE niezgodny z polami rekordu");
+
+static size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool get_varint(const uint8_t *buf, size_t len, size_t *pos, uint32_t *out) {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35 && *pos < len; shift += 7) {
+        uint8_t b = buf[(*pos)++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+// Początek rekordów: za nagłówkiem i opcjonalną epoką
+static inline size_t records_start(const uint8_t *buf) {
+    return BLOCK_HEADER_SIZE + ((buf[1] & BLOCK_FLAG_EPOCH) ? BLOCK_EPOCH_SIZE : 0);
+}
+
+static inline int32_t temp_to_q4(float temp) {
+    return (int32_t)lroundf(temp * 16.0f);
+}
+
+size_t block_encode(const SensorData *data, size_t count, uint8_t *buf, size_t buf_len, size_t *consumed) {
+    *consumed = 0;
+    if (count == 0 || buf_len < BLOCK_MAX_HEADER_SIZE + BLOCK_MAX_RECORD_SIZE) return 0;
+
+    size_t limit = (count < BLOCK_MAX_RECORDS) ? count : BLOCK_MAX_RECORDS;
+    bool aggregate = data[0].count > 0;
+    bool with_pressure = false;
+    bool with_seq = false;
+    uint32_t epoch = data[0].seq_epoch;
+    for (size_t i = 0; i < limit; i++) {
+        if ((data[i].count > 0) != aggregate || data[i].seq_epoch != epoch) {
+            limit = i;  // zmiana rodzaju rekordu lub epoki - nowy blok
+            break;
+        }
+        if (data[i].pressure != 0) with_pressure = true;
+        if (data[i].seq != 0) with_seq = true;
+    }
+
+    bool with_epoch = with_seq && epoch != 0;
+    buf[1] = (with_pressure ? BLOCK_FLAG_PRESSURE : 0) | (aggregate ? BLOCK_FLAG_AGGREGATE : 0) |
+             (with_seq ? BLOCK_FLAG_SEQ : 0) | (with_epoch ? BLOCK_FLAG_EPOCH : 0);
+    put_u32(&buf[2], (uint32_t)data[0].timestamp);
+    if (with_epoch) {
+        put_u32(&buf[BLOCK_HEADER_SIZE], epoch);
+    }
+
+    size_t pos = records_start(buf);
+    int64_t prev_ts = data[0].timestamp;
+    int32_t prev_q = 0;
+    uint32_t prev_seq = 0;
+    size_t n = 0;
+
+    while (n < limit && pos + BLOCK_MAX_RECORD_SIZE <= buf_len) {
+        const SensorData *d = &data[n];
+        int64_t dt = d->timestamp - prev_ts;
+        if (dt < 0 || dt > UINT32_MAX) break;   // czas się cofnął - nowy blok
+
+        int32_t q = temp_to_q4(d->temp);
+        pos += put_varint(&buf[pos], zigzag(d->sensor_id));
+        pos += put_varint(&buf[pos], (uint32_t)dt);
+        pos += put_varint(&buf[pos], zigzag(q - prev_q));
+        if (with_pressure) {
+            pos += put_varint(&buf[pos], d->pressure);
+        }
+        if (with_seq) {
+            pos += put_varint(&buf[pos], zigzag((int32_t)(d->seq - prev_seq)));
+            prev_seq = d->seq;
+        }
+        if (aggregate) {
+            pos += put_varint(&buf[pos], zigzag(temp_to_q4(d->temp_min) - q));
+            pos += put_varint(&buf[pos], zigzag(temp_to_q4(d->temp_max) - q));
+            pos += put_varint(&buf[pos], d->count);
+            pos += put_varint(&buf[pos], d->peak_dt);
+        }
+
+        prev_ts = d->timestamp;
+        prev_q = q;
+        n++;
+    }
+
+    buf[0] = (uint8_t)n;
+    *consumed = n;
+    return pos;
+}
+
+size_t block_record_count(const uint8_t *buf, size_t len) {
+    if (len < BLOCK_HEADER_SIZE || buf[0] == 0 || buf[0] > BLOCK_MAX_RECORDS || len < records_start(buf)) return 0;
+    return buf[0];
+}
+
+bool block_time_range(const uint8_t *buf, size_t len, int64_t *first, int64_t *last) {
+    size_t count = block_record_count(buf, len);
+    if (count == 0) return false;
+
+    // Pola rekordu po dt: dT, [pressure], [dSeq], [4 pola agregatu]
+    size_t skip = 1 + ((buf[1] & BLOCK_FLAG_PRESSURE) ? 1 : 0) + ((buf[1] & BLOCK_FLAG_SEQ) ? 1 : 0) +
+                  ((buf[1] & BLOCK_FLAG_AGGREGATE) ? 4 : 0);
+    int64_t ts = (int64_t)get_u32(&buf[2]);
+    size_t pos = records_start(buf);
+    uint32_t v;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!get_varint(buf, len, &pos, &v) || !get_varint(buf, len, &pos, &v)) return false;
+        ts += v;
+        if (i == 0) *first = ts;
+        for (size_t f = 0; f < skip; f++) {
+            if (!get_varint(buf, len, &pos, &v)) return false;
+        }
+    }
+
+    *last = ts;
+    return true;
+}
+
+size_t block_decode(const uint8_t *buf, size_t len, SensorData *out, size_t max) {
+    size_t count = block_record_count(buf, len);
+    if (count == 0 || count > max) return 0;
+
+    bool with_pressure = buf[1] & BLOCK_FLAG_PRESSURE;
+    bool aggregate = buf[1] & BLOCK_FLAG_AGGREGATE;
+    bool with_seq = buf[1] & BLOCK_FLAG_SEQ;
+    uint32_t epoch = (buf[1] & BLOCK_FLAG_EPOCH) ? get_u32(&buf[BLOCK_HEADER_SIZE]) : 0;
+    uint32_t seq = 0;
+    int64_t ts = (int64_t)get_u32(&buf[2]);
+    int32_t q = 0;
+    size_t pos = records_start(buf);
+
+    for (size_t i = 0; i < count; i++) {
+        uint32_t id, dt, dq, pressure = 0;
+        if (!get_varint(buf, len, &pos, &id) ||
+            !get_varint(buf, len, &pos, &dt) ||
+            !get_varint(buf, len, &pos, &dq) ||
+            (with_pressure && !get_varint(buf, len, &pos, &pressure))) {
+            return 0;
+        }
+
+        uint32_t dseq = 0;
+        if (with_seq && !get_varint(buf, len, &pos, &dseq)) {
+            return 0;
+        }
+        seq += (uint32_t)unzigzag(dseq);
+
+        ts += dt;
+        q += unzigzag(dq);
+
+        out[i] = (SensorData){
+            .timestamp = ts,
+            .temp = q / 16.0f,
+            .pressure = pressure,
+            .sensor_id = unzigzag(id),
+            .seq = with_seq ? seq : 0,
+            .seq_epoch = with_seq ? epoch : 0,
+        };
+
+        if (aggregate) {
+            uint32_t dmin, dmax, samples, peak_dt;
+            if (!get_varint(buf, len, &pos, &dmin) ||
+                !get_varint(buf, len, &pos, &dmax) ||
+                !get_varint(buf, len, &pos, &samples) ||
+                !get_varint(buf, len, &pos, &peak_dt) ||
+                samples == 0 || samples > UINT16_MAX || peak_dt > UINT16_MAX) {
+                return 0;
+            }
+            out[i].temp_min = (q + unzigzag(dmin)) / 16.0f;
+            out[i].temp_max = (q + unzigzag(dmax)) / 16.0f;
+            out[i].count = (uint16_t)samples;
+            out[i].peak_dt = (uint16_t)peak_dt;
+        }
+    }
+
+    return (pos == len) ? count : 0;
+}
\ No newline at end of file
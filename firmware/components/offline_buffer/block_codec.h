@@ -0,0 +1,56 @@
+#ifndef BLOCK_CODEC_H
+#define BLOCK_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "offline_buffer.h"
+
+// Skompresowany blok pomiarów zapisywany jako jeden wpis pierścienia (format v2).
+// Integralność bloku pilnuje CRC32 wpisu w flash_ring.
+//
+//   nagłówek (6 B): u8 count | u8 flags | u32 base_ts
+//                   [+ u32 epoch numeracji seq, jeśli flags & BLOCK_FLAG_EPOCH]
+//   rekord:         varint sensor_id (zigzag)
+//                   varint dt   - sekundy od poprzedniego rekordu (pierwszy: od base_ts)
+//                   varint dT   - zigzag, różnica temperatury w 1/16 C od poprzedniego rekordu
+//                   [varint pressure, jeśli flags & BLOCK_FLAG_PRESSURE]
+//                   [varint dSeq - zigzag, różnica numeru seq od poprzedniego rekordu
+//                    (pierwszy: od 0), jeśli flags & BLOCK_FLAG_SEQ]
+//                   [agregat, jeśli flags & BLOCK_FLAG_AGGREGATE:
+//                    varint dMin, dMax - zigzag, 1/16 C względem średniej (temp)
+//                    varint count, varint peak_dt]
+//
+// Blok zawiera albo same zwykłe pomiary, albo same agregaty, wszystkie z jednej epoki seq.
+// Cykl 10 czujników zajmuje ok. 40 B zamiast 240 B surowych struktur.
+
+#define BLOCK_HEADER_SIZE       6
+#define BLOCK_EPOCH_SIZE        4
+#define BLOCK_MAX_HEADER_SIZE   (BLOCK_HEADER_SIZE + BLOCK_EPOCH_SIZE)
+#define BLOCK_MAX_RECORDS       64
+
+// Najdłuższy varint wartości n-bitowej: 7 bitów na bajt
+#define VARINT_MAX_SIZE(bits)   (((bits) + 6) / 7)
+
+// Najgorszy przypadek rekordu: pola 32-bitowe (sensor_id, dt, dT, pressure, dSeq, dMin, dMax)
+// po 5 B i 16-bitowe (count, peak_dt) po 3 B
+#define BLOCK_MAX_RECORD_SIZE   (7 * VARINT_MAX_SIZE(32) + 2 * VARINT_MAX_SIZE(16))
+#define BLOCK_FLAG_PRESSURE     0x01
+#define BLOCK_FLAG_AGGREGATE    0x02
+#define BLOCK_FLAG_SEQ          0x04
+#define BLOCK_FLAG_EPOCH        0x08
+
+// Koduje początek data[] (rosnące znaczniki czasu) do buf.
+// Zwraca długość bloku, w *consumed liczbę zakodowanych pomiarów.
+size_t block_encode(const SensorData *data, size_t count, uint8_t *buf, size_t buf_len, size_t *consumed);
+
+// Dekoduje blok do out[]; zwraca liczbę pomiarów lub 0 przy błędnym bloku
+size_t block_decode(const uint8_t *buf, size_t len, SensorData *out, size_t max);
+
+// Liczba pomiarów w bloku (bez dekodowania)
+size_t block_record_count(const uint8_t *buf, size_t len);
+
+// Czas pierwszego i ostatniego pomiaru w bloku (bez dekodowania temperatur)
+bool block_time_range(const uint8_t *buf, size_t len, int64_t *first, int64_t *last);
+
+#endif // BLOCK_CODEC_H
\ No newline at end of file
@@ -0,0 +1,574 @@
+#include "flash_ring.h"
+#include "storage_manager.h"
+#include "diag.h"
+#include "flash_wear.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+static const char *TAG = "FLASH_RING";
+
+#define RING_MAGIC          0x474E5246  // "FRNG"
+#define RING_NVS_NAMESPACE  "offline"
+#define RING_NVS_TAIL_KEY   "ring_tail"
+#define ENTRY_LEN_EMPTY     0xFFFF
+
+#define ALIGN4(x)           (((x) + 3) & ~3u)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t version;
+    uint8_t reserved[3];
+} ring_sector_hdr_t;
+
+// flags - bajt programowalny później bez kasowania sektora (bity 1 -> 0)
+#define ENTRY_FLAG_PENDING  0x01    // skasowany = wpis wysłany poza kolejnością (flash_ring_mark_consumed)
+
+typedef struct {
+    uint16_t len;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t crc;
+} ring_entry_hdr_t;
+
+#define SECTOR_HDR_SIZE     sizeof(ring_sector_hdr_t)
+#define ENTRY_HDR_SIZE      sizeof(ring_entry_hdr_t)
+
+_Static_assert(SECTOR_HDR_SIZE == 12, "sector header layout");
+_Static_assert(ENTRY_HDR_SIZE == 8, "entry header layout");
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_sector_count = 0;
+static uint8_t s_version = 0;
+static flash_ring_count_fn_t s_count_fn = NULL;
+
+static flash_ring_pos_t s_head;     // pierwsze wolne miejsce
+static flash_ring_pos_t s_tail;     // pierwszy nieprzetworzony wpis
+static uint32_t s_oldest_seq = 0;   // najstarszy sektor wciąż obecny na flashu
+
+static size_t s_pending = 0;
+static bool s_pending_valid = false;
+
+// Rzadki indeks: zakres kluczy (np. czasu) każdego fizycznego sektora.
+// Budowany leniwie przy pierwszym wyszukiwaniu, potem aktualizowany przy zapisie.
+typedef struct {
+    int64_t min_key;
+    int64_t max_key;
+} sector_keys_t;
+
+static flash_ring_key_fn_t s_key_fn = NULL;
+static sector_keys_t *s_index = NULL;
+static bool s_index_valid = false;
+
+static uint8_t s_io_buf[FLASH_RING_MAX_ENTRY];
+
+static inline size_t sector_addr(uint32_t seq) {
+    return (size_t)(seq % s_sector_count) * FLASH_RING_SECTOR_SIZE;
+}
+
+static inline uint32_t entry_crc(const ring_entry_hdr_t *hdr, const void *data) {
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&hdr->len, sizeof(hdr->len));
+    return esp_rom_crc32_le(crc, data, hdr->len);
+}
+
+static bool read_sector_hdr(const esp_partition_t *part, uint32_t index, ring_sector_hdr_t *hdr) {
+    if (esp_partition_read(part, (size_t)index * FLASH_RING_SECTOR_SIZE, hdr, sizeof(*hdr)) != ESP_OK) {
+        return false;
+    }
+    return hdr->magic == RING_MAGIC;
+}
+
+static esp_err_t open_sector(uint32_t seq) {
+    size_t addr = sector_addr(seq);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(s_part, addr, FLASH_RING_SECTOR_SIZE);
+    diag_phase_add(DIAG_PHASE_FLASH, start_us);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase sektora %lu nieudany: %s", (unsigned long)seq, esp_err_to_name(err));
+        return err;
+    }
+    flash_wear_add_erase();
+
+    ring_sector_hdr_t hdr = {
+        .magic = RING_MAGIC,
+        .seq = seq,
+        .version = s_version,
+        .reserved = {0xFF, 0xFF, 0xFF},
+    };
+    flash_wear_add_physical(sizeof(hdr));
+    return esp_partition_write(s_part, addr, &hdr, sizeof(hdr));
+}
+
+static esp_err_t save_tail(void) {
+    return storage_save_blob(RING_NVS_NAMESPACE, RING_NVS_TAIL_KEY, &s_tail, sizeof(s_tail));
+}
+
+static void index_clear(uint32_t seq) {
+    if (s_index_valid) {
+        s_index[seq % s_sector_count] = (sector_keys_t){ .min_key = INT64_MAX, .max_key = INT64_MIN };
+    }
+}
+
+static void index_add(uint32_t seq, const void *data, size_t len, uint8_t version) {
+    int64_t min_key, max_key;
+    if (s_index_valid && s_key_fn(data, len, version, &min_key, &max_key)) {
+        sector_keys_t *k = &s_index[seq % s_sector_count];
+        if (min_key < k->min_key) k->min_key = min_key;
+        if (max_key > k->max_key) k->max_key = max_key;
+    }
+}
+
+static bool pos_at_head(const flash_ring_pos_t *pos) {
+    return pos->seq > s_head.seq || (pos->seq == s_head.seq && pos->offset >= s_head.offset);
+}
+
+// Liczy elementy od pos do początku sektora end_seq (lub do head)
+static size_t count_items(flash_ring_pos_t pos, uint32_t end_seq) {
+    size_t total = 0;
+    size_t len;
+    uint8_t version;
+    flash_ring_pos_t next;
+
+    while (pos.seq < end_seq &&
+           flash_ring_read(&pos, s_io_buf, sizeof(s_io_buf), &len, &version, &next) == ESP_OK &&
+           pos.seq < end_seq) {
+        size_t n = s_count_fn ? s_count_fn(s_io_buf, len, version) : 1;
+        total += (n > pos.item) ? n - pos.item : 0;
+        pos = next;
+    }
+    return total;
+}
+
+// Przejście head do kolejnego sektora; jeśli trzeba, nadpisuje najstarszy
+static esp_err_t advance_head_sector(void) {
+    uint32_t new_seq = s_head.seq + 1;
+
+    if (new_seq >= s_sector_count) {
+        uint32_t victim = new_seq - s_sector_count;
+        if (victim >= s_oldest_seq) {
+            if (s_tail.seq <= victim) {
+                size_t lost = s_pending_valid ? count_items(s_tail, victim + 1) : 0;
+                ESP_LOGW(TAG, "Bufor pelny! Nadpisuje najstarszy sektor (utracono %zu pomiarow)", lost);
+                if (s_pending_valid) s_pending -= (lost < s_pending) ? lost : s_pending;
+
+                s_tail.seq = victim + 1;
+                s_tail.offset = SECTOR_HDR_SIZE;
+                s_tail.item = 0;
+                save_tail();
+            }
+            s_oldest_seq = victim + 1;
+        }
+    }
+
+    esp_err_t err = open_sector(new_seq);
+    if (err != ESP_OK) return err;
+    index_clear(new_seq);
+
+    s_head.seq = new_seq;
+    s_head.offset = SECTOR_HDR_SIZE;
+    return ESP_OK;
+}
+
+bool flash_ring_probe(const esp_partition_t *part) {
+    if (part == NULL) return false;
+
+    uint32_t count = part->size / FLASH_RING_SECTOR_SIZE;
+    ring_sector_hdr_t hdr;
+    for (uint32_t i = 0; i < count; i++) {
+        if (read_sector_hdr(part, i, &hdr) && hdr.seq % count == i) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t flash_ring_init(const esp_partition_t *part, uint8_t version, flash_ring_count_fn_t count_fn,
+                          flash_ring_key_fn_t key_fn) {
+    if (part == NULL) return ESP_ERR_INVALID_ARG;
+
+    s_part = part;
+    s_sector_count = part->size / FLASH_RING_SECTOR_SIZE;
+    s_version = version;
+    s_count_fn = count_fn;
+    s_key_fn = key_fn;
+    s_pending = 0;
+    s_pending_valid = false;
+    free(s_index);
+    s_index = NULL;
+    s_index_valid = false;
+
+    if (s_sector_count < 2) {
+        ESP_LOGE(TAG, "Partycja za mala na bufor pierscieniowy");
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // 1. Najnowszy sektor
+    ring_sector_hdr_t hdr;
+    bool found = false;
+    uint32_t max_seq = 0;
+    for (uint32_t i = 0; i < s_sector_count; i++) {
+        if (read_sector_hdr(part, i, &hdr) && hdr.seq % s_sector_count == i) {
+            if (!found || hdr.seq > max_seq) max_seq = hdr.seq;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        ESP_LOGW(TAG, "Brak danych pierscienia - formatowanie");
+        s_head = (flash_ring_pos_t){ .seq = 0, .offset = SECTOR_HDR_SIZE, .item = 0 };
+        s_tail = s_head;
+        s_oldest_seq = 0;
+        esp_err_t err = open_sector(0);
+        if (err == ESP_OK) err = save_tail();
+        s_pending_valid = (err == ESP_OK);
+        return err;
+    }
+
+    // 2. Najstarszy sektor: cofamy się dopóki poprzednik jest ciągły
+    uint32_t oldest = max_seq;
+    while (oldest > 0 && max_seq - (oldest - 1) < s_sector_count) {
+        uint32_t prev = oldest - 1;
+        if (!read_sector_hdr(part, prev % s_sector_count, &hdr) || hdr.seq != prev) break;
+        oldest = prev;
+    }
+    s_oldest_seq = oldest;
+
+    // 3. Koniec danych w najnowszym sektorze
+    s_head = (flash_ring_pos_t){ .seq = max_seq, .offset = SECTOR_HDR_SIZE, .item = 0 };
+    size_t base = sector_addr(max_seq);
+    read_sector_hdr(part, max_seq % s_sector_count, &hdr);
+    bool seal_head = (hdr.version != s_version);
+    while (s_head.offset + ENTRY_HDR_SIZE <= FLASH_RING_SECTOR_SIZE) {
+        ring_entry_hdr_t ehdr;
+        if (esp_partition_read(part, base + s_head.offset, &ehdr, sizeof(ehdr)) != ESP_OK) break;
+        if (ehdr.len == ENTRY_LEN_EMPTY) break;
+
+        size_t stride = ALIGN4(ENTRY_HDR_SIZE + ehdr.len);
+        if (ehdr.len > FLASH_RING_MAX_ENTRY || s_head.offset + stride > FLASH_RING_SECTOR_SIZE ||
+            esp_partition_read(part, base + s_head.offset + ENTRY_HDR_SIZE, s_io_buf, ehdr.len) != ESP_OK ||
+            entry_crc(&ehdr, s_io_buf) != ehdr.crc) {
+            // Przerwany zapis - nie dopisujemy za uszkodzonym wpisem, zamykamy sektor
+            ESP_LOGW(TAG, "Uszkodzony wpis w sektorze %lu - zamykam sektor", (unsigned long)max_seq);
+            s_head.offset = FLASH_RING_SECTOR_SIZE;
+            break;
+        }
+        s_head.offset += stride;
+    }
+
+    if (seal_head) {
+        // Sektor w starym formacie - nowe wpisy zaczną się w kolejnym sektorze
+        ESP_LOGI(TAG, "Sektor %lu w formacie v%d, nowe dane jako v%d",
+                 (unsigned long)max_seq, hdr.version, s_version);
+        s_head.offset = FLASH_RING_SECTOR_SIZE;
+    }
+
+    // 4. Tail z NVS
+    flash_ring_pos_t tail;
+    if (storage_load_blob(RING_NVS_NAMESPACE, RING_NVS_TAIL_KEY, &tail, sizeof(tail)) == ESP_OK &&
+        tail.offset >= SECTOR_HDR_SIZE && tail.seq >= s_oldest_seq && tail.seq <= s_head.seq + 1) {
+        s_tail = pos_at_head(&tail) ? s_head : tail;
+    } else {
+        ESP_LOGW(TAG, "Brak poprawnego kursora tail - od najstarszego sektora");
+        s_tail = (flash_ring_pos_t){ .seq = s_oldest_seq, .offset = SECTOR_HDR_SIZE, .item = 0 };
+    }
+
+    ESP_LOGI(TAG, "Pierscien: %lu sektorow, head=%lu:%u, tail=%lu:%u",
+             (unsigned long)s_sector_count, (unsigned long)s_head.seq, s_head.offset,
+             (unsigned long)s_tail.seq, s_tail.offset);
+    return ESP_OK;
+}
+
+esp_err_t flash_ring_append(const void *data, size_t len) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+    if (len == 0 || len > FLASH_RING_MAX_ENTRY) return ESP_ERR_INVALID_SIZE;
+
+    size_t stride = ALIGN4(ENTRY_HDR_SIZE + len);
+    if (s_head.offset + stride > FLASH_RING_SECTOR_SIZE) {
+        esp_err_t err = advance_head_sector();
+        if (err != ESP_OK) return err;
+    }
+
+    ring_entry_hdr_t hdr = {
+        .len = (uint16_t)len,
+        .flags = 0xFF,
+        .reserved = 0xFF,
+    };
+    hdr.crc = entry_crc(&hdr, data);
+
+    // Najpierw nagłówek: przerwany zapis zostawi wpis z błędnym CRC, a nie "dziurę"
+    size_t addr = sector_addr(s_head.seq) + s_head.offset;
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = esp_partition_write(s_part, addr, &hdr, sizeof(hdr));
+    if (err == ESP_OK) {
+        err = esp_partition_write(s_part, addr + ENTRY_HDR_SIZE, data, len);
+    }
+    diag_phase_add(DIAG_PHASE_FLASH, start_us);
+    flash_wear_add_physical(sizeof(hdr) + len);
+    s_head.offset += stride;
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Zapis wpisu nieudany: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    if (s_pending_valid) {
+        s_pending += s_count_fn ? s_count_fn(data, len, s_version) : 1;
+    }
+    index_add(s_head.seq, data, len, s_version);
+    return ESP_OK;
+}
+
+// Wspólny odczyt wpisu od pos; with_consumed - także wpisy oznaczone flash_ring_mark_consumed
+static esp_err_t read_entry(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                            uint8_t *version, flash_ring_pos_t *next, bool with_consumed) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+
+    if (pos->seq < s_oldest_seq) {
+        // Sektor został w międzyczasie nadpisany
+        pos->seq = s_oldest_seq;
+        pos->offset = SECTOR_HDR_SIZE;
+        pos->item = 0;
+    }
+
+    while (!pos_at_head(pos)) {
+        size_t base = sector_addr(pos->seq);
+        ring_entry_hdr_t hdr;
+
+        if (pos->offset + ENTRY_HDR_SIZE > FLASH_RING_SECTOR_SIZE ||
+            esp_partition_read(s_part, base + pos->offset, &hdr, sizeof(hdr)) != ESP_OK ||
+            hdr.len == ENTRY_LEN_EMPTY || hdr.len > FLASH_RING_MAX_ENTRY ||
+            pos->offset + ALIGN4(ENTRY_HDR_SIZE + hdr.len) > FLASH_RING_SECTOR_SIZE) {
+            // Koniec danych w tym sektorze
+            pos->seq++;
+            pos->offset = SECTOR_HDR_SIZE;
+            pos->item = 0;
+            continue;
+        }
+
+        size_t stride = ALIGN4(ENTRY_HDR_SIZE + hdr.len);
+        if (!with_consumed && !(hdr.flags & ENTRY_FLAG_PENDING)) {
+            pos->offset += stride;  // już wysłany
+            pos->item = 0;
+            continue;
+        }
+        if (hdr.len > max_len) return ESP_ERR_INVALID_SIZE;
+
+        if (esp_partition_read(s_part, base + pos->offset + ENTRY_HDR_SIZE, buf, hdr.len) != ESP_OK ||
+            entry_crc(&hdr, buf) != hdr.crc) {
+            ESP_LOGW(TAG, "Pomijam uszkodzony wpis %lu:%u", (unsigned long)pos->seq, pos->offset);
+            pos->offset += stride;
+            pos->item = 0;
+            continue;
+        }
+
+        if (version) {
+            ring_sector_hdr_t shdr;
+            *version = read_sector_hdr(s_part, pos->seq % s_sector_count, &shdr) ? shdr.version : s_version;
+        }
+        *out_len = hdr.len;
+        next->seq = pos->seq;
+        next->offset = pos->offset + stride;
+        next->item = 0;
+        return ESP_OK;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t flash_ring_read(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                          uint8_t *version, flash_ring_pos_t *next) {
+    return read_entry(pos, buf, max_len, out_len, version, next, false);
+}
+
+esp_err_t flash_ring_read_history(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                                  uint8_t *version, flash_ring_pos_t *next) {
+    return read_entry(pos, buf, max_len, out_len, version, next, true);
+}
+
+// Jednorazowy skan wszystkich sektorów obecnych na flashu
+static esp_err_t build_index(void) {
+    s_index = malloc(s_sector_count * sizeof(sector_keys_t));
+    if (s_index == NULL) return ESP_ERR_NO_MEM;
+
+    s_index_valid = true;
+    for (uint32_t i = 0; i < s_sector_count; i++) {
+        index_clear(i);
+    }
+
+    flash_ring_pos_t pos = { .seq = s_oldest_seq, .offset = SECTOR_HDR_SIZE, .item = 0 };
+    flash_ring_pos_t next;
+    size_t len;
+    uint8_t version;
+    while (read_entry(&pos, s_io_buf, sizeof(s_io_buf), &len, &version, &next, true) == ESP_OK) {
+        index_add(pos.seq, s_io_buf, len, version);
+        pos = next;
+    }
+
+    ESP_LOGI(TAG, "Indeks sektorow zbudowany (%lu-%lu)", (unsigned long)s_oldest_seq, (unsigned long)s_head.seq);
+    return ESP_OK;
+}
+
+esp_err_t flash_ring_seek(flash_ring_pos_t *pos, int64_t from, int64_t to) {
+    if (s_part == NULL || s_key_fn == NULL) return ESP_ERR_INVALID_STATE;
+    if (!s_index_valid) {
+        esp_err_t err = build_index();
+        if (err != ESP_OK) return err;
+    }
+
+    if (pos->seq < s_oldest_seq || pos->offset < SECTOR_HDR_SIZE) {
+        pos->seq = (pos->seq < s_oldest_seq) ? s_oldest_seq : pos->seq;
+        pos->offset = SECTOR_HDR_SIZE;
+        pos->item = 0;
+    }
+
+    for (uint32_t seq = pos->seq; seq <= s_head.seq; seq++) {
+        const sector_keys_t *k = &s_index[seq % s_sector_count];
+        if (k->min_key <= to && k->max_key >= from) {
+            if (seq != pos->seq) {
+                *pos = (flash_ring_pos_t){ .seq = seq, .offset = SECTOR_HDR_SIZE, .item = 0 };
+            }
+            return pos_at_head(pos) ? ESP_ERR_NOT_FOUND : ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t flash_ring_read_prev(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                               uint8_t *version) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+
+    uint32_t seq = pos->seq;
+    size_t end = pos_at_head(pos) ? s_head.offset : pos->offset;
+    if (seq > s_head.seq) {
+        seq = s_head.seq;
+        end = s_head.offset;
+    }
+
+    // Wpisy mają zmienną długość - sektor przeglądamy od początku, zapamiętując ostatni pasujący
+    while (seq >= s_tail.seq && seq >= s_oldest_seq) {
+        size_t base = sector_addr(seq);
+        size_t offset = (seq == s_tail.seq) ? s_tail.offset : SECTOR_HDR_SIZE;
+        size_t found = 0;
+        ring_entry_hdr_t found_hdr = {0};
+
+        while (offset + ENTRY_HDR_SIZE <= end) {
+            ring_entry_hdr_t hdr;
+            if (esp_partition_read(s_part, base + offset, &hdr, sizeof(hdr)) != ESP_OK ||
+                hdr.len == ENTRY_LEN_EMPTY || hdr.len > FLASH_RING_MAX_ENTRY) {
+                break;
+            }
+            size_t stride = ALIGN4(ENTRY_HDR_SIZE + hdr.len);
+            if (offset + stride > end) break;
+            if (hdr.flags & ENTRY_FLAG_PENDING) {
+                found = offset;
+                found_hdr = hdr;
+            }
+            offset += stride;
+        }
+
+        if (found != 0) {
+            if (found_hdr.len > max_len) return ESP_ERR_INVALID_SIZE;
+            if (esp_partition_read(s_part, base + found + ENTRY_HDR_SIZE, buf, found_hdr.len) != ESP_OK ||
+                entry_crc(&found_hdr, buf) != found_hdr.crc) {
+                ESP_LOGW(TAG, "Pomijam uszkodzony wpis %lu:%u", (unsigned long)seq, (unsigned)found);
+                end = found;
+                continue;
+            }
+
+            if (version) {
+                ring_sector_hdr_t shdr;
+                *version = read_sector_hdr(s_part, seq % s_sector_count, &shdr) ? shdr.version : s_version;
+            }
+            *out_len = found_hdr.len;
+            pos->seq = seq;
+            pos->offset = (uint16_t)found;
+            pos->item = 0;
+            return ESP_OK;
+        }
+
+        if (seq == 0) break;
+        seq--;
+        end = FLASH_RING_SECTOR_SIZE;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t flash_ring_mark_consumed(const flash_ring_pos_t *pos, size_t items) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+    // Sektor mógł zostać nadpisany nowymi danymi od czasu odczytu
+    if (pos->seq < s_oldest_seq || pos->seq < s_tail.seq || pos_at_head(pos)) return ESP_ERR_NOT_FOUND;
+
+    uint8_t flags = (uint8_t)~ENTRY_FLAG_PENDING;
+    size_t addr = sector_addr(pos->seq) + pos->offset + offsetof(ring_entry_hdr_t, flags);
+    esp_err_t err = esp_partition_write(s_part, addr, &flags, sizeof(flags));
+    flash_wear_add_physical(sizeof(flags));
+    if (err == ESP_OK && s_pending_valid) {
+        s_pending -= (items < s_pending) ? items : s_pending;
+    }
+    return err;
+}
+
+flash_ring_pos_t flash_ring_tail(void) {
+    return s_tail;
+}
+
+flash_ring_pos_t flash_ring_head(void) {
+    return s_head;
+}
+
+esp_err_t flash_ring_consume(const flash_ring_pos_t *new_tail, size_t items) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+
+    s_tail = *new_tail;
+    if (s_pending_valid) {
+        s_pending -= (items < s_pending) ? items : s_pending;
+    }
+    return save_tail();
+}
+
+esp_err_t flash_ring_skip_consumed(void) {
+    if (s_part == NULL) return ESP_ERR_INVALID_STATE;
+
+    // Wpis pod tail częściowo wysłany (item > 0) nie może być oznaczony - zostaje
+    flash_ring_pos_t pos = s_tail;
+    while (!pos_at_head(&pos)) {
+        ring_entry_hdr_t hdr;
+        if (pos.offset + ENTRY_HDR_SIZE > FLASH_RING_SECTOR_SIZE ||
+            esp_partition_read(s_part, sector_addr(pos.seq) + pos.offset, &hdr, sizeof(hdr)) != ESP_OK ||
+            hdr.len == ENTRY_LEN_EMPTY || hdr.len > FLASH_RING_MAX_ENTRY ||
+            pos.offset + ALIGN4(ENTRY_HDR_SIZE + hdr.len) > FLASH_RING_SECTOR_SIZE) {
+            // Koniec danych w tym sektorze
+            pos.seq++;
+            pos.offset = SECTOR_HDR_SIZE;
+            pos.item = 0;
+            continue;
+        }
+        if (hdr.flags & ENTRY_FLAG_PENDING) break;
+        pos.offset += ALIGN4(ENTRY_HDR_SIZE + hdr.len);
+        pos.item = 0;
+    }
+
+    if (pos.seq == s_tail.seq && pos.offset == s_tail.offset) return ESP_OK;
+    // Elementy tych wpisów odjęto od s_pending już w flash_ring_mark_consumed
+    s_tail = pos_at_head(&pos) ? s_head : pos;
+    return save_tail();
+}
+
+size_t flash_ring_pending(void) {
+    if (s_part == NULL) return 0;
+
+    if (!s_pending_valid) {
+        s_pending = count_items(s_tail, UINT32_MAX);
+        s_pending_valid = true;
+    }
+    return s_pending;
+}
+
+bool flash_ring_is_empty(void) {
+    return s_part == NULL || pos_at_head(&s_tail);
+}
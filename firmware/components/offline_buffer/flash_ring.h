@@ -0,0 +1,94 @@
+#ifndef FLASH_RING_H
+#define FLASH_RING_H
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bufor pierścieniowy wpisów o zmiennej długości bezpośrednio na partycji flash.
+// Partycja dzielona jest na sektory 4 KB, każdy z nagłówkiem (magic, numer, wersja).
+// Wpisy dopisywane są tylko na końcu (head), odczyt idzie od tail.
+// Tail zapisywany jest w NVS, head odtwarzany przy starcie ze skanu flasha.
+
+#define FLASH_RING_SECTOR_SIZE   4096
+#define FLASH_RING_MAX_ENTRY     (FLASH_RING_SECTOR_SIZE - 12 - 8)
+
+// Pozycja w pierścieniu.
+// seq    - rosnący numer sektora (fizyczny sektor = seq % liczba_sektorow)
+// offset - przesunięcie wpisu w sektorze
+// item   - indeks pierwszego nieprzetworzonego elementu wewnątrz wpisu (używa warstwa wyżej)
+typedef struct {
+    uint32_t seq;
+    uint16_t offset;
+    uint16_t item;
+} flash_ring_pos_t;
+
+// Zwraca liczbę elementów (pomiarów) zapisanych w danym wpisie
+typedef size_t (*flash_ring_count_fn_t)(const void *data, size_t len, uint8_t version);
+
+// Zakres kluczy (np. znaczników czasu) elementów wpisu - do indeksu sektorów.
+// false = wpis bez kluczy (nie rozszerza zakresu sektora)
+typedef bool (*flash_ring_key_fn_t)(const void *data, size_t len, uint8_t version,
+                                    int64_t *min_key, int64_t *max_key);
+
+// Sprawdza czy na partycji jest już pierścień (co najmniej jeden poprawny sektor)
+bool flash_ring_probe(const esp_partition_t *part);
+
+// Odtwarza stan pierścienia z flasha (lub formatuje pustą partycję).
+// version - wersja formatu nadawana nowo otwieranym sektorom
+// key_fn  - opcjonalny (NULL), potrzebny dla flash_ring_seek
+esp_err_t flash_ring_init(const esp_partition_t *part, uint8_t version, flash_ring_count_fn_t count_fn,
+                          flash_ring_key_fn_t key_fn);
+
+// Dopisuje wpis. Gdy brak miejsca, najstarszy sektor jest nadpisywany.
+esp_err_t flash_ring_append(const void *data, size_t len);
+
+// Czyta wpis spod pos (uszkodzone i oznaczone jako przetworzone wpisy są pomijane).
+// Zwraca ESP_ERR_NOT_FOUND gdy pos doszedł do head.
+esp_err_t flash_ring_read(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                          uint8_t *version, flash_ring_pos_t *next);
+
+// Jak flash_ring_read, ale bez pomijania wpisów już przetworzonych - historia z pozycji przed tail.
+// Przetworzone dane zostają na flashu, dopóki ich sektor nie zostanie nadpisany.
+esp_err_t flash_ring_read_history(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                                  uint8_t *version, flash_ring_pos_t *next);
+
+// Przesuwa pos na początek pierwszego sektora (od sektora pos włącznie), którego zakres kluczy
+// przecina [from, to]. Pos w pasującym sektorze zostaje bez zmian; pos = {0} - od najstarszego.
+// Indeks (16 B RAM na sektor) budowany jest skanem flasha przy pierwszym wywołaniu.
+// ESP_ERR_NOT_FOUND - dalej nie ma pasujących sektorów.
+esp_err_t flash_ring_seek(flash_ring_pos_t *pos, int64_t from, int64_t to);
+
+// Jak flash_ring_read, ale wstecz: najnowszy nieprzetworzony wpis leżący przed pos
+// (nie wcześniej niż wpis pod tail). Wpisy oznaczone flash_ring_mark_consumed są pomijane.
+// Na wejściu pos = granica (np. flash_ring_head()), na wyjściu pozycja znalezionego wpisu.
+esp_err_t flash_ring_read_prev(flash_ring_pos_t *pos, void *buf, size_t max_len, size_t *out_len,
+                               uint8_t *version);
+
+// Oznacza cały wpis jako przetworzony bez przesuwania tail (wysyłka poza kolejnością).
+// Jedno zaprogramowanie bajtu flag w nagłówku wpisu - bez kasowania sektora.
+// items - liczba elementów we wpisie
+esp_err_t flash_ring_mark_consumed(const flash_ring_pos_t *pos, size_t items);
+
+// Początek nieprzetworzonych danych
+flash_ring_pos_t flash_ring_tail(void);
+
+// Pierwsze wolne miejsce (koniec danych)
+flash_ring_pos_t flash_ring_head(void);
+
+// Przesuwa tail (bez kasowania flasha) i zapisuje go w NVS.
+// items - liczba elementów przetworzonych od poprzedniego tail
+esp_err_t flash_ring_consume(const flash_ring_pos_t *new_tail, size_t items);
+
+// Przesuwa tail za ciąg wpisów oznaczonych flash_ring_mark_consumed, który zaczyna się pod tail
+// (po wysyłce od najnowszych). Bez tego tail stoi przed nimi, a pierścień nie jest nigdy pusty.
+esp_err_t flash_ring_skip_consumed(void);
+
+// Liczba nieprzetworzonych elementów (liczona leniwie przy pierwszym wywołaniu)
+size_t flash_ring_pending(void);
+
+bool flash_ring_is_empty(void);
+
+#endif // FLASH_RING_H
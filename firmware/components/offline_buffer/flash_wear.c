@@ -0,0 +1,107 @@
+#include "flash_wear.h"
+#include "offline_buffer.h"
+#include "storage_manager.h"
+#include "diag.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include <inttypes.h>
+#include <time.h>
+
+static const char *TAG = "FLASH_WEAR";
+
+#define WEAR_NVS_NAMESPACE      "offline"
+#define WEAR_NVS_KEY            "wear"
+#define MIN_RATE_WINDOW_S       3600            // krócej - prognoza zbyt losowa
+
+static RTC_DATA_ATTR flash_wear_t s_wear;
+static RTC_DATA_ATTR bool s_loaded = false;     // po deep sleep RTC jest nowsze niż NVS
+static uint32_t s_sector_count = 0;
+
+static int64_t now_ts(void) {
+    time_t now = time(NULL);
+    return (now >= MIN_VALID_TIMESTAMP) ? (int64_t)now : 0;
+}
+
+// Wycena do rekordu diagnostycznego po każdej zmianie - diag nie zależy od bufora
+static void publish_to_diag(void) {
+    diag_flash_wear_t d = {
+        .logical_bytes = s_wear.logical_bytes,
+        .physical_bytes = s_wear.physical_bytes,
+        .sectors_erased = s_wear.sectors_erased,
+        .records_rewritten = s_wear.records_rewritten,
+        .lifetime_days = flash_wear_lifetime_days(),
+    };
+    diag_set_flash_wear(&d);
+}
+
+static void save(void) {
+    if (s_wear.since_ts == 0) {
+        // Tempo liczymy od pierwszej chwili ze znanym czasem
+        s_wear.since_ts = now_ts();
+        s_wear.since_erased = s_wear.sectors_erased;
+    }
+    storage_save_blob(WEAR_NVS_NAMESPACE, WEAR_NVS_KEY, &s_wear, sizeof(s_wear));
+}
+
+void flash_wear_init(uint32_t sector_count) {
+    s_sector_count = sector_count;
+    if (s_loaded) return;
+
+    if (storage_load_blob(WEAR_NVS_NAMESPACE, WEAR_NVS_KEY, &s_wear, sizeof(s_wear)) != ESP_OK) {
+        s_wear = (flash_wear_t){0};
+    }
+    s_loaded = true;
+}
+
+void flash_wear_sync(uint32_t sectors_opened) {
+    if (s_wear.sectors_erased < sectors_opened) {
+        s_wear.sectors_erased = sectors_opened;
+        save();
+    }
+
+    ESP_LOGI(TAG, "Kasowania: %lu (%.1f na sektor), zapis fizyczny/logiczny: %" PRIu64 "/%" PRIu64 " B",
+             (unsigned long)s_wear.sectors_erased, (double)s_wear.sectors_erased / s_sector_count,
+             s_wear.physical_bytes, s_wear.logical_bytes);
+
+    uint32_t days = flash_wear_lifetime_days();
+    if (days != FLASH_WEAR_LIFETIME_UNKNOWN) {
+        ESP_LOGI(TAG, "Prognoza zuzycia flasha: %lu dni", (unsigned long)days);
+    }
+    publish_to_diag();
+}
+
+void flash_wear_add_logical(size_t records, bool rewritten) {
+    s_wear.logical_bytes += records * sizeof(SensorData);
+    if (rewritten) s_wear.records_rewritten += records;
+    publish_to_diag();
+}
+
+void flash_wear_add_physical(size_t bytes) {
+    s_wear.physical_bytes += bytes;
+}
+
+void flash_wear_add_erase(void) {
+    s_wear.sectors_erased++;
+    save();
+    publish_to_diag();
+}
+
+void flash_wear_get(flash_wear_t *out) {
+    *out = s_wear;
+}
+
+uint32_t flash_wear_lifetime_days(void) {
+    int64_t now = now_ts();
+    if (s_sector_count == 0 || s_wear.since_ts == 0 || now - s_wear.since_ts < MIN_RATE_WINDOW_S ||
+        s_wear.sectors_erased <= s_wear.since_erased) {
+        return FLASH_WEAR_LIFETIME_UNKNOWN;
+    }
+
+    double per_day = (double)(s_wear.sectors_erased - s_wear.since_erased) * 86400.0 / (double)(now - s_wear.since_ts);
+    double budget = (double)CONFIG_HIVE_FLASH_ENDURANCE_CYCLES * s_sector_count;
+    double left = budget - s_wear.sectors_erased;
+    if (left <= 0) return 0;
+
+    double days = left / per_day;
+    return days >= FLASH_WEAR_LIFETIME_UNKNOWN ? FLASH_WEAR_LIFETIME_UNKNOWN - 1 : (uint32_t)days;
+}
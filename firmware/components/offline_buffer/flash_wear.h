@@ -0,0 +1,45 @@
+#ifndef FLASH_WEAR_H
+#define FLASH_WEAR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Zużycie partycji "storage": liczniki od pierwszego uruchomienia (NVS "offline"/"wear").
+// Zapis do NVS przy każdym kasowaniu sektora - po utracie zasilania ginie najwyżej jeden
+// sektor zapisów; w deep sleep liczniki trzyma pamięć RTC.
+//
+// Współczynnik zapisu (write amplification) = physical_bytes / logical_bytes.
+// Logicznie liczymy rekord jako sizeof(SensorData), więc kompresja bloków daje wynik < 1,
+// a różne formaty bufora można porównać wprost.
+
+typedef struct {
+    uint64_t logical_bytes;     // pomiary przekazane do bufora (sizeof(SensorData) na rekord)
+    uint64_t physical_bytes;    // zaprogramowane bajty: nagłówki sektorów i wpisów, dane, flagi
+    uint32_t sectors_erased;
+    uint32_t records_rewritten; // rekordy zapisane ponownie (migracja z SPIFFS)
+    int64_t since_ts;           // początek pomiaru tempa zużycia (czas Unix), 0 = czas nieznany
+    uint32_t since_erased;      // sectors_erased w chwili since_ts
+} flash_wear_t;
+
+#define FLASH_WEAR_LIFETIME_UNKNOWN  UINT32_MAX
+
+// Wczytuje liczniki (przed flash_ring_init - formatowanie i migracja też się liczą)
+void flash_wear_init(uint32_t sector_count);
+
+// Po otwarciu pierścienia: kasowań nie mniej niż sectors_opened (numer sektora pierścienia
+// rośnie z każdym kasowaniem), gdy liczniki powstały później niż pierścień albo zginęły z NVS
+void flash_wear_sync(uint32_t sectors_opened);
+
+void flash_wear_add_logical(size_t records, bool rewritten);
+void flash_wear_add_physical(size_t bytes);
+void flash_wear_add_erase(void);
+
+void flash_wear_get(flash_wear_t *out);
+
+// Prognoza dni do wyczerpania CONFIG_HIVE_FLASH_ENDURANCE_CYCLES kasowań na sektor przy tempie
+// od since_ts (pierścień rozkłada kasowania równo na wszystkie sektory).
+// FLASH_WEAR_LIFETIME_UNKNOWN - za krótki pomiar albo brak kasowań.
+uint32_t flash_wear_lifetime_days(void);
+
+#endif // FLASH_WEAR_H
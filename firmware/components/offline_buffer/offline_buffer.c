@@ -1,99 +1,543 @@
 #include "offline_buffer.h"
+#include "flash_ring.h"
+#include "block_codec.h"
+#include "flash_wear.h"
+#include "storage_manager.h"
+#include "esp_partition.h"
 #include "esp_spiffs.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 static const char *TAG = "OFFLINE_BUF";
-static const char *FILE_PATH = "/storage/data.bin";
+static const char *PARTITION_LABEL = "storage";
 
-esp_err_t offline_buffer_init(void) {
+// Stary format: plik SPIFFS z surowymi strukturami SensorData
+static const char *LEGACY_BASE_PATH = "/storage";
+static const char *LEGACY_FILE_PATH = "/storage/data.bin";
+
+// Wersje formatu wpisów w pierścieniu (zapisywane w nagłówku sektora)
+#define OFFLINE_FORMAT_V1       1   // jeden wpis = jedna surowa struktura SensorData
+#define OFFLINE_FORMAT_V2       2   // jeden wpis = skompresowany blok pomiarów (block_codec.h)
+#define OFFLINE_FORMAT_CURRENT  OFFLINE_FORMAT_V2
+
+// Rekord formatu v1 i pliku data.bin - układ SensorData sprzed wariantu agregatu
+typedef struct {
+    int64_t timestamp;
+    float temp;
+    uint32_t pressure;
+    int sensor_id;
+} legacy_record_t;
+
+// Ile rekordów przekazujemy naraz do callbacku wysyłki (tail w NVS zapisywany po każdej paczce)
+#define DRAIN_CHUNK             64
+
+// Bufor używany jest z dwóch tasków (pomiary i wysyłka) - pierścień chroni mutex.
+// Wysyłka (callback) odbywa się bez blokady, żeby zapis nowych pomiarów nie czekał na sieć.
+static SemaphoreHandle_t s_lock = NULL;
+
+static uint8_t s_entry_buf[FLASH_RING_MAX_ENTRY];
+
+static SensorData s_chunk[DRAIN_CHUNK];
+static flash_ring_pos_t s_chunk_next[DRAIN_CHUNK];  // pozycja tuż za danym rekordem
+
+static SensorData s_block_items[BLOCK_MAX_RECORDS];
+static uint8_t s_block_buf[FLASH_RING_MAX_ENTRY];
+
+// Zlecona ponowna wysyłka zakresu czasu; kursor w NVS, więc trwa przez kolejne cykle i restarty
+#define RESEND_NVS_NAMESPACE    "offline"
+#define RESEND_NVS_KEY          "resend"
+
+typedef struct {
+    int64_t from;
+    int64_t to;
+    flash_ring_pos_t pos;   // następny rekord do sprawdzenia
+} resend_req_t;
+
+static resend_req_t s_resend;
+static bool s_resend_active = false;
+static uint32_t s_resend_gen = 0;       // zmienia się przy każdym nowym zleceniu
+
+static void lock(void) {
+    if (s_lock != NULL) xSemaphoreTake(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) {
+    if (s_lock != NULL) xSemaphoreGive(s_lock);
+}
+
+// Czy pozycja a leży w pierścieniu przed b
+static bool pos_before(const flash_ring_pos_t *a, const flash_ring_pos_t *b) {
+    if (a->seq != b->seq) return a->seq < b->seq;
+    if (a->offset != b->offset) return a->offset < b->offset;
+    return a->item < b->item;
+}
+
+static size_t entry_item_count(const void *data, size_t len, uint8_t version) {
+    switch (version) {
+        case OFFLINE_FORMAT_V1:
+            return (len == sizeof(legacy_record_t)) ? 1 : 0;
+        case OFFLINE_FORMAT_V2:
+            return block_record_count(data, len);
+        default:
+            return 0;
+    }
+}
+
+static bool entry_time_range(const void *data, size_t len, uint8_t version, int64_t *first, int64_t *last) {
+    switch (version) {
+        case OFFLINE_FORMAT_V1: {
+            if (len != sizeof(legacy_record_t)) return false;
+            legacy_record_t rec;
+            memcpy(&rec, data, sizeof(rec));
+            *first = *last = rec.timestamp;
+            return true;
+        }
+        case OFFLINE_FORMAT_V2:
+            return block_time_range(data, len, first, last);
+        default:
+            return false;
+    }
+}
+
+static SensorData from_legacy(const legacy_record_t *rec) {
+    return (SensorData){
+        .timestamp = rec->timestamp,
+        .temp = rec->temp,
+        .pressure = rec->pressure,
+        .sensor_id = rec->sensor_id,
+    };
+}
+
+// Rozpakowuje wpis do out[], zwraca liczbę rekordów (0 = nieznany format)
+static size_t entry_decode(const void *data, size_t len, uint8_t version, SensorData *out, size_t max) {
+    switch (version) {
+        case OFFLINE_FORMAT_V1: {
+            if (len != sizeof(legacy_record_t) || max < 1) return 0;
+            legacy_record_t rec;
+            memcpy(&rec, data, sizeof(rec));
+            out[0] = from_legacy(&rec);
+            return 1;
+        }
+        case OFFLINE_FORMAT_V2:
+            return block_decode(data, len, out, max);
+        default:
+            return 0;
+    }
+}
+
+static esp_err_t append_records(const SensorData *data, size_t count, bool rewritten);
+
+// Jednorazowa migracja z SPIFFS: wczytuje data.bin do RAM, a po sformatowaniu
+// partycji jako pierścień dopisuje rekordy z powrotem (już jako bloki v2).
+static esp_err_t migrate_legacy_spiffs(const esp_partition_t *part) {
     esp_vfs_spiffs_conf_t conf = {
-      .base_path = "/storage",
-      .partition_label = "storage",
-      .max_files = 5,
-      .format_if_mount_failed = true
+      .base_path = LEGACY_BASE_PATH,
+      .partition_label = PARTITION_LABEL,
+      .max_files = 2,
+      .format_if_mount_failed = false
     };
 
-    esp_err_t ret = esp_vfs_spiffs_register(&conf);
+    if (esp_vfs_spiffs_register(&conf) != ESP_OK) {
+        ESP_LOGI(TAG, "Brak starego systemu plikow - nic do migracji");
+        return flash_ring_init(part, OFFLINE_FORMAT_CURRENT, entry_item_count, entry_time_range);
+    }
+
+    SensorData *records = NULL;
+    size_t record_count = 0;
 
-    if (ret != ESP_OK) {
-        if (ret == ESP_FAIL) {
-            ESP_LOGE(TAG, "Failed to mount or format filesystem");
-        } else if (ret == ESP_ERR_NOT_FOUND) {
-            ESP_LOGE(TAG, "Failed to find SPIFFS partition");
+    struct stat st;
+    if (stat(LEGACY_FILE_PATH, &st) == 0 && st.st_size >= (off_t)sizeof(legacy_record_t)) {
+        size_t total = st.st_size / sizeof(legacy_record_t);
+        size_t fit = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) / 2 / sizeof(SensorData);
+        record_count = (total < fit) ? total : fit;
+
+        if (record_count < total) {
+            ESP_LOGW(TAG, "Migracja: za malo RAM, zachowuje %zu najnowszych z %zu rekordow", record_count, total);
+        }
+
+        records = malloc(record_count * sizeof(SensorData));
+        FILE *f = fopen(LEGACY_FILE_PATH, "rb");
+        if (records != NULL && f != NULL) {
+            fseek(f, (long)((total - record_count) * sizeof(legacy_record_t)), SEEK_SET);
+            size_t read = 0;
+            legacy_record_t rec;
+            while (read < record_count && fread(&rec, sizeof(rec), 1, f) == 1) {
+                records[read++] = from_legacy(&rec);
+            }
+            record_count = read;
         } else {
-            ESP_LOGE(TAG, "Failed to initialize SPIFFS (%s)", esp_err_to_name(ret));
+            record_count = 0;
         }
+        if (f != NULL) fclose(f);
+    }
+
+    esp_vfs_spiffs_unregister(PARTITION_LABEL);
+
+    esp_err_t ret = flash_ring_init(part, OFFLINE_FORMAT_CURRENT, entry_item_count, entry_time_range);
+    if (ret == ESP_OK && record_count > 0) {
+        append_records(records, record_count, true);
+        ESP_LOGI(TAG, "Migracja: przeniesiono %zu rekordow z data.bin", record_count);
+    }
+
+    free(records);
+    return ret;
+}
+
+esp_err_t offline_buffer_init(void) {
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+    }
+
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                           ESP_PARTITION_SUBTYPE_ANY, PARTITION_LABEL);
+    if (part == NULL) {
+        ESP_LOGE(TAG, "Failed to find storage partition");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    flash_wear_init(part->size / FLASH_RING_SECTOR_SIZE);
+
+    esp_err_t ret;
+    if (flash_ring_probe(part)) {
+        // Sektory v1 zostają czytelne i opróżnią się same; nowe dane idą jako v2
+        ret = flash_ring_init(part, OFFLINE_FORMAT_CURRENT, entry_item_count, entry_time_range);
+    } else {
+        ret = migrate_legacy_spiffs(part);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize offline buffer (%s)", esp_err_to_name(ret));
         return ret;
     }
+    flash_wear_sync(flash_ring_head().seq + 1);
 
-    size_t total = 0, used = 0;
-    ret = esp_spiffs_info(conf.partition_label, &total, &used);
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Partition size: total: %d, used: %d", total, used);
+    lock();
+    if (!s_resend_active &&
+        storage_load_blob(RESEND_NVS_NAMESPACE, RESEND_NVS_KEY, &s_resend, sizeof(s_resend)) == ESP_OK) {
+        s_resend_active = true;
+        ESP_LOGI(TAG, "Niedokonczona ponowna wysylka %" PRId64 "-%" PRId64, s_resend.from, s_resend.to);
     }
+    unlock();
+
+    ESP_LOGI(TAG, "Partition size: %lu, w buforze: %zu rekordow",
+             (unsigned long)part->size, offline_buffer_count());
     return ESP_OK;
 }
 
 esp_err_t offline_buffer_add(SensorData data) {
-    FILE* f = fopen(FILE_PATH, "ab");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "Failed to open file for writing");
-        return ESP_FAIL;
-    }
-    
-    fwrite(&data, sizeof(SensorData), 1, f);
-    fclose(f);
-    
-    ESP_LOGI(TAG, "Zapisano offline [TS:%lld]: T:%.2f C, P:%lu Pa", data.timestamp, data.temp, data.pressure);
-    return ESP_OK;
+    esp_err_t ret = offline_buffer_add_batch(&data, 1);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Zapisano offline [TS:%" PRId64 "]: T:%.2f C, P:%lu Pa", data.timestamp, data.temp,
+                 (unsigned long)data.pressure);
+    }
+    return ret;
+}
+
+esp_err_t offline_buffer_add_batch(const SensorData *data, size_t count) {
+    return append_records(data, count, false);
+}
+
+// rewritten - rekordy już raz zapisane na flashu (licznik zużycia)
+static esp_err_t append_records(const SensorData *data, size_t count, bool rewritten) {
+    size_t done = 0;
+    size_t bytes = 0;
+    esp_err_t ret = ESP_OK;
+
+    lock();
+    while (done < count) {
+        size_t consumed = 0;
+        size_t len = block_encode(&data[done], count - done, s_block_buf, sizeof(s_block_buf), &consumed);
+        if (len == 0 || consumed == 0) {
+            ret = ESP_ERR_INVALID_ARG;
+            break;
+        }
+
+        ret = flash_ring_append(s_block_buf, len);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to append block");
+            break;
+        }
+        done += consumed;
+        bytes += len;
+    }
+    flash_wear_add_logical(done, rewritten);
+    unlock();
+
+    if (ret == ESP_OK) {
+        ESP_LOGD(TAG, "Zapisano %zu pomiarow w %zu B", count, bytes);
+    }
+    return ret;
 }
 
 size_t offline_buffer_count(void) {
-    struct stat st;
-    if (stat(FILE_PATH, &st) != 0) {
-        return 0; // Plik nie istnieje
+    lock();
+    size_t count = flash_ring_pending();
+    unlock();
+    return count;
+}
+
+// Wypełnia s_chunk (najwyżej max rekordów) od pos; zwraca ich liczbę
+static size_t fill_chunk(flash_ring_pos_t pos, size_t max) {
+    flash_ring_pos_t next;
+    size_t len;
+    uint8_t version;
+    size_t n = 0;
+    if (max > DRAIN_CHUNK) max = DRAIN_CHUNK;
+    while (n < max &&
+           flash_ring_read(&pos, s_entry_buf, sizeof(s_entry_buf), &len, &version, &next) == ESP_OK) {
+        size_t count = entry_decode(s_entry_buf, len, version, s_block_items, BLOCK_MAX_RECORDS);
+        if (count == 0) {
+            ESP_LOGW(TAG, "Nieznany format wpisu (v%d, %zu B) - pomijam", version, len);
+            if (n == 0) flash_ring_consume(&next, 0);
+        }
+
+        for (size_t i = pos.item; i < count && n < max; i++) {
+            s_chunk[n] = s_block_items[i];
+            if (i + 1 < count) {
+                s_chunk_next[n] = (flash_ring_pos_t){ pos.seq, pos.offset, (uint16_t)(i + 1) };
+            } else {
+                s_chunk_next[n] = next;
+            }
+            n++;
+        }
+        pos = next;
     }
-    return st.st_size / sizeof(SensorData);
+    return n;
 }
 
-void offline_process_queue(send_data_callback_t send_func) {
-    const char *TEMP_PATH = "/storage/processing.bin";
-    
-    struct stat st;
-    if (stat(FILE_PATH, &st) != 0 || st.st_size == 0) {
-        return; // Pusto
+static bool budget_left(size_t sent, size_t max_records, int64_t deadline_us) {
+    return sent < max_records && esp_timer_get_time() < deadline_us;
+}
+
+// Od najstarszych: paczki od tail, tail przesuwany o potwierdzony prefiks.
+// Zwraca false, gdy wysyłka się nie powiodła.
+static bool drain_oldest_first(send_batch_callback_t send_func, size_t max_records, int64_t deadline_us,
+                               size_t *sent_total) {
+    while (budget_left(*sent_total, max_records, deadline_us)) {
+        lock();
+        flash_ring_pos_t start = flash_ring_tail();
+        size_t n = fill_chunk(start, max_records - *sent_total);
+        unlock();
+        if (n == 0) break;
+
+        size_t acked = send_func(s_chunk, n);
+
+        // Nic nie jest przepisywane - przesuwamy tylko tail o potwierdzony prefiks
+        if (acked > 0) {
+            lock();
+            // W trakcie wysyłki pełny pierścień mógł nadpisać najstarszy sektor i przesunąć tail
+            flash_ring_pos_t tail = flash_ring_tail();
+            if (!pos_before(&s_chunk_next[acked - 1], &tail)) {
+                flash_ring_consume(&s_chunk_next[acked - 1], acked);
+            }
+            unlock();
+            *sent_total += acked;
+        }
+
+        if (acked < n) {
+            return false;
+        }
     }
+    return true;
+}
+
+// Od najnowszych: całe wpisy od head wstecz, każdy oznaczany po potwierdzeniu (tail stoi).
+// Wpis pod tail (może być częściowo wysłany) zostaje dla drain_oldest_first.
+static bool drain_newest_first(send_batch_callback_t send_func, size_t max_records, int64_t deadline_us,
+                               size_t *sent_total) {
+    lock();
+    flash_ring_pos_t before = flash_ring_head();
+    unlock();
 
-    ESP_LOGI(TAG, "Przetwarzanie bufora offline (%ld bajtow)...", st.st_size);
+    while (budget_left(*sent_total, max_records, deadline_us)) {
+        lock();
+        flash_ring_pos_t tail = flash_ring_tail();
+        flash_ring_pos_t pos = before;
+        size_t len;
+        uint8_t version;
+        bool found = flash_ring_read_prev(&pos, s_entry_buf, sizeof(s_entry_buf), &len, &version) == ESP_OK &&
+                     pos_before(&tail, &pos);
+        size_t n = found ? entry_decode(s_entry_buf, len, version, s_chunk, DRAIN_CHUNK) : 0;
+        unlock();
+
+        if (!found) break;
+        before = pos;
+        if (n == 0) {
+            ESP_LOGW(TAG, "Nieznany format wpisu (v%d, %zu B) - pomijam", version, len);
+            continue;
+        }
+
+        // Częściowo potwierdzony wpis zostaje w całości - powtórkę odrzuci backend (seq)
+        if (send_func(s_chunk, n) < n) {
+            return false;
+        }
+
+        lock();
+        flash_ring_mark_consumed(&pos, n);
+        unlock();
+        *sent_total += n;
+    }
+    return true;
+}
+
+size_t offline_process_queue(send_batch_callback_t send_func, const offline_drain_budget_t *budget) {
+    lock();
+    size_t total = flash_ring_pending();
+    unlock();
+
+    if (total == 0) {
+        return 0; // Pusto
+    }
 
-    rename(FILE_PATH, TEMP_PATH);
+    size_t max_records = (budget != NULL && budget->max_records > 0) ? budget->max_records : SIZE_MAX;
+    int64_t deadline_us = (budget != NULL && budget->max_ms > 0) ?
+                          esp_timer_get_time() + (int64_t)budget->max_ms * 1000 : INT64_MAX;
+    bool newest_first = (budget != NULL && budget->order == OFFLINE_DRAIN_NEWEST_FIRST);
 
-    FILE* f_temp = fopen(TEMP_PATH, "rb");
-    if (f_temp == NULL) return;
+    ESP_LOGI(TAG, "Przetwarzanie bufora offline (%zu rekordow, od %s)...", total,
+             newest_first ? "najnowszych" : "najstarszych");
 
-    SensorData d;
-    bool sending_failed = false;
-    
-    while (fread(&d, sizeof(SensorData), 1, f_temp)) {
-        if (!sending_failed) {
-            bool success = send_func(d);
-            if (!success) {
-                sending_failed = true;
-                ESP_LOGW(TAG, "Wysylka nieudana, zachowuje reszte danych...");
+    size_t sent_total = 0;
+    bool ok = true;
+    if (newest_first) {
+        ok = drain_newest_first(send_func, max_records, deadline_us, &sent_total);
+    }
+    if (ok) {
+        ok = drain_oldest_first(send_func, max_records, deadline_us, &sent_total);
+    }
+    if (newest_first) {
+        // Wpisy wysłane od najnowszych są tylko oznaczone - tail przeskakuje te, które doszły do niego
+        lock();
+        flash_ring_skip_consumed();
+        unlock();
+    }
+
+    if (!ok) {
+        ESP_LOGW(TAG, "Wysylka nieudana, reszta danych zostaje w buforze...");
+    } else if (sent_total < total) {
+        ESP_LOGI(TAG, "Budzet wysylki wyczerpany - reszta w kolejnym cyklu");
+    }
+
+    ESP_LOGI(TAG, "Wyslano %zu/%zu rekordow z bufora", sent_total, total);
+    return sent_total;
+}
+
+esp_err_t offline_buffer_request_resend(int64_t from, int64_t to) {
+    if (to < from) return ESP_ERR_INVALID_ARG;
+
+    lock();
+    s_resend = (resend_req_t){ .from = from, .to = to };
+    s_resend_active = true;
+    s_resend_gen++;
+    esp_err_t err = storage_save_blob(RESEND_NVS_NAMESPACE, RESEND_NVS_KEY, &s_resend, sizeof(s_resend));
+    unlock();
+
+    ESP_LOGI(TAG, "Zlecono ponowna wysylke %" PRId64 "-%" PRId64, from, to);
+    return err;
+}
+
+bool offline_resend_pending(void) {
+    return s_resend_active;
+}
+
+// Wypełnia s_chunk rekordami z zakresu s_resend od pos (także już wysłanymi); zwraca ich liczbę.
+// *end = true gdy za pos nie ma już pasujących danych.
+static size_t fill_range_chunk(flash_ring_pos_t pos, size_t max, bool *end) {
+    flash_ring_pos_t next;
+    size_t len;
+    uint8_t version;
+    size_t n = 0;
+    esp_err_t err = ESP_OK;
+    if (max > DRAIN_CHUNK) max = DRAIN_CHUNK;
+
+    while (n < max) {
+        // Indeks sektorów pomija części pierścienia spoza zakresu bez czytania wpisów
+        err = flash_ring_seek(&pos, s_resend.from, s_resend.to);
+        if (err == ESP_OK) {
+            err = flash_ring_read_history(&pos, s_entry_buf, sizeof(s_entry_buf), &len, &version, &next);
+        }
+        if (err != ESP_OK) break;
+
+        size_t count = entry_decode(s_entry_buf, len, version, s_block_items, BLOCK_MAX_RECORDS);
+
+        for (size_t i = pos.item; i < count && n < max; i++) {
+            if (s_block_items[i].timestamp < s_resend.from || s_block_items[i].timestamp > s_resend.to) {
+                continue;
+            }
+            s_chunk[n] = s_block_items[i];
+            if (i + 1 < count) {
+                s_chunk_next[n] = (flash_ring_pos_t){ pos.seq, pos.offset, (uint16_t)(i + 1) };
+            } else {
+                s_chunk_next[n] = next;
             }
+            n++;
         }
+        pos = next;
+    }
+    *end = (err == ESP_ERR_NOT_FOUND);
+    return n;
+}
 
-        if (sending_failed) {
-            offline_buffer_add(d); 
-        } else {
-            ESP_LOGI(TAG, "Rekord z %lld wyslany!", d.timestamp);
+size_t offline_process_resend(send_batch_callback_t send_func, const offline_drain_budget_t *budget) {
+    if (!s_resend_active) return 0;
+
+    size_t max_records = (budget != NULL && budget->max_records > 0) ? budget->max_records : SIZE_MAX;
+    int64_t deadline_us = (budget != NULL && budget->max_ms > 0) ?
+                          esp_timer_get_time() + (int64_t)budget->max_ms * 1000 : INT64_MAX;
+
+    ESP_LOGI(TAG, "Ponowna wysylka zakresu %" PRId64 "-%" PRId64 "...", s_resend.from, s_resend.to);
+
+    size_t sent_total = 0;
+    while (budget_left(sent_total, max_records, deadline_us)) {
+        bool end = false;
+        lock();
+        uint32_t gen = s_resend_gen;
+        size_t n = fill_range_chunk(s_resend.pos, max_records - sent_total, &end);
+        if (n == 0 && end) {
+            // Cały zakres przejrzany
+            s_resend_active = false;
+            storage_erase_key(RESEND_NVS_NAMESPACE, RESEND_NVS_KEY);
+        }
+        unlock();
+        if (n == 0) {
+            if (end) {
+                ESP_LOGI(TAG, "Ponowna wysylka zakonczona");
+            } else {
+                ESP_LOGE(TAG, "Bufor offline niedostepny - ponowna wysylka odlozona");
+            }
+            break;
+        }
+
+        // Wysyłka bez blokady - w tym czasie może przyjść nowe zlecenie (zadanie esp-mqtt)
+        size_t acked = send_func(s_chunk, n);
+        if (acked > 0) {
+            lock();
+            if (gen == s_resend_gen) {
+                s_resend.pos = s_chunk_next[acked - 1];
+                storage_save_blob(RESEND_NVS_NAMESPACE, RESEND_NVS_KEY, &s_resend, sizeof(s_resend));
+            } else {
+                // Kursor dotyczy starego zakresu - nowy zaczyna się od początku
+                ESP_LOGI(TAG, "Zmieniono zakres ponownej wysylki w trakcie - start od nowa");
+            }
+            unlock();
+            sent_total += acked;
+        }
+
+        if (acked < n) {
+            ESP_LOGW(TAG, "Ponowna wysylka przerwana - kontynuacja w kolejnym cyklu");
+            break;
         }
     }
 
-    fclose(f_temp);
-    
-    unlink(TEMP_PATH);
-}
\ No newline at end of file
+    ESP_LOGI(TAG, "Ponownie wyslano %zu rekordow", sent_total);
+    return sent_total;
+}
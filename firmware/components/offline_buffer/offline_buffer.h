@@ -5,20 +5,38 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-// Struktura pojedynczego pomiaru
+// Zegar ustawiony (SNTP) - wcześniejszy czas to jeszcze 1970 po włączeniu zasilania
+#define MIN_VALID_TIMESTAMP     1609459200LL    // 2021-01-01
+
+// Struktura pojedynczego pomiaru.
+// Wariant agregatu (count > 0): podsumowanie okna czasu z aggregator.h -
+// timestamp = początek okna, temp = średnia, temp_min/temp_max, count = liczba próbek,
+// peak_dt = sekundy od początku okna do próbki z maksimum.
+// Zwykły pomiar ma count == 0 i wyzerowane pola agregatu.
+// seq - numer rekordu nadawany przez record_seq.h (rosnący przez restarty, 0 = brak numeru);
+// po nim backend odrzuca duplikaty z ponownych wysyłek.
 typedef struct {
     int64_t timestamp; // Unix timestamp
     float temp;
     uint32_t pressure;
     int sensor_id;
+    uint32_t seq;
+    uint32_t seq_epoch;   // epoka numeracji seq (record_seq.h), 0 = brak
+    float temp_min;
+    float temp_max;
+    uint16_t count;
+    uint16_t peak_dt;
 } SensorData;
 
-// Montuje system plików
+// Otwiera bufor pierścieniowy na partycji "storage" (migruje stary data.bin z SPIFFS)
 esp_err_t offline_buffer_init(void);
 
-// Dopisz pomiar na koniec pliku
+// Dopisz pomiar na koniec bufora
 esp_err_t offline_buffer_add(SensorData data);
 
+// Dopisz serię pomiarów (np. cały cykl) - pakowane są w skompresowane bloki
+esp_err_t offline_buffer_add_batch(const SensorData *data, size_t count);
+
 // Sprawdź ile mamy pomiarów w buforze
 size_t offline_buffer_count(void);
 
@@ -26,8 +44,38 @@ size_t offline_buffer_count(void);
 // Zwraca true jeśli wysyłka się udała, false jeśli błąd
 typedef bool (*send_data_callback_t)(SensorData data);
 
-// Przetwórz bufor: Czyta dane, wywołuje callback, 
-// i jeśli sukces - usuwa dane z pliku.
-void offline_process_queue(send_data_callback_t send_func);
+// Wysyłka serii pomiarów - zwraca ile pierwszych pomiarów zostało potwierdzonych
+typedef size_t (*send_batch_callback_t)(const SensorData *data, size_t count);
+
+typedef enum {
+    OFFLINE_DRAIN_OLDEST_FIRST = 0,
+    OFFLINE_DRAIN_NEWEST_FIRST,
+} offline_drain_order_t;
+
+// Limit jednego opróżniania bufora - bieżące pomiary nie czekają za tysiącami zaległych
+typedef struct {
+    size_t max_records;             // 0 = bez limitu
+    uint32_t max_ms;                // 0 = bez limitu czasu
+    offline_drain_order_t order;
+} offline_drain_budget_t;
+
+// Przetwórz bufor: czyta paczki danych, wywołuje callback i oznacza potwierdzone rekordy
+// jako wysłane. Po błędzie nic nie jest przepisywane.
+// Od najstarszych: tail przesuwany o potwierdzony prefiks. Od najnowszych: całe wpisy od końca,
+// oznaczane w nagłówku wpisu na flashu; na końcu ewentualna reszta od najstarszych.
+// budget == NULL - całość od najstarszych. Zwraca liczbę wysłanych rekordów.
+// Callback wołany jest bez blokady bufora - inny task może w tym czasie dopisywać pomiary.
+size_t offline_process_queue(send_batch_callback_t send_func, const offline_drain_budget_t *budget);
+
+// Zleca ponowną wysyłkę pomiarów z zakresu czasu [from, to] (Unix), także już wysłanych -
+// dopóki ich sektor nie został nadpisany nowymi danymi. Zlecenie trzymane jest w NVS
+// i zastępuje poprzednie. Można wołać przed offline_buffer_init.
+esp_err_t offline_buffer_request_resend(int64_t from, int64_t to);
+
+bool offline_resend_pending(void);
+
+// Wysyła kolejną porcję zleconego zakresu (w granicach budget, order ignorowane).
+// Zwraca liczbę wysłanych rekordów; po przejrzeniu całego zakresu zlecenie jest usuwane.
+size_t offline_process_resend(send_batch_callback_t send_func, const offline_drain_budget_t *budget);
 
 #endif // OFFLINE_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "record_seq.h"
+#include "storage_manager.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_random.h"
+
+static const char *TAG = "RECORD_SEQ";
+
+#define SEQ_NVS_NAMESPACE   "seq"
+#define SEQ_RTC_MAGIC       0x53455131
+
+// Zerowane przy zimnym starcie, zachowane w deep sleep
+static RTC_DATA_ATTR uint32_t s_magic;
+static RTC_DATA_ATTR uint32_t s_next;    // następny numer do nadania
+static RTC_DATA_ATTR uint32_t s_limit;   // koniec bloku zarezerwowanego w NVS (bez niego)
+static RTC_DATA_ATTR uint32_t s_epoch;
+
+esp_err_t record_seq_init(void) {
+    if (s_magic == SEQ_RTC_MAGIC && s_next <= s_limit) {
+        return ESP_OK;  // wybudzenie z deep sleep - blok nadal zarezerwowany
+    }
+
+    // Numery poniżej zapisanej granicy mogły już zostać użyte
+    int32_t stored, epoch;
+    storage_load_i32(SEQ_NVS_NAMESPACE, "limit", &stored, 0);
+    if (stored != 0) {
+        storage_load_i32(SEQ_NVS_NAMESPACE, "epoch", &epoch, 0);
+    } else {
+        // Brak licznika: numery od 1 mogły już być użyte przed resetem NVS - nowa epoka.
+        // Zapis przed pierwszą rezerwacją bloku, żeby limit nigdy nie istniał bez swojej epoki.
+        do {
+            epoch = (int32_t)esp_random();
+        } while (epoch == 0);
+        if (storage_save_i32(SEQ_NVS_NAMESPACE, "epoch", epoch) != ESP_OK) {
+            ESP_LOGE(TAG, "Nie udalo sie zapisac epoki numeracji");
+        }
+    }
+    s_next = ((uint32_t)stored != 0) ? (uint32_t)stored : 1;
+    s_limit = s_next;
+    s_epoch = (uint32_t)epoch;
+    s_magic = SEQ_RTC_MAGIC;
+
+    ESP_LOGI(TAG, "Numeracja rekordow od %lu (epoka %08lx)", (unsigned long)s_next, (unsigned long)s_epoch);
+    return ESP_OK;
+}
+
+static void reserve_block(void) {
+    uint32_t limit = s_next + RECORD_SEQ_BLOCK;
+    if (limit < s_next) {
+        limit = UINT32_MAX;     // przepełnienie licznika - przy 3 rekordach/s po ~45 latach
+    }
+
+    if (storage_save_i32(SEQ_NVS_NAMESPACE, "limit", (int32_t)limit) != ESP_OK) {
+        ESP_LOGE(TAG, "Nie udalo sie zarezerwowac bloku numerow - po restarcie mozliwe duplikaty");
+    }
+    s_limit = limit;
+}
+
+void record_seq_assign(SensorData *records, size_t count) {
+    if (s_magic != SEQ_RTC_MAGIC) {
+        record_seq_init();
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (s_next >= s_limit) {
+            reserve_block();
+        }
+        records[i].seq = s_next++;
+        records[i].seq_epoch = s_epoch;
+    }
+}
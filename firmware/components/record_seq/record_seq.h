@@ -0,0 +1,26 @@
+#ifndef RECORD_SEQ_H
+#define RECORD_SEQ_H
+
+#include "esp_err.h"
+#include "offline_buffer.h"
+#include <stddef.h>
+
+// Numer sekwencyjny rekordu (SensorData.seq): rośnie monotonicznie przez restarty i deep sleep.
+// Backend odrzuca powtórzony (device_id, seq), więc ponowna wysyłka po zaniku zasilania
+// albo braku PUBACK nie tworzy duplikatów.
+// W NVS (namespace "seq", klucz "limit") zapisywany jest tylko koniec zarezerwowanego bloku
+// numerów - jeden zapis na RECORD_SEQ_BLOCK rekordów. Po restarcie reszta bloku przepada
+// (luka w numeracji, nigdy powtórzony numer). Licznik w pamięci RTC przetrwa deep sleep.
+// Bez licznika w NVS (nowe urządzenie, erase-flash, reset NVS) numeracja startuje od 1
+// z nową, losową epoką - backend trzyma unikalność po (device_id, epoka, seq), więc nowe
+// rekordy nie trafiają na stare numery. Epoka jest zapisywana w rekordzie (SensorData.seq_epoch)
+// razem z numerem, więc rekordy z bufora offline idą zawsze z epoką, w której je numerowano.
+
+#define RECORD_SEQ_BLOCK    256
+
+esp_err_t record_seq_init(void);
+
+// Nadaje kolejne numery (seq i seq_epoch) rekordom (woła tylko task pomiarów)
+void record_seq_assign(SensorData *records, size_t count);
+
+#endif // RECORD_SEQ_H
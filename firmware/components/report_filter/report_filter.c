@@ -0,0 +1,82 @@
+#include "report_filter.h"
+#include "storage_manager.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <inttypes.h>
+#include <math.h>
+
+static const char *TAG = "REPORT_FILTER";
+
+#define REPORT_NVS_NAMESPACE    "report"
+#define REPORT_MAX_SENSORS      32
+
+typedef struct {
+    float value;
+    int64_t timestamp;
+    bool valid;
+} last_report_t;
+
+static float s_epsilon = CONFIG_HIVE_DEADBAND_EPSILON / 100.0f;
+static int64_t s_heartbeat_s = CONFIG_HIVE_DEADBAND_HEARTBEAT_S;
+
+static RTC_DATA_ATTR last_report_t s_last[REPORT_MAX_SENSORS];
+
+esp_err_t report_filter_init(void) {
+    int32_t eps, hb;
+    storage_load_i32(REPORT_NVS_NAMESPACE, "eps", &eps, CONFIG_HIVE_DEADBAND_EPSILON);
+    storage_load_i32(REPORT_NVS_NAMESPACE, "hb", &hb, CONFIG_HIVE_DEADBAND_HEARTBEAT_S);
+
+    s_epsilon = (eps >= 0) ? eps / 100.0f : CONFIG_HIVE_DEADBAND_EPSILON / 100.0f;
+    s_heartbeat_s = (hb > 0) ? hb : CONFIG_HIVE_DEADBAND_HEARTBEAT_S;
+    ESP_LOGI(TAG, "Deadband %.2f C, heartbeat %" PRId64 " s", s_epsilon, s_heartbeat_s);
+    return ESP_OK;
+}
+
+esp_err_t report_filter_set(uint32_t epsilon_c100, uint32_t heartbeat_s) {
+    if (heartbeat_s == 0) return ESP_ERR_INVALID_ARG;
+
+    s_epsilon = epsilon_c100 / 100.0f;
+    s_heartbeat_s = heartbeat_s;
+
+    esp_err_t ret = storage_begin(REPORT_NVS_NAMESPACE);
+    if (ret != ESP_OK) return ret;
+
+    storage_save_i32(REPORT_NVS_NAMESPACE, "eps", (int32_t)epsilon_c100);
+    storage_save_i32(REPORT_NVS_NAMESPACE, "hb", (int32_t)heartbeat_s);
+    return storage_commit(REPORT_NVS_NAMESPACE);
+}
+
+static bool should_report(const SensorData *d) {
+    const last_report_t *last = &s_last[d->sensor_id];
+    if (!last->valid) return true;
+    if (fabsf(d->temp - last->value) > s_epsilon) return true;
+    // Agregat: skok w oknie (min/max) też jest istotną zmianą, nawet gdy średnia stoi
+    if (d->count > 0 && (fabsf(d->temp_max - last->value) > s_epsilon ||
+                         fabsf(d->temp_min - last->value) > s_epsilon)) {
+        return true;
+    }
+    // Cofnięty zegar (np. synchronizacja SNTP) traktujemy jak minięty heartbeat
+    return d->timestamp < last->timestamp || d->timestamp - last->timestamp >= s_heartbeat_s;
+}
+
+size_t report_filter_apply(SensorData *readings, size_t count, bool force) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        int id = readings[i].sensor_id;
+        bool report = (id < 0 || id >= REPORT_MAX_SENSORS) || force || should_report(&readings[i]);
+
+        if (!report) {
+            ESP_LOGD(TAG, "ID[%d]: %.2f C bez zmian - pomijam", id, readings[i].temp);
+            continue;
+        }
+        if (id >= 0 && id < REPORT_MAX_SENSORS) {
+            s_last[id] = (last_report_t){ readings[i].temp, readings[i].timestamp, true };
+        }
+        readings[kept++] = readings[i];
+    }
+
+    if (kept < count) {
+        ESP_LOGI(TAG, "Do wysylki %zu z %zu pomiarow (reszta w deadbandzie)", kept, count);
+    }
+    return kept;
+}
@@ -0,0 +1,23 @@
+#ifndef REPORT_FILTER_H
+#define REPORT_FILTER_H
+
+#include "esp_err.h"
+#include "offline_buffer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Raportowanie przy zmianie (deadband): pomiar czujnika przechodzi dalej tylko, gdy różni się
+// od ostatnio przepuszczonego o więcej niż epsilon albo minął heartbeat. Dzięki heartbeatowi
+// backend odróżni stabilną temperaturę od martwego urządzenia.
+// Konfiguracja w NVS (namespace "report": "eps" w 0.01 C, "hb" w sekundach), domyślnie z Kconfig.
+// Ostatnie wartości trzymane w pamięci RTC (przetrwają deep sleep).
+
+esp_err_t report_filter_init(void);
+
+// Usuwa z tablicy pomiary bez istotnej zmiany (kolejność zachowana), zwraca nową liczbę.
+// force = przepuść wszystko (np. zmiana stanu alarmu), ale zaktualizuj ostatnie wartości.
+size_t report_filter_apply(SensorData *readings, size_t count, bool force);
+
+esp_err_t report_filter_set(uint32_t epsilon_c100, uint32_t heartbeat_s);
+
+#endif // REPORT_FILTER_H
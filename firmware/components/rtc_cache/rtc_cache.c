@@ -0,0 +1,41 @@
+#include "rtc_cache.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "RTC_CACHE";
+
+// Zmienne RTC_DATA_ATTR są zerowane tylko przy zimnym starcie
+static RTC_DATA_ATTR SensorData s_readings[RTC_CACHE_CAPACITY];
+static RTC_DATA_ATTR uint32_t s_count;
+static RTC_DATA_ATTR uint32_t s_wake_count;
+
+uint32_t rtc_cache_next_wake(void) {
+    return ++s_wake_count;
+}
+
+bool rtc_cache_add(const SensorData *data, size_t count) {
+    if (s_count > RTC_CACHE_CAPACITY) {
+        ESP_LOGW(TAG, "Uszkodzony licznik (%lu) - czyszcze", (unsigned long)s_count);
+        s_count = 0;
+    }
+    if (count > RTC_CACHE_CAPACITY - s_count) {
+        return false;
+    }
+    memcpy(&s_readings[s_count], data, count * sizeof(SensorData));
+    s_count += count;
+    ESP_LOGD(TAG, "W pamieci RTC: %lu/%d pomiarow", (unsigned long)s_count, RTC_CACHE_CAPACITY);
+    return true;
+}
+
+size_t rtc_cache_count(void) {
+    return (s_count <= RTC_CACHE_CAPACITY) ? s_count : 0;
+}
+
+const SensorData *rtc_cache_data(void) {
+    return s_readings;
+}
+
+void rtc_cache_clear(void) {
+    s_count = 0;
+}
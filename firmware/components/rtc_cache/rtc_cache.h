@@ -0,0 +1,27 @@
+#ifndef RTC_CACHE_H
+#define RTC_CACHE_H
+
+#include "offline_buffer.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bufor pomiarów w pamięci RTC (przetrwa deep sleep, znika po zaniku zasilania).
+// Pozwala zbierać pomiary z kilku wybudzeń bez włączania radia i bez zapisu do flasha.
+
+#define RTC_CACHE_CAPACITY  96
+
+// Licznik wybudzeń od ostatniego resetu zasilania (zwiększany przy każdym wywołaniu)
+uint32_t rtc_cache_next_wake(void);
+
+// Dopisuje pomiary; false gdy się nie mieszczą (nic nie jest zapisywane)
+bool rtc_cache_add(const SensorData *data, size_t count);
+
+size_t rtc_cache_count(void);
+
+// Wskaźnik na zebrane pomiary (od najstarszego)
+const SensorData *rtc_cache_data(void);
+
+void rtc_cache_clear(void);
+
+#endif // RTC_CACHE_H
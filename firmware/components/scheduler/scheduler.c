@@ -0,0 +1,154 @@
+#include "scheduler.h"
+#include "storage_manager.h"
+#include "offline_buffer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include <sys/time.h>
+#include <stdio.h>
+
+static const char *TAG = "SCHEDULER";
+
+#define SCHED_NVS_NAMESPACE     "sched"
+#define MAX_PERIOD_S            86400
+// Dłuższe oczekiwanie dzielimy, żeby zauważyć przestawienie zegara przez SNTP
+#define MAX_SLEEP_CHUNK_MS      60000
+
+static uint32_t s_periods[SCHEDULER_MAX_SENSORS];
+static uint32_t s_uplink_period = SCHEDULER_DEFAULT_PERIOD_S;
+static int s_sensor_count = 0;
+
+static int64_t s_last_slot = -1;
+static bool s_last_synced = false;
+static bool s_first_slot = true;
+
+static void period_key(int id, char *key, size_t len) {
+    snprintf(key, len, "per%d", id);
+}
+
+static uint32_t load_period(const char *key) {
+    int32_t value;
+    storage_load_i32(SCHED_NVS_NAMESPACE, key, &value, SCHEDULER_DEFAULT_PERIOD_S);
+    if (value < 1 || value > MAX_PERIOD_S) {
+        ESP_LOGW(TAG, "Bledny okres '%s' = %ld, uzywam %d s", key, (long)value, SCHEDULER_DEFAULT_PERIOD_S);
+        return SCHEDULER_DEFAULT_PERIOD_S;
+    }
+    return (uint32_t)value;
+}
+
+esp_err_t scheduler_init(int sensor_count) {
+    s_sensor_count = (sensor_count < SCHEDULER_MAX_SENSORS) ? sensor_count : SCHEDULER_MAX_SENSORS;
+
+    char key[16];
+    for (int i = 0; i < s_sensor_count; i++) {
+        period_key(i, key, sizeof(key));
+        s_periods[i] = load_period(key);
+        ESP_LOGI(TAG, "Czujnik ID[%d]: pomiar co %lu s", i, (unsigned long)s_periods[i]);
+    }
+    s_uplink_period = load_period("uplink");
+    ESP_LOGI(TAG, "Wysylka co %lu s", (unsigned long)s_uplink_period);
+    return ESP_OK;
+}
+
+esp_err_t scheduler_set_sensor_period(int sensor_id, uint32_t seconds) {
+    if (sensor_id < 0 || sensor_id >= SCHEDULER_MAX_SENSORS || seconds < 1 || seconds > MAX_PERIOD_S) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    char key[16];
+    period_key(sensor_id, key, sizeof(key));
+    s_periods[sensor_id] = seconds;
+    return storage_save_i32(SCHED_NVS_NAMESPACE, key, (int32_t)seconds);
+}
+
+esp_err_t scheduler_set_uplink_period(uint32_t seconds) {
+    if (seconds < 1 || seconds > MAX_PERIOD_S) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_uplink_period = seconds;
+    return storage_save_i32(SCHED_NVS_NAMESPACE, "uplink", (int32_t)seconds);
+}
+
+// Bieżąca chwila w us: czas rzeczywisty po synchronizacji, inaczej czas od startu
+static int64_t clock_now_us(bool *synced) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    *synced = (tv.tv_sec >= MIN_VALID_TIMESTAMP);
+    if (*synced) {
+        return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+    }
+    return esp_timer_get_time();
+}
+
+static inline int64_t next_multiple(int64_t after, uint32_t period) {
+    return (after / period + 1) * period;
+}
+
+int64_t scheduler_us_until_aligned(uint32_t period_s) {
+    bool synced;
+    int64_t now_us = clock_now_us(&synced);
+    if (period_s == 0) return 0;
+    return next_multiple(now_us / 1000000LL, period_s) * 1000000LL - now_us;
+}
+
+scheduler_slot_t scheduler_wait_next(uint32_t watch_ms) {
+    int64_t next;
+    bool synced;
+    int64_t watch_deadline_us = esp_timer_get_time() + (int64_t)watch_ms * 1000;
+
+    if (s_first_slot) {
+        // Zaraz po starcie: pomiar wszystkich czujników i wysyłka (m.in. synchronizacja czasu)
+        s_first_slot = false;
+        int64_t now_s = clock_now_us(&synced) / 1000000LL;
+        s_last_synced = synced;
+        s_last_slot = now_s;
+        scheduler_slot_t slot = { .at = now_s, .synced = synced, .sensor_mask = 0, .uplink = true, .watch = false };
+        for (int i = 0; i < s_sensor_count; i++) slot.sensor_mask |= (1UL << i);
+        return slot;
+    }
+
+    while (true) {
+        int64_t now_us = clock_now_us(&synced);
+        if (synced != s_last_synced) {
+            // Zmiana zegara (synchronizacja SNTP) - stare chwile nieporównywalne
+            s_last_slot = -1;
+            s_last_synced = synced;
+        }
+
+        // Sekunda wstecz, żeby nie zgubić chwili, na którą obudziliśmy się z lekkim opóźnieniem
+        int64_t after = now_us / 1000000LL - 1;
+        if (after < s_last_slot) after = s_last_slot;
+
+        next = next_multiple(after, s_uplink_period);
+        for (int i = 0; i < s_sensor_count; i++) {
+            int64_t t = next_multiple(after, s_periods[i]);
+            if (t < next) next = t;
+        }
+
+        int64_t delay_us = next * 1000000LL - now_us;
+        if (delay_us <= 0) break;
+
+        if (watch_ms > 0) {
+            int64_t watch_left_us = watch_deadline_us - esp_timer_get_time();
+            if (watch_left_us <= 0) {
+                scheduler_slot_t slot = { .at = now_us / 1000000LL, .synced = synced,
+                                          .sensor_mask = 0, .uplink = false, .watch = true };
+                return slot;
+            }
+            if (watch_left_us < delay_us) delay_us = watch_left_us;
+        }
+
+        int64_t delay_ms = delay_us / 1000 + 1;
+        if (delay_ms > MAX_SLEEP_CHUNK_MS) delay_ms = MAX_SLEEP_CHUNK_MS;
+        vTaskDelay(pdMS_TO_TICKS(delay_ms) > 0 ? pdMS_TO_TICKS(delay_ms) : 1);
+    }
+
+    s_last_slot = next;
+
+    scheduler_slot_t slot = { .at = next, .synced = synced, .sensor_mask = 0, .uplink = false, .watch = false };
+    for (int i = 0; i < s_sensor_count; i++) {
+        if (next % s_periods[i] == 0) slot.sensor_mask |= (1UL << i);
+    }
+    slot.uplink = (next % s_uplink_period == 0);
+    return slot;
+}
@@ -0,0 +1,38 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Harmonogram pomiarów wyrównany do zegara: czujnik z okresem P sekund mierzony jest
+// w chwilach t, dla których t % P == 0 (np. 300 s -> :00, :05, :10...), wysyłka tak samo
+// ze swoim okresem. Okresy trzymane w NVS (namespace "sched"):
+//   "per<ID>" - okres pomiaru czujnika, "uplink" - okres wysyłki.
+// Dopóki zegar nie jest zsynchronizowany, odliczanie idzie od startu układu (bez wyrównania).
+
+#define SCHEDULER_MAX_SENSORS       32
+#define SCHEDULER_DEFAULT_PERIOD_S  300
+
+typedef struct {
+    int64_t at;             // zaplanowana chwila (Unix time, gdy synced)
+    bool synced;            // czy 'at' to czas rzeczywisty
+    uint32_t sensor_mask;   // czujniki do odczytu w tej chwili (bit i = ID i)
+    bool uplink;            // czas na wysyłkę
+    bool watch;             // pomiar kontrolny (minął watch_ms, nic nie było zaplanowane)
+} scheduler_slot_t;
+
+esp_err_t scheduler_init(int sensor_count);
+
+// Blokuje do najbliższej zaplanowanej chwili i zwraca co jest w niej do zrobienia.
+// watch_ms > 0: wraca najpóźniej po tym czasie ze slotem "watch" (np. szybkie sprawdzanie alarmów).
+scheduler_slot_t scheduler_wait_next(uint32_t watch_ms);
+
+esp_err_t scheduler_set_sensor_period(int sensor_id, uint32_t seconds);
+
+esp_err_t scheduler_set_uplink_period(uint32_t seconds);
+
+// Ile mikrosekund do najbliższej wielokrotności okresu (do wybudzeń z deep sleep)
+int64_t scheduler_us_until_aligned(uint32_t period_s);
+
+#endif // SCHEDULER_H
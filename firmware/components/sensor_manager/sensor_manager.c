@@ -0,0 +1,419 @@
+#include "sensor_manager.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "onewire_bus.h"
+#include "ds18b20.h"
+#include "storage_manager.h"
+#include "diag.h"
+#include "esp_attr.h"
+#include <inttypes.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *TAG = "SENSOR_MGR";
+
+// Komendy OneWire / DS18B20
+#define OW_CMD_SKIP_ROM          0xCC
+#define DS18B20_CMD_CONVERT_T    0x44
+
+// Rozdzielczość per czujnik w NVS: namespace "sensors", klucz "res<ID>" (9..12 bitów)
+#define SENSOR_NVS_NAMESPACE     "sensors"
+#define SENSOR_DEFAULT_RES_BITS  CONFIG_HIVE_DS18B20_RESOLUTION
+
+// Odpytywanie magistrali o koniec konwersji (tylko przy zasilaniu zewnętrznym)
+#define CONVERSION_POLL_MS       10
+#define CONVERSION_MARGIN_MS     20
+
+#define SENSOR_INVALID_TEMP      -127.0f
+
+// Tabela kod ROM -> ID logiczne w NVS: namespace "sensors", klucz "rom" dla magistrali 0
+// i "rom<N>" dla kolejnych (indeks = numer czujnika na magistrali, 0 = wolne)
+#define SENSOR_ROM_KEY           "rom"
+
+// Magistrale i tablice czujników przydzielane przy starcie wg liczby GPIO.
+// ID = magistrala * s_per_bus + numer na magistrali.
+static onewire_bus_handle_t *s_buses = NULL;
+static int s_bus_count = 0;
+static int s_per_bus = 0;
+
+static ds18b20_device_handle_t *s_sensors = NULL;
+static onewire_device_address_t *s_rom = NULL;
+static uint8_t *s_resolution_bits = NULL;
+static int s_sensor_count = 0;
+
+// Czujniki z tabeli nieobecne przy ostatnim pełnym skanie - ich brak przy starcie
+// nie wymusza kolejnego skanu (do najbliższego sprawdzenia podłączeń)
+static RTC_DATA_ATTR uint32_t s_missing_mask = 0;
+
+// Maksymalny czas konwersji wg noty katalogowej: 93.75 / 187.5 / 375 / 750 ms
+static uint32_t conversion_time_ms(uint8_t bits) {
+    switch (bits) {
+        case 9:  return 94;
+        case 10: return 188;
+        case 11: return 375;
+        default: return 750;
+    }
+}
+
+static void resolution_key(int id, char *key, size_t len) {
+    snprintf(key, len, "res%d", id);
+}
+
+static esp_err_t apply_resolution(int id, uint8_t bits) {
+    esp_err_t ret = ds18b20_set_resolution(s_sensors[id], (ds18b20_resolution_t)(bits - 9));
+    if (ret == ESP_OK) {
+        s_resolution_bits[id] = bits;
+        ESP_LOGI(TAG, "ID[%d]: rozdzielczość %d bit (konwersja %lu ms)", id, bits,
+                 (unsigned long)conversion_time_ms(bits));
+    } else {
+        ESP_LOGE(TAG, "ID[%d]: nie udalo sie ustawic rozdzielczosci (%s)", id, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+static void load_resolution(int id) {
+    char key[16];
+    int32_t bits;
+    resolution_key(id, key, sizeof(key));
+    storage_load_i32(SENSOR_NVS_NAMESPACE, key, &bits, SENSOR_DEFAULT_RES_BITS);
+    if (bits < 9 || bits > 12) {
+        ESP_LOGW(TAG, "ID[%d]: bledna rozdzielczosc w NVS (%ld), uzywam %d", id, (long)bits, SENSOR_DEFAULT_RES_BITS);
+        bits = SENSOR_DEFAULT_RES_BITS;
+    }
+    // Czujnik startuje w 12 bitach - przy błędzie zapisu tyle trzeba czekać
+    s_resolution_bits[id] = 12;
+    apply_resolution(id, (uint8_t)bits);
+}
+
+// Tworzy uchwyt czujnika bezpośrednio z kodu ROM (bez przeszukiwania magistrali)
+static esp_err_t attach_sensor(int id, onewire_device_address_t rom) {
+    if (s_sensors[id] != NULL) {
+        ds18b20_del_device(s_sensors[id]);
+        s_sensors[id] = NULL;
+    }
+
+    onewire_device_t device = {
+        .bus = s_buses[id / s_per_bus],
+        .address = rom,
+    };
+    ds18b20_config_t ds_cfg = {};
+    esp_err_t ret = ds18b20_new_device_from_enumeration(&device, &ds_cfg, &s_sensors[id]);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ID[%d]: %016" PRIX64 " to nie DS18B20 (%s)", id, rom, esp_err_to_name(ret));
+        return ret;
+    }
+
+    s_rom[id] = rom;
+    if (id >= s_sensor_count) s_sensor_count = id + 1;
+    load_resolution(id);
+    return ESP_OK;
+}
+
+// Szuka kodu ROM wśród ID magistrali (rom = 0 -> pierwsze wolne ID)
+static int find_rom(int bus, onewire_device_address_t rom) {
+    for (int i = bus * s_per_bus; i < (bus + 1) * s_per_bus; i++) {
+        if (s_rom[i] == rom) return i;
+    }
+    return -1;
+}
+
+static void rom_key(int bus, char *key, size_t len) {
+    if (bus == 0) {
+        snprintf(key, len, SENSOR_ROM_KEY);     // klucz sprzed obsługi wielu magistral
+    } else {
+        snprintf(key, len, SENSOR_ROM_KEY "%d", bus);
+    }
+}
+
+// Szybki start: czujniki z tabeli w NVS, obecność sprawdzana odczytem scratchpadu (CRC).
+// Zwraca false, gdy tabeli nie ma albo brakuje czujnika, który był przy ostatnim skanie.
+static bool attach_from_cache(int bus) {
+    char key[16];
+    onewire_device_address_t *table = &s_rom[bus * s_per_bus];
+    rom_key(bus, key, sizeof(key));
+    if (storage_load_blob(SENSOR_NVS_NAMESPACE, key, table, s_per_bus * sizeof(*table)) != ESP_OK) {
+        ESP_LOGI(TAG, "Magistrala %d: brak tabeli ROM w NVS - pelny skan", bus);
+        for (int i = 0; i < s_per_bus; i++) table[i] = 0;
+        return false;
+    }
+
+    bool complete = true;
+    for (int i = bus * s_per_bus; i < (bus + 1) * s_per_bus; i++) {
+        if (s_rom[i] == 0) continue;
+        if (attach_sensor(i, s_rom[i]) != ESP_OK) {
+            complete = false;
+            continue;
+        }
+
+        float temperature;
+        if (!(s_missing_mask & (1UL << i)) && ds18b20_get_temperature(s_sensors[i], &temperature) != ESP_OK) {
+            ESP_LOGW(TAG, "ID[%d] (%016" PRIX64 ") nie odpowiada", i, s_rom[i]);
+            complete = false;
+        }
+    }
+    return complete;
+}
+
+static esp_err_t rescan_bus(int bus) {
+    onewire_device_address_t found[SENSOR_MANAGER_MAX_SENSORS];
+    int found_count = 0;
+
+    onewire_device_iter_handle_t iter = NULL;
+    onewire_device_t next_onewire_device;
+    esp_err_t search_result = ESP_OK;
+
+    esp_err_t ret = onewire_new_device_iter(s_buses[bus], &iter);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ESP_LOGI(TAG, "Magistrala %d: szukanie urządzeń...", bus);
+
+    do {
+        search_result = onewire_device_iter_get_next(iter, &next_onewire_device);
+        if (search_result == ESP_OK) {
+            found[found_count++] = next_onewire_device.address;
+        }
+    } while (search_result != ESP_ERR_NOT_FOUND && found_count < s_per_bus);
+
+    onewire_del_device_iter(iter);
+
+    // Znane czujniki zachowują ID; brakujące zostają w tabeli (odczyt -127, backend zobaczy awarię)
+    int first = bus * s_per_bus;
+    uint32_t present = 0;
+    for (int f = 0; f < found_count; f++) {
+        int id = find_rom(bus, found[f]);
+        if (id >= 0) present |= 1UL << id;
+    }
+
+    bool changed = false;
+    for (int f = 0; f < found_count; f++) {
+        if (find_rom(bus, found[f]) >= 0) continue;
+
+        // Nowy czujnik: pierwsze wolne ID, a gdy tabela pełna - ID czujnika, którego już nie ma
+        int id = find_rom(bus, 0);
+        for (int i = first; id < 0 && i < first + s_per_bus; i++) {
+            if (!(present & (1UL << i))) id = i;
+        }
+        if (id < 0) {
+            ESP_LOGW(TAG, "Magistrala %d: brak wolnego ID dla %016" PRIX64, bus, found[f]);
+            continue;
+        }
+
+        if (attach_sensor(id, found[f]) == ESP_OK) {
+            ESP_LOGI(TAG, "Znaleziono DS18B20 %016" PRIX64 " -> ID: %d", found[f], id);
+            present |= 1UL << id;
+            changed = true;
+        }
+    }
+
+    for (int i = first; i < first + s_per_bus; i++) {
+        s_missing_mask &= ~(1UL << i);
+        if (s_rom[i] != 0 && !(present & (1UL << i))) {
+            ESP_LOGW(TAG, "ID[%d] (%016" PRIX64 ") nieobecny na magistrali", i, s_rom[i]);
+            s_missing_mask |= 1UL << i;
+        }
+    }
+
+    if (changed) {
+        char key[16];
+        rom_key(bus, key, sizeof(key));
+        storage_save_blob(SENSOR_NVS_NAMESPACE, key, &s_rom[first], s_per_bus * sizeof(*s_rom));
+    }
+
+    ESP_LOGI(TAG, "Magistrala %d: %d czujników.", bus, found_count);
+    return ESP_OK;
+}
+
+esp_err_t sensor_manager_rescan(void) {
+    esp_err_t ret = ESP_OK;
+    for (int b = 0; b < s_bus_count; b++) {
+        esp_err_t bus_ret = rescan_bus(b);
+        if (bus_ret != ESP_OK) {
+            ESP_LOGE(TAG, "Magistrala %d: blad skanu (%s)", b, esp_err_to_name(bus_ret));
+            ret = bus_ret;
+        }
+    }
+    ESP_LOGI(TAG, "Czujniki w użyciu: ID 0..%d.", s_sensor_count - 1);
+    return ret;
+}
+
+esp_err_t sensor_manager_init(const gpio_num_t *gpios, int bus_count) {
+    // ID muszą się zmieścić w masce 32-bitowej (sensor_manager_read, scheduler)
+    s_per_bus = CONFIG_HIVE_ONEWIRE_SENSORS_PER_BUS;
+    if (bus_count * s_per_bus > SENSOR_MANAGER_MAX_SENSORS) {
+        ESP_LOGW(TAG, "Za duzo magistral (%d x %d czujnikow) - uzywam %d", bus_count, s_per_bus,
+                 SENSOR_MANAGER_MAX_SENSORS / s_per_bus);
+        bus_count = SENSOR_MANAGER_MAX_SENSORS / s_per_bus;
+    }
+    if (bus_count <= 0) return ESP_ERR_INVALID_ARG;
+
+    int capacity = bus_count * s_per_bus;
+    s_buses = calloc(bus_count, sizeof(*s_buses));
+    s_sensors = calloc(capacity, sizeof(*s_sensors));
+    s_rom = calloc(capacity, sizeof(*s_rom));
+    s_resolution_bits = calloc(capacity, sizeof(*s_resolution_bits));
+    if (!s_buses || !s_sensors || !s_rom || !s_resolution_bits) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Każda magistrala na własnych kanałach RMT
+    onewire_bus_rmt_config_t rmt_config = {
+        .max_rx_bytes = 10,
+    };
+
+    bool complete = true;
+    for (int b = 0; b < bus_count; b++) {
+        onewire_bus_config_t bus_config = {
+            .bus_gpio_num = gpios[b],
+        };
+
+        ESP_LOGI(TAG, "Inicjalizacja OneWire %d na GPIO %d...", b, gpios[b]);
+        esp_err_t ret = onewire_new_bus_rmt(&bus_config, &rmt_config, &s_buses[b]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Nie udalo sie utworzyc magistrali (%s)", esp_err_to_name(ret));
+            return ret;
+        }
+        s_bus_count = b + 1;
+
+        if (!attach_from_cache(b)) complete = false;
+    }
+
+    if (complete) {
+        ESP_LOGI(TAG, "Czujniki z tabeli ROM: ID 0..%d", s_sensor_count - 1);
+        return ESP_OK;
+    }
+    return sensor_manager_rescan();
+}
+
+int sensor_manager_count(void) {
+    return s_sensor_count;
+}
+
+esp_err_t sensor_manager_set_resolution(int id, uint8_t bits) {
+    if (id < 0 || id >= s_sensor_count || s_sensors[id] == NULL || bits < 9 || bits > 12) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = apply_resolution(id, bits);
+    if (ret == ESP_OK) {
+        char key[16];
+        resolution_key(id, key, sizeof(key));
+        ret = storage_save_i32(SENSOR_NVS_NAMESPACE, key, bits);
+    }
+    return ret;
+}
+
+// Maska magistral, na których jest choć jeden czujnik z maski ID
+static uint32_t buses_in_mask(uint32_t mask) {
+    uint32_t buses = 0;
+    for (int i = 0; i < s_sensor_count; i++) {
+        if ((mask & (1UL << i)) && s_sensors[i] != NULL) buses |= 1UL << (i / s_per_bus);
+    }
+    return buses;
+}
+
+// Rozkaz konwersji do wszystkich urządzeń na magistrali jednocześnie
+static esp_err_t trigger_conversion(int bus) {
+    esp_err_t ret = onewire_bus_reset(s_buses[bus]);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    const uint8_t cmd[] = { OW_CMD_SKIP_ROM, DS18B20_CMD_CONVERT_T };
+    return onewire_bus_write_bytes(s_buses[bus], cmd, sizeof(cmd));
+}
+
+// Czeka na koniec konwersji najwolniejszego czujnika (wynika z jego rozdzielczości).
+// Konwersje na wszystkich magistralach trwają równolegle, więc czekamy raz.
+// Przy zasilaniu zewnętrznym DS18B20 odpowiada 0 na slot odczytu dopóki mierzy,
+// więc można skończyć wcześniej odpytując magistrale.
+static void wait_for_conversion(uint32_t mask, uint32_t buses) {
+    uint32_t wait_ms = 0;
+    for (int i = 0; i < s_sensor_count; i++) {
+        if (!(mask & (1UL << i))) continue;
+        uint32_t t = conversion_time_ms(s_resolution_bits[i]);
+        if (t > wait_ms) wait_ms = t;
+    }
+
+#if CONFIG_HIVE_DS18B20_POLL_CONVERSION
+    TickType_t start = xTaskGetTickCount();
+    TickType_t limit = pdMS_TO_TICKS(wait_ms + CONVERSION_MARGIN_MS);
+    while (xTaskGetTickCount() - start < limit) {
+        vTaskDelay(pdMS_TO_TICKS(CONVERSION_POLL_MS));
+        for (int b = 0; b < s_bus_count; b++) {
+            uint8_t done = 0;
+            if ((buses & (1UL << b)) && onewire_bus_read_bit(s_buses[b], &done) == ESP_OK && done) {
+                buses &= ~(1UL << b);
+            }
+        }
+        if (buses == 0) {
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "Brak sygnalu konca konwersji po %lu ms", (unsigned long)(wait_ms + CONVERSION_MARGIN_MS));
+#else
+    (void)buses;    // bez odpytywania wystarczy najdłuższy czas konwersji
+    vTaskDelay(pdMS_TO_TICKS(wait_ms + CONVERSION_MARGIN_MS));
+#endif
+}
+
+size_t sensor_manager_read(uint32_t mask, SensorData *out, size_t max) {
+    if (s_sensor_count < 32) {
+        mask &= (1UL << s_sensor_count) - 1;
+    }
+    if (mask == 0 || max == 0) return 0;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    // Najpierw start konwersji na każdej magistrali, potem jedno wspólne czekanie
+    int64_t conv_start_us = esp_timer_get_time();
+    uint32_t converting = 0;
+    uint32_t buses = buses_in_mask(mask);
+    for (int b = 0; b < s_bus_count; b++) {
+        if (!(buses & (1UL << b))) continue;
+        esp_err_t conv = trigger_conversion(b);
+        if (conv == ESP_OK) {
+            converting |= 1UL << b;
+        } else {
+            ESP_LOGE(TAG, "Błąd konwersji na magistrali %d (%s)", b, esp_err_to_name(conv));
+        }
+    }
+    if (converting != 0) {
+        wait_for_conversion(mask, converting);
+    }
+    diag_phase_add(DIAG_PHASE_CONVERSION, conv_start_us);
+
+    size_t n = 0;
+    for (int i = 0; i < s_sensor_count && n < max; i++) {
+        if (!(mask & (1UL << i)) || s_sensors[i] == NULL) continue;
+
+        out[n] = (SensorData){
+            .timestamp = (int64_t)tv.tv_sec,
+            .temp = SENSOR_INVALID_TEMP,
+            .sensor_id = i,
+        };
+
+        float temperature;
+        bool converted = converting & (1UL << (i / s_per_bus));
+        int64_t read_start_us = esp_timer_get_time();
+        esp_err_t read_err = converted ? ds18b20_get_temperature(s_sensors[i], &temperature) : ESP_FAIL;
+        diag_phase_add(DIAG_PHASE_SENSOR_READ, read_start_us);
+
+        if (read_err == ESP_OK) {
+            out[n].temp = temperature;
+        } else {
+            ESP_LOGE(TAG, "Błąd odczytu temperatury ID[%d] (CRC/Timeout)", i);
+        }
+
+        ESP_LOGI(TAG, "Odczyt ID[%d]: %.2f st. C", i, out[n].temp);
+        n++;
+    }
+
+    return n;
+}
+
+size_t sensor_manager_read_all(SensorData *out, size_t max) {
+    return sensor_manager_read(UINT32_MAX, out, max);
+}
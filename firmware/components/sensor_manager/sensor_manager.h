@@ -0,0 +1,42 @@
+#ifndef SENSOR_MANAGER_H
+#define SENSOR_MANAGER_H
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "offline_buffer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Przestrzeń ID czujników (szerokość masek w sensor_manager_read i scheduler.h)
+#define SENSOR_MANAGER_MAX_SENSORS  32
+
+// Inicjalizacja magistral OneWire (po jednej na GPIO, każda na własnych kanałach RMT).
+// ID = magistrala * CONFIG_HIVE_ONEWIRE_SENSORS_PER_BUS + numer na magistrali;
+// magistrale ponad przestrzeń ID są pomijane.
+// ID czujnika jest przypisane na stałe do jego kodu ROM (tabela w NVS), więc
+// wymiana/dołożenie sondy nie przenumerowuje pozostałych. Start z tabeli bez
+// przeszukiwania magistrali; pełny skan tylko, gdy tabeli brak albo któryś czujnik
+// z tabeli nie odpowiada.
+esp_err_t sensor_manager_init(const gpio_num_t *gpios, int bus_count);
+
+// Pełny skan magistrali (sprawdzenie podłączeń): nowe czujniki dostają wolne ID,
+// zniknięte zostają w tabeli. Liczba czujników może wzrosnąć.
+esp_err_t sensor_manager_rescan(void);
+
+// Liczba ID w użyciu (najwyższe ID + 1; przy kilku magistralach mogą być luki)
+int sensor_manager_count(void);
+
+// Zmienia rozdzielczość czujnika (9..12 bitów) i zapisuje ją w NVS.
+// Niższa rozdzielczość = krótsza konwersja (12 bit: 750 ms, 10 bit: 188 ms, 9 bit: 94 ms).
+esp_err_t sensor_manager_set_resolution(int id, uint8_t bits);
+
+// Odczyt wszystkich czujników naraz: jedna konwersja na każdej magistrali (Skip ROM), konwersje
+// wszystkich magistral trwają równolegle, jedno odczekanie (wg najwyższej rozdzielczości),
+// potem odczyt scratchpadu każdego czujnika po adresie.
+// Wszystkie pomiary dostają ten sam timestamp. Zwraca liczbę wpisanych pomiarów.
+size_t sensor_manager_read_all(SensorData *out, size_t max);
+
+// Jak wyżej, ale odczytywane są tylko czujniki z maski (bit i = czujnik ID i)
+size_t sensor_manager_read(uint32_t mask, SensorData *out, size_t max);
+
+#endif // SENSOR_MANAGER_H
@@ -2,128 +2,403 @@
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "diag.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "STORAGE";
 
+// Migawka namespace w RAM: przy pierwszym dostępie wszystkie klucze (i32, str, blob) wczytywane są
+// jednym przejściem iteratora NVS, potem odczyty idą z pamięci. Uchwyt NVS otwierany jest raz
+// i trzymany do restartu. Zapis tej samej wartości nie dotyka flasha.
+#define STORAGE_MAX_NAMESPACES  16
+
+typedef struct {
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    bool present;       // false = klucz skasowany (w transakcji czeka na nvs_erase_key)
+    bool dirty;         // zmiana jeszcze nie zapisana w NVS (tylko w transakcji)
+    int32_t i32;
+    void *data;         // str (z '\0') albo blob
+    size_t len;
+} storage_entry_t;
+
+typedef struct {
+    char name[NVS_NS_NAME_MAX_SIZE];
+    nvs_handle_t handle;
+    bool handle_open;
+    bool in_txn;
+    storage_entry_t *entries;
+    size_t count;
+} storage_ns_t;
+
+static storage_ns_t s_ns[STORAGE_MAX_NAMESPACES];
+static size_t s_ns_count = 0;
+
+// Rekurencyjny: transakcja trzyma blokadę od storage_begin do storage_commit,
+// a zapisy w jej trakcie biorą ją ponownie
+static SemaphoreHandle_t s_lock = NULL;
+
+static void lock(void) {
+    if (s_lock != NULL) xSemaphoreTakeRecursive(s_lock, portMAX_DELAY);
+}
+
+static void unlock(void) {
+    if (s_lock != NULL) xSemaphoreGiveRecursive(s_lock);
+}
+
 esp_err_t storage_init(void) {
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateRecursiveMutex();
+    }
+
     esp_err_t err = nvs_flash_init();
-    
+
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_LOGW(TAG, "NVS partition truncated or different version. Erasing...");
         ESP_ERROR_CHECK(nvs_flash_erase());
         err = nvs_flash_init();
     }
-    
+
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "NVS Initialized");
     } else {
         ESP_LOGE(TAG, "NVS Init failed: %s", esp_err_to_name(err));
     }
-    
+
     return err;
 }
 
-static esp_err_t _open_nvs(const char* namespace, nvs_open_mode_t mode, nvs_handle_t *handle) {
-    esp_err_t err = nvs_open(namespace, mode, handle);
+static esp_err_t _open_nvs(storage_ns_t *ns) {
+    if (ns->handle_open) return ESP_OK;
+
+    esp_err_t err = nvs_open(ns->name, NVS_READWRITE, &ns->handle);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", namespace, esp_err_to_name(err));
+        ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", ns->name, esp_err_to_name(err));
+        return err;
     }
-    return err;
+    ns->handle_open = true;
+    return ESP_OK;
 }
 
-esp_err_t storage_save_i32(const char* namespace, const char* key, int32_t value) {
-    nvs_handle_t handle;
-    esp_err_t err = _open_nvs(namespace, NVS_READWRITE, &handle);
+static storage_entry_t *find_entry(storage_ns_t *ns, const char *key) {
+    for (size_t i = 0; i < ns->count; i++) {
+        if (strcmp(ns->entries[i].key, key) == 0) return &ns->entries[i];
+    }
+    return NULL;
+}
+
+static storage_entry_t *add_entry(storage_ns_t *ns, const char *key, nvs_type_t type) {
+    storage_entry_t *entries = realloc(ns->entries, (ns->count + 1) * sizeof(storage_entry_t));
+    if (entries == NULL) return NULL;
+
+    ns->entries = entries;
+    storage_entry_t *e = &ns->entries[ns->count++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->key, sizeof(e->key), "%s", key);
+    e->type = type;
+    return e;
+}
+
+static bool load_entry(storage_ns_t *ns, const nvs_entry_info_t *info) {
+    storage_entry_t *e = add_entry(ns, info->key, info->type);
+    if (e == NULL) return false;
+
+    esp_err_t err;
+    size_t len = 0;
+    switch (info->type) {
+        case NVS_TYPE_I32:
+            err = nvs_get_i32(ns->handle, info->key, &e->i32);
+            break;
+        case NVS_TYPE_STR:
+            err = nvs_get_str(ns->handle, info->key, NULL, &len);
+            if (err == ESP_OK && (e->data = malloc(len)) != NULL) {
+                err = nvs_get_str(ns->handle, info->key, e->data, &len);
+            }
+            break;
+        case NVS_TYPE_BLOB:
+            err = nvs_get_blob(ns->handle, info->key, NULL, &len);
+            if (err == ESP_OK && (e->data = malloc(len > 0 ? len : 1)) != NULL) {
+                err = nvs_get_blob(ns->handle, info->key, e->data, &len);
+            }
+            break;
+        default:
+            err = ESP_ERR_NOT_SUPPORTED;  // inne typy nie są używane przez firmware
+            break;
+    }
+
+    if (err != ESP_OK || (info->type != NVS_TYPE_I32 && e->data == NULL)) {
+        free(e->data);
+        ns->count--;
+        return false;
+    }
+    e->len = len;
+    e->present = true;
+    return true;
+}
+
+// Migawka namespace (wczytywana przy pierwszym użyciu); NULL gdy brak miejsca w tablicy
+static storage_ns_t *get_ns(const char *name) {
+    for (size_t i = 0; i < s_ns_count; i++) {
+        if (strcmp(s_ns[i].name, name) == 0) return &s_ns[i];
+    }
+    if (s_ns_count >= STORAGE_MAX_NAMESPACES) {
+        ESP_LOGE(TAG, "Za duzo namespace NVS (max %d)", STORAGE_MAX_NAMESPACES);
+        return NULL;
+    }
+
+    storage_ns_t *ns = &s_ns[s_ns_count++];
+    memset(ns, 0, sizeof(*ns));
+    snprintf(ns->name, sizeof(ns->name), "%s", name);
+
+    // Nieistniejący namespace = pusta migawka; NVS tworzy go dopiero przy pierwszym zapisie
+    int64_t start_us = esp_timer_get_time();
+    nvs_iterator_t it = NULL;
+    esp_err_t err = nvs_entry_find(NVS_DEFAULT_PART_NAME, name, NVS_TYPE_ANY, &it);
+    if (err == ESP_OK && _open_nvs(ns) != ESP_OK) {
+        nvs_release_iterator(it);
+        return ns;
+    }
+
+    size_t skipped = 0;
+    while (err == ESP_OK) {
+        nvs_entry_info_t info;
+        nvs_entry_info(it, &info);
+        if (!load_entry(ns, &info)) skipped++;
+        err = nvs_entry_next(&it);
+    }
+    nvs_release_iterator(it);
+    diag_phase_add(DIAG_PHASE_NVS, start_us);
+
+    ESP_LOGD(TAG, "Namespace '%s': %zu kluczy w RAM", name, ns->count);
+    if (skipped > 0) {
+        ESP_LOGW(TAG, "Namespace '%s': pominieto %zu kluczy", name, skipped);
+    }
+    return ns;
+}
+
+// Zapis jednego klucza do NVS (bez commit)
+static esp_err_t flush_entry(storage_ns_t *ns, storage_entry_t *e) {
+    esp_err_t err = _open_nvs(ns);
     if (err != ESP_OK) return err;
 
-    err = nvs_set_i32(handle, key, value);
-    if (err == ESP_OK) {
-        err = nvs_commit(handle);
+    if (!e->present) {
+        err = nvs_erase_key(ns->handle, e->key);
+        if (err == ESP_ERR_NVS_NOT_FOUND) err = ESP_OK;
+    } else if (e->type == NVS_TYPE_I32) {
+        err = nvs_set_i32(ns->handle, e->key, e->i32);
+    } else if (e->type == NVS_TYPE_STR) {
+        err = nvs_set_str(ns->handle, e->key, e->data);
+    } else {
+        err = nvs_set_blob(ns->handle, e->key, e->data, e->len);
     }
-    
-    nvs_close(handle);
+
+    if (err == ESP_OK) e->dirty = false;
     return err;
 }
 
-esp_err_t storage_load_i32(const char* namespace, const char* key, int32_t* value, int32_t default_value) {
-    nvs_handle_t handle;
-    esp_err_t err = _open_nvs(namespace, NVS_READONLY, &handle);
-    
-    if (err != ESP_OK) {
-        *value = default_value;
-        return err;
-    }
+// Zapis poza transakcją: klucz i commit od razu. Gdy się nie uda, migawka wraca do prev -
+// inaczej kolejny zapis tej samej wartości uznałby ją za zapisaną i nie ponowiłby próby.
+static esp_err_t write_through(storage_ns_t *ns, storage_entry_t *e, const storage_entry_t *prev, bool added) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = flush_entry(ns, e);
+    if (err == ESP_OK) err = nvs_commit(ns->handle);
+    diag_phase_add(DIAG_PHASE_NVS, start_us);
+    if (err == ESP_OK) return ESP_OK;
 
-    err = nvs_get_i32(handle, key, value);
-    if (err == ESP_ERR_NVS_NOT_FOUND) {
-        *value = default_value;
-        ESP_LOGI(TAG, "Key '%s' not found in '%s', using default", key, namespace);
-        err = ESP_OK;
+    ESP_LOGE(TAG, "Zapis '%s' w '%s' nieudany: %s", e->key, ns->name, esp_err_to_name(err));
+    if (e->data != prev->data) free(e->data);
+    if (added) {
+        ns->count--;    // add_entry dopisuje na końcu
+    } else {
+        *e = *prev;
     }
-    
-    nvs_close(handle);
     return err;
 }
 
-esp_err_t storage_save_str(const char* namespace, const char* key, const char* value) {
-    nvs_handle_t handle;
-    esp_err_t err = _open_nvs(namespace, NVS_READWRITE, &handle);
-    if (err != ESP_OK) return err;
+// Wspólna ścieżka zapisu: aktualizuje migawkę; poza transakcją od razu zapis i commit
+static esp_err_t store(const char *namespace, const char *key, nvs_type_t type, int32_t i32,
+                       const void *data, size_t len) {
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    if (ns == NULL) {
+        unlock();
+        return ESP_ERR_NO_MEM;
+    }
 
-    err = nvs_set_str(handle, key, value);
-    if (err == ESP_OK) {
-        err = nvs_commit(handle);
+    // dirty poza transakcją = nieudany storage_commit; taki klucz zapisujemy ponownie
+    storage_entry_t *e = find_entry(ns, key);
+    if (e != NULL && e->present && !e->dirty && e->type == type &&
+        (type == NVS_TYPE_I32 ? e->i32 == i32 : (e->len == len && memcmp(e->data, data, len) == 0))) {
+        unlock();
+        return ESP_OK;  // bez zmian - flash nietknięty
+    }
+
+    bool added = (e == NULL);
+    if (added && (e = add_entry(ns, key, type)) == NULL) {
+        unlock();
+        return ESP_ERR_NO_MEM;
+    }
+    storage_entry_t prev = *e;  // do wycofania, gdy zapis do NVS się nie uda
+
+    if (type != NVS_TYPE_I32) {
+        void *copy = malloc(len > 0 ? len : 1);
+        if (copy == NULL) {
+            if (added) ns->count--;
+            unlock();
+            return ESP_ERR_NO_MEM;
+        }
+        memcpy(copy, data, len);
+        e->data = copy;
     }
+    e->type = type;
+    e->i32 = i32;
+    e->len = len;
+    e->present = true;
+    e->dirty = true;
 
-    nvs_close(handle);
+    esp_err_t err = ESP_OK;
+    if (!ns->in_txn) {
+        err = write_through(ns, e, &prev, added);
+    }
+    if (err == ESP_OK && prev.data != e->data) free(prev.data);
+    unlock();
     return err;
 }
 
-esp_err_t storage_load_str(const char* namespace, const char* key, char* buffer, size_t max_len, const char* default_value) {
-    nvs_handle_t handle;
-    esp_err_t err = _open_nvs(namespace, NVS_READONLY, &handle);
-    
-    if (err != ESP_OK) {
-        if (default_value != NULL) {
-            strncpy(buffer, default_value, max_len - 1);
-            buffer[max_len - 1] = '\0';
+esp_err_t storage_begin(const char* namespace) {
+    lock();     // zwalniane w storage_commit
+    storage_ns_t *ns = get_ns(namespace);
+    if (ns == NULL || ns->in_txn) {
+        unlock();
+        return ns == NULL ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_STATE;
+    }
+    ns->in_txn = true;
+    return ESP_OK;
+}
+
+esp_err_t storage_commit(const char* namespace) {
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    if (ns == NULL || !ns->in_txn) {
+        unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Wszystkie zmiany naraz i jeden commit
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = ESP_OK;
+    size_t written = 0;
+    for (size_t i = 0; i < ns->count && err == ESP_OK; i++) {
+        if (ns->entries[i].dirty) {
+            err = flush_entry(ns, &ns->entries[i]);
+            written++;
         }
-        return err;
+    }
+    if (err == ESP_OK && written > 0) {
+        err = nvs_commit(ns->handle);
+        diag_phase_add(DIAG_PHASE_NVS, start_us);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Commit '%s' nieudany: %s", namespace, esp_err_to_name(err));
     }
 
-    size_t required_size;
-    err = nvs_get_str(handle, key, NULL, &required_size);
+    ns->in_txn = false;
+    unlock();
+    unlock();   // blokada z storage_begin
+    return err;
+}
 
-    if (err == ESP_OK) {
-        if (required_size <= max_len) {
-            err = nvs_get_str(handle, key, buffer, &required_size);
+esp_err_t storage_save_i32(const char* namespace, const char* key, int32_t value) {
+    return store(namespace, key, NVS_TYPE_I32, value, NULL, 0);
+}
+
+esp_err_t storage_load_i32(const char* namespace, const char* key, int32_t* value, int32_t default_value) {
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    storage_entry_t *e = ns ? find_entry(ns, key) : NULL;
+
+    if (e != NULL && e->present && e->type == NVS_TYPE_I32) {
+        *value = e->i32;
+    } else {
+        *value = default_value;
+        ESP_LOGI(TAG, "Key '%s' not found in '%s', using default", key, namespace);
+    }
+    unlock();
+    return ESP_OK;
+}
+
+esp_err_t storage_save_str(const char* namespace, const char* key, const char* value) {
+    return store(namespace, key, NVS_TYPE_STR, 0, value, strlen(value) + 1);
+}
+
+esp_err_t storage_load_str(const char* namespace, const char* key, char* buffer, size_t max_len, const char* default_value) {
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    storage_entry_t *e = ns ? find_entry(ns, key) : NULL;
+    esp_err_t err = ESP_OK;
+
+    if (e != NULL && e->present && e->type == NVS_TYPE_STR) {
+        if (e->len <= max_len) {
+            memcpy(buffer, e->data, e->len);
         } else {
-            ESP_LOGE(TAG, "Buffer too small for key '%s'. Needed: %d", key, required_size);
+            ESP_LOGE(TAG, "Buffer too small for key '%s'. Needed: %zu", key, e->len);
             err = ESP_ERR_NVS_INVALID_LENGTH;
         }
-    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
-        if (default_value != NULL) {
-            strncpy(buffer, default_value, max_len - 1);
-            buffer[max_len - 1] = '\0';
-        }
-        err = ESP_OK; 
+    } else if (default_value != NULL) {
+        strncpy(buffer, default_value, max_len - 1);
+        buffer[max_len - 1] = '\0';
     }
+    unlock();
+    return err;
+}
+
+esp_err_t storage_save_blob(const char* namespace, const char* key, const void* data, size_t len) {
+    return store(namespace, key, NVS_TYPE_BLOB, 0, data, len);
+}
 
-    nvs_close(handle);
+esp_err_t storage_load_blob(const char* namespace, const char* key, void* data, size_t len) {
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    storage_entry_t *e = ns ? find_entry(ns, key) : NULL;
+    esp_err_t err = ESP_OK;
+
+    if (e == NULL || !e->present || e->type != NVS_TYPE_BLOB) {
+        err = ESP_ERR_NVS_NOT_FOUND;
+    } else if (e->len != len) {
+        ESP_LOGW(TAG, "Blob '%s' has size %zu, expected %zu", key, e->len, len);
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(data, e->data, len);
+    }
+    unlock();
     return err;
 }
 
 esp_err_t storage_erase_key(const char* namespace, const char* key) {
-    nvs_handle_t handle;
-    esp_err_t err = _open_nvs(namespace, NVS_READWRITE, &handle);
-    if (err != ESP_OK) return err;
+    lock();
+    storage_ns_t *ns = get_ns(namespace);
+    storage_entry_t *e = ns ? find_entry(ns, key) : NULL;
+    if (e == NULL || !e->present) {
+        unlock();
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
 
-    err = nvs_erase_key(handle, key);
-    if (err == ESP_OK) {
-        nvs_commit(handle);
+    storage_entry_t prev = *e;
+    e->data = NULL;
+    e->len = 0;
+    e->present = false;
+    e->dirty = true;
+
+    esp_err_t err = ESP_OK;
+    if (!ns->in_txn) {
+        err = write_through(ns, e, &prev, false);
     }
-    
-    nvs_close(handle);
+    if (err == ESP_OK) free(prev.data);
+    unlock();
     return err;
-}
\ No newline at end of file
+}
@@ -5,9 +5,18 @@
 #include <stdint.h>
 #include <stddef.h>
 
+// Odczyty idą z migawki namespace w RAM (wczytanej raz przy pierwszym użyciu),
+// zapis niezmienionej wartości nie dotyka flasha.
+
 // Inicjalizacja całego systemu NVS
 esp_err_t storage_init(void);
 
+// Transakcja: zapisy i kasowania między begin a commit trafiają do NVS razem, z jednym
+// nvs_commit. Do commit inne taski czekają na dostęp do konfiguracji (nie widzą połowy zmian).
+esp_err_t storage_begin(const char* namespace);
+
+esp_err_t storage_commit(const char* namespace);
+
 esp_err_t storage_save_i32(const char* namespace, const char* key, int32_t value);
 
 esp_err_t storage_load_i32(const char* namespace, const char* key, int32_t* value, int32_t default_value);
@@ -16,6 +25,12 @@ esp_err_t storage_save_str(const char* namespace, const char* key, const char* v
 
 esp_err_t storage_load_str(const char* namespace, const char* key, char* buffer, size_t max_len, const char* default_value);
 
+// Zapis/odczyt małych struktur binarnych (np. kursory bufora offline)
+esp_err_t storage_save_blob(const char* namespace, const char* key, const void* data, size_t len);
+
+// Zwraca ESP_ERR_NVS_NOT_FOUND jeśli klucza nie ma, ESP_ERR_NVS_INVALID_LENGTH jeśli rozmiar się nie zgadza
+esp_err_t storage_load_blob(const char* namespace, const char* key, void* data, size_t len);
+
 esp_err_t storage_erase_key(const char* namespace, const char* key);
 
 #endif // STORAGE_MANAGER_H
\ No newline at end of file
@@ -1,10 +1,14 @@
 #include "wifi_connect.h"
 #include "storage_manager.h"
+#include "diag.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include <inttypes.h>
 #include <string.h>
 
 #include "lwip/err.h"
@@ -22,6 +26,21 @@ static const char *TAG = "WIFI_CONN";
 #define INTERNET_TEST_IP  "8.8.8.8"
 #define INTERNET_TEST_PORT 53
 
+// Szybkie łączenie: ostatni dobry BSSID/kanał (i dzierżawa IP) w NVS "wifi"/"fast"
+#define FAST_CONNECT_KEY        "fast"
+#define FAST_CONNECT_TIMEOUT_MS 3000
+#define FULL_CONNECT_TIMEOUT_MS 10000
+
+typedef struct {
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t has_ip;
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;
+} wifi_fast_cache_t;
+
 static EventGroupHandle_t s_wifi_event_group;
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
@@ -30,6 +49,12 @@ static int s_retry_num = 0;
 static bool s_is_connected = false;
 static bool s_allow_reconnect = true; 
 
+static esp_netif_t *s_netif = NULL;
+static wifi_config_t s_wifi_config;
+static wifi_fast_cache_t s_fast;
+static bool s_fast_valid = false;
+
+#if CONFIG_HIVE_WIFI_WAN_PROBE
 static bool check_internet_connection(void) {
     ESP_LOGI(TAG, "Weryfikacja dostepu do Internetu (Ping 8.8.8.8)...");
 
@@ -66,9 +91,105 @@ static bool check_internet_connection(void) {
     close(sock);
     return is_ok;
 }
+#endif
+
+// Zapamiętuje AP (i adres z DHCP) po udanym połączeniu; zapis do NVS tylko przy zmianie
+static void fast_cache_update(const esp_netif_ip_info_t *ip_info) {
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) return;
+
+    wifi_fast_cache_t fresh = {0};
+    memcpy(fresh.bssid, ap.bssid, sizeof(fresh.bssid));
+    fresh.channel = ap.primary;
+    if (ip_info != NULL && ip_info->ip.addr != 0) {
+        esp_netif_dns_info_t dns = {0};
+        esp_netif_get_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns);
+        fresh.has_ip = 1;
+        fresh.ip = ip_info->ip.addr;
+        fresh.netmask = ip_info->netmask.addr;
+        fresh.gw = ip_info->gw.addr;
+        fresh.dns = dns.ip.u_addr.ip4.addr;
+    }
+
+    if (s_fast_valid && memcmp(&fresh, &s_fast, sizeof(fresh)) == 0) return;
+
+    s_fast = fresh;
+    s_fast_valid = true;
+    storage_save_blob("wifi", FAST_CONNECT_KEY, &s_fast, sizeof(s_fast));
+    ESP_LOGI(TAG, "Zapamietano AP %02x:%02x:%02x:%02x:%02x:%02x, kanal %d",
+             s_fast.bssid[0], s_fast.bssid[1], s_fast.bssid[2],
+             s_fast.bssid[3], s_fast.bssid[4], s_fast.bssid[5], s_fast.channel);
+}
+
+#if CONFIG_HIVE_WIFI_IP_STATIC || CONFIG_HIVE_WIFI_IP_REUSE_LEASE
+static void set_static_ip(uint32_t ip, uint32_t netmask, uint32_t gw, uint32_t dns) {
+    esp_netif_ip_info_t info = {0};
+    info.ip.addr = ip;
+    info.netmask.addr = netmask;
+    info.gw.addr = gw;
+
+    esp_netif_dhcpc_stop(s_netif);
+    esp_netif_set_ip_info(s_netif, &info);
+    if (dns != 0) {
+        esp_netif_dns_info_t dns_info = {0};
+        dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+        dns_info.ip.u_addr.ip4.addr = dns;
+        esp_netif_set_dns_info(s_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+    }
+}
+#endif
+
+// Konfiguracja adresu IP przed połączeniem (DHCP / ostatnia dzierżawa / statyczny)
+static void apply_ip_config(bool fast) {
+#if CONFIG_HIVE_WIFI_IP_STATIC
+    (void)fast;
+    set_static_ip(ipaddr_addr(CONFIG_HIVE_WIFI_STATIC_IP), ipaddr_addr(CONFIG_HIVE_WIFI_STATIC_NETMASK),
+                  ipaddr_addr(CONFIG_HIVE_WIFI_STATIC_GW), ipaddr_addr(CONFIG_HIVE_WIFI_STATIC_DNS));
+#elif CONFIG_HIVE_WIFI_IP_REUSE_LEASE
+    if (fast && s_fast.has_ip) {
+        set_static_ip(s_fast.ip, s_fast.netmask, s_fast.gw, s_fast.dns);
+    } else {
+        esp_netif_dhcpc_start(s_netif);
+    }
+#else
+    (void)fast;
+#endif
+}
+
+// fast = łączenie prosto do zapamiętanego BSSID na znanym kanale (bez pełnego skanu)
+static void apply_sta_config(bool fast) {
+    wifi_config_t cfg = s_wifi_config;
+    if (fast) {
+        cfg.sta.bssid_set = true;
+        memcpy(cfg.sta.bssid, s_fast.bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = s_fast.channel;
+        cfg.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        cfg.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    apply_ip_config(fast);
+}
+
+static EventBits_t connect_and_wait(bool fast) {
+    s_retry_num = fast ? MAX_RETRY : 0; // na szybkiej ścieżce bez ponowień - od razu pełny skan
+    s_allow_reconnect = true;
+    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
+
+    apply_sta_config(fast);
+
+    int timeout_ms = fast ? FAST_CONNECT_TIMEOUT_MS : FULL_CONNECT_TIMEOUT_MS;
+    ESP_LOGI(TAG, "Wlaczam WiFi (%s, max %d ms)...", fast ? "szybko, zapamietany AP" : "pelny skan", timeout_ms);
+    ESP_ERROR_CHECK(esp_wifi_start());
+
+    return xEventGroupWaitBits(s_wifi_event_group,
+            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
+            pdFALSE, pdFALSE, pdMS_TO_TICKS(timeout_ms));
+}
 
 static void event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data) {
+    (void)arg;
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         esp_wifi_connect();
     } 
@@ -86,8 +207,10 @@ static void event_handler(void* arg, esp_event_base_t event_base,
         }
     } 
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
+        ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
         s_retry_num = 0;
         s_is_connected = true;
+        fast_cache_update(&event->ip_info);
         xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
     }
 }
@@ -100,7 +223,7 @@ void wifi_connect_init(void) {
     ESP_ERROR_CHECK(esp_netif_init());
     
     
-    esp_netif_create_default_wifi_sta();
+    s_netif = esp_netif_create_default_wifi_sta();
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -116,6 +239,10 @@ void wifi_connect_init(void) {
     
     storage_load_str("wifi", "ssid", (char*)wifi_config.sta.ssid, sizeof(wifi_config.sta.ssid), DEFAULT_SSID);
     storage_load_str("wifi", "pass", (char*)wifi_config.sta.password, sizeof(wifi_config.sta.password), DEFAULT_PASS);
+    s_wifi_config = wifi_config;
+
+    s_fast_valid = (storage_load_blob("wifi", FAST_CONNECT_KEY, &s_fast, sizeof(s_fast)) == ESP_OK &&
+                    s_fast.channel != 0);
 
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
@@ -124,32 +251,51 @@ void wifi_connect_init(void) {
 }
 
 esp_err_t wifi_connect_start(void) {
-    s_retry_num = 0;
-    s_allow_reconnect = true; 
-    
-    if (s_wifi_event_group == NULL) return ESP_FAIL;
+    if (s_is_connected) {
+        return ESP_OK; // Połączenie z poprzedniego cyklu nadal aktywne
+    }
+    // Radio mogło zostać włączone w poprzednim cyklu i zgubić sieć - startujemy od zera
+    s_allow_reconnect = false;
+    esp_wifi_stop();
 
-    xEventGroupClearBits(s_wifi_event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
-    
-    ESP_LOGI(TAG, "Wlaczam WiFi...");
-    ESP_ERROR_CHECK(esp_wifi_start());
+    if (s_wifi_event_group == NULL) return ESP_FAIL;
 
-    ESP_LOGI(TAG, "Czekam na polaczenie (max 10s)...");
+    int64_t start_us = esp_timer_get_time();
+    EventBits_t bits = 0;
 
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-            pdFALSE, pdFALSE, pdMS_TO_TICKS(10000));
+    if (s_fast_valid) {
+        bits = connect_and_wait(true);
+        if (!(bits & WIFI_CONNECTED_BIT)) {
+            ESP_LOGW(TAG, "Zapamietany AP nie odpowiada - pelne skanowanie.");
+            s_allow_reconnect = false;
+            esp_wifi_stop();
+            s_fast_valid = false;
+            storage_erase_key("wifi", FAST_CONNECT_KEY);
+        }
+    }
+    if (!(bits & WIFI_CONNECTED_BIT)) {
+        bits = connect_and_wait(false);
+    }
+    diag_phase_add(DIAG_PHASE_WIFI, start_us);     // także nieudana próba - radio było włączone
 
     if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "Polaczono z lokalnym routerem. Weryfikuje WAN...");
-        
-        if (check_internet_connection()) {
+        ESP_LOGI(TAG, "Polaczono z lokalnym routerem w %" PRId64 " ms.", (esp_timer_get_time() - start_us) / 1000);
+
+#if CONFIG_HIVE_WIFI_WAN_PROBE
+        int64_t probe_start_us = esp_timer_get_time();
+        bool online = check_internet_connection();
+        diag_phase_add(DIAG_PHASE_WAN_PROBE, probe_start_us);
+        if (online) {
             return ESP_OK; 
         } else {
             ESP_LOGW(TAG, "Jest WiFi, ale brak internetu. Rozlaczam.");
             wifi_connect_stop(); 
             return ESP_FAIL; 
         }
+#else
+        // Łączność z Internetem potwierdzi dopiero połączenie MQTT
+        return ESP_OK;
+#endif
 
     } else {
         if (bits & WIFI_FAIL_BIT) {
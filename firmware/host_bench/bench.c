@@ -0,0 +1,469 @@
+// Mikrobenchmarki komponentów firmware na Linuksie: bufor offline (zapis, start, opróżnianie),
+// kodowanie paczki MQTT i storage_manager (NVS). Każdy rozmiar zaległości liczony jest
+// w osobnym procesie - statyczny stan komponentów startuje od zera jak po restarcie ESP32,
+// a flash i NVS przechodzą między procesami w plikach (port/host_port.h).
+//
+// Czasy zależą od maszyny - porównywać tylko przebiegi z tego samego komputera.
+// --check sprawdza wielkości deterministyczne (bajty na rekord, kasowania, zapisy NVS)
+// i kończy się błędem po przekroczeniu limitów - do ctest.
+#include "offline_buffer.h"
+#include "storage_manager.h"
+#include "mqtt_payload.h"
+#include "host_port.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SENSORS_PER_CYCLE       10
+#define CYCLE_INTERVAL_S        300         // CONFIG_HIVE_SLEEP_INTERVAL_S
+#define START_TS                1767225600  // 2026-01-01
+#define MIN_MEASURE_US          20000       // powtórzenia krótkich pomiarów do co najmniej tylu us
+
+// Limity --check. Bufor zapisuje ~5.5 B/rekord (bloki delta z nagłówkami), paczka MQTT
+// ~7.2 B/rekord (5 B + 2 B numeru + nagłówek). Przekroczenie oznacza regresję formatu.
+#define CHECK_FLASH_PER_RECORD  6.0         // B zaprogramowane na rekord przy zapisie
+#define CHECK_PAYLOAD_PER_RECORD 7.5        // B wiadomości MQTT na rekord
+#define DRAIN_CHUNK_RECORDS     64          // offline_buffer.c: DRAIN_CHUNK - kursor zapisywany co porcję
+
+static const size_t DEFAULT_SIZES[] = { 10, 100, 1000, 10000, 100000 };
+static const size_t QUICK_SIZES[] = { 10, 100, 1000 };
+
+typedef struct {
+    bool ok;
+    size_t records;
+
+    // Zapis cyklami po SENSORS_PER_CYCLE pomiarów (offline_buffer_add_batch)
+    double append_ns;           // ns/rekord bez czasu zamienników flasha i NVS
+    double append_io_ns;
+    double flash_per_record;
+    uint32_t append_erases;
+    uint32_t append_nvs_writes;
+
+    // Start z zaległością: offline_buffer_init (skan pierścienia)
+    double mount_ms;
+    size_t mounted;
+
+    // Opróżnianie całości od najstarszych (offline_process_queue)
+    double drain_ns;
+    double drain_io_ns;
+    size_t drained;
+    uint64_t drain_flash;
+    uint32_t drain_nvs_writes;
+    uint32_t drain_nvs_commits;
+} ring_result_t;
+
+typedef struct {
+    double binary_ns;
+    double binary_bytes;        // B na rekord
+    double messages;            // wiadomości na 1000 rekordów
+    double json_ns;
+    double json_bytes;
+} encode_result_t;
+
+typedef struct {
+    bool ok;
+    double cold_load_us;        // pierwszy odczyt namespace (iterator NVS)
+    double load_us;             // odczyt z migawki w RAM
+    double save_same_us;        // zapis niezmienionej wartości (bez NVS)
+    double save_us;             // zapis zmienionej wartości z nvs_commit
+    double save_io_us;
+    double txn_us;              // transakcja 4 kluczy
+    double txn_nvs_commits;
+} nvs_result_t;
+
+static const char *s_dir = ".";
+
+// Pomiary lodówek: 4 C z powolnym dryfem, krok DS18B20 12-bit (0.0625 C)
+static void generate(SensorData *out, size_t count, uint32_t first_seq) {
+    uint32_t rng = 12345;
+    int steps[SENSORS_PER_CYCLE] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        size_t cycle = (first_seq - 1 + i) / SENSORS_PER_CYCLE;
+        int sensor = (first_seq - 1 + i) % SENSORS_PER_CYCLE;
+
+        rng = rng * 1103515245u + 12345u;
+        int r = (rng >> 16) % 8;
+        if (r == 0 && steps[sensor] > -16) steps[sensor]--;
+        if (r == 1 && steps[sensor] < 16) steps[sensor]++;
+
+        out[i] = (SensorData){
+            .timestamp = START_TS + (int64_t)cycle * CYCLE_INTERVAL_S,
+            .temp = 4.0f + sensor * 0.5f + steps[sensor] * 0.0625f,
+            .sensor_id = sensor,
+            .seq = first_seq + i,
+        };
+    }
+}
+
+static bool open_buffer(void) {
+    if (storage_init() != ESP_OK) return false;
+    return offline_buffer_init() == ESP_OK;
+}
+
+// Uruchamia fn w procesie potomnym; wynik (size B) wraca przez potok
+static bool run_child(void (*fn)(void *result, const void *arg), const void *arg, void *result, size_t size) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) return false;
+
+    if (pid == 0) {
+        close(fds[0]);
+        memset(result, 0, size);
+        fn(result, arg);
+        ssize_t n = write(fds[1], result, size);
+        _exit(n == (ssize_t)size ? 0 : 1);
+    }
+
+    close(fds[1]);
+    size_t got = 0;
+    while (got < size) {
+        ssize_t n = read(fds[0], (uint8_t *)result + got, size - got);
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == size && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static void child_append(void *out, const void *arg) {
+    ring_result_t *r = out;
+    r->records = *(const size_t *)arg;
+
+    host_port_init(s_dir, true);
+    if (!open_buffer()) return;
+
+    SensorData *data = malloc(r->records * sizeof(SensorData));
+    if (data == NULL) return;
+    generate(data, r->records, 1);
+
+    host_port_reset_stats();
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < r->records; i += SENSORS_PER_CYCLE) {
+        size_t n = r->records - i < SENSORS_PER_CYCLE ? r->records - i : SENSORS_PER_CYCLE;
+        if (offline_buffer_add_batch(&data[i], n) != ESP_OK) {
+            free(data);
+            return;
+        }
+    }
+    int64_t total_us = esp_timer_get_time() - start_us;
+    free(data);
+
+    host_port_stats_t st;
+    host_port_get_stats(&st);
+    r->append_ns = (double)(total_us - st.io_us) * 1000 / r->records;
+    r->append_io_ns = (double)st.io_us * 1000 / r->records;
+    r->flash_per_record = (double)st.flash_written / r->records;
+    r->append_erases = st.flash_erases;
+    r->append_nvs_writes = st.nvs_writes;
+    r->ok = true;
+}
+
+static uint32_t s_expected_seq;
+static bool s_order_ok;
+
+static size_t ack_all(const SensorData *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (data[i].seq != s_expected_seq++) s_order_ok = false;
+    }
+    return count;
+}
+
+static void child_drain(void *out, const void *arg) {
+    ring_result_t *r = out;
+    *r = *(const ring_result_t *)arg;
+    r->ok = false;
+
+    host_port_init(s_dir, false);
+    int64_t start_us = esp_timer_get_time();
+    if (!open_buffer()) return;
+    r->mount_ms = (esp_timer_get_time() - start_us) / 1000.0;
+    r->mounted = offline_buffer_count();
+
+    // Najstarszy zachowany rekord - przy przepełnieniu pierścień zgubił początek
+    s_expected_seq = r->records - r->mounted + 1;
+    s_order_ok = true;
+
+    host_port_reset_stats();
+    start_us = esp_timer_get_time();
+    r->drained = offline_process_queue(ack_all, NULL);
+    int64_t total_us = esp_timer_get_time() - start_us;
+
+    host_port_stats_t st;
+    host_port_get_stats(&st);
+    size_t n = r->drained > 0 ? r->drained : 1;
+    r->drain_ns = (double)(total_us - st.io_us) * 1000 / n;
+    r->drain_io_ns = (double)st.io_us * 1000 / n;
+    r->drain_flash = st.flash_written;
+    r->drain_nvs_writes = st.nvs_writes;
+    r->drain_nvs_commits = st.nvs_commits;
+    r->ok = s_order_ok && offline_buffer_count() == 0;
+}
+
+static void bench_encode(size_t count, encode_result_t *r) {
+    SensorData *data = malloc(count * sizeof(SensorData));
+    if (data == NULL) return;
+    generate(data, count, 1);
+
+    uint8_t buf[MQTT_PAYLOAD_MAX_SIZE];
+    size_t bytes = 0, messages = 0, rounds = 0;
+    int64_t start_us = esp_timer_get_time();
+    do {
+        bytes = messages = 0;
+        for (size_t i = 0; i < count;) {
+            size_t consumed = 0;
+            size_t len = mqtt_payload_encode_batch(&data[i], count - i, buf, sizeof(buf), &consumed);
+            if (len == 0 || consumed == 0) break;
+            bytes += len;
+            messages++;
+            i += consumed;
+        }
+        rounds++;
+    } while (esp_timer_get_time() - start_us < MIN_MEASURE_US);
+    int64_t total_us = esp_timer_get_time() - start_us;
+
+    r->binary_ns = (double)total_us * 1000 / (rounds * count);
+    r->binary_bytes = (double)bytes / count;
+    r->messages = (double)messages * 1000 / count;
+
+    char json[160];
+    size_t json_bytes = 0;
+    rounds = 0;
+    start_us = esp_timer_get_time();
+    do {
+        json_bytes = 0;
+        for (size_t i = 0; i < count; i++) {
+            int len = mqtt_payload_format_json(&data[i], json, sizeof(json));
+            if (len > 0) json_bytes += len;
+        }
+        rounds++;
+    } while (esp_timer_get_time() - start_us < MIN_MEASURE_US);
+    total_us = esp_timer_get_time() - start_us;
+
+    r->json_ns = (double)total_us * 1000 / (rounds * count);
+    r->json_bytes = (double)json_bytes / count;
+    free(data);
+}
+
+#define NVS_ROUNDS 1000
+
+// Namespace jak konfiguracja urządzenia, zapisany w poprzednim "uruchomieniu"
+static void child_nvs_prepare(void *out, const void *arg) {
+    bool *ok = out;
+    (void)arg;
+
+    host_port_init(s_dir, true);
+    if (storage_init() != ESP_OK) return;
+    storage_begin("bench");
+    for (int i = 0; i < 8; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%d", i);
+        storage_save_i32("bench", key, i);
+    }
+    storage_save_str("bench", "ssid", "siec-lodowki");
+    uint64_t cursor[2] = { 0 };
+    storage_save_blob("bench", "cursor", cursor, sizeof(cursor));
+    *ok = storage_commit("bench") == ESP_OK;
+}
+
+static void child_nvs(void *out, const void *arg) {
+    nvs_result_t *r = out;
+    (void)arg;
+
+    host_port_init(s_dir, false);
+    if (storage_init() != ESP_OK) return;
+
+    int32_t value = 0;
+    int64_t start_us = esp_timer_get_time();
+    storage_load_i32("bench", "key0", &value, -1);
+    r->cold_load_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < NVS_ROUNDS; i++) {
+        storage_load_i32("bench", "key3", &value, -1);
+    }
+    r->load_us = (double)(esp_timer_get_time() - start_us) / NVS_ROUNDS;
+
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < NVS_ROUNDS; i++) {
+        storage_save_i32("bench", "key3", 3);
+    }
+    r->save_same_us = (double)(esp_timer_get_time() - start_us) / NVS_ROUNDS;
+
+    // Kursor bufora offline (16 B) - najczęstszy zapis w pracy urządzenia
+    uint64_t cursor[2] = { 0 };
+    host_port_reset_stats();
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < NVS_ROUNDS; i++) {
+        cursor[0]++;
+        storage_save_blob("bench", "cursor", cursor, sizeof(cursor));
+    }
+    host_port_stats_t st;
+    host_port_get_stats(&st);
+    r->save_us = (double)(esp_timer_get_time() - start_us) / NVS_ROUNDS;
+    r->save_io_us = (double)st.io_us / NVS_ROUNDS;
+
+    host_port_reset_stats();
+    start_us = esp_timer_get_time();
+    for (int i = 0; i < NVS_ROUNDS; i++) {
+        storage_begin("bench");
+        for (int k = 0; k < 4; k++) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%d", k);
+            storage_save_i32("bench", key, i * 4 + k + 100);
+        }
+        storage_commit("bench");
+    }
+    host_port_get_stats(&st);
+    r->txn_us = (double)(esp_timer_get_time() - start_us) / NVS_ROUNDS;
+    r->txn_nvs_commits = (double)st.nvs_commits / NVS_ROUNDS;
+
+    r->ok = storage_load_i32("bench", "key3", &value, -1) == ESP_OK && value == (NVS_ROUNDS - 1) * 4 + 3 + 100;
+}
+
+static bool check(bool cond, const char *what, size_t records) {
+    if (!cond) printf("REGRESJA [%zu rekordow]: %s\n", records, what);
+    return cond;
+}
+
+static bool check_ring(const ring_result_t *r) {
+    bool ok = check(r->ok, "blad zapisu lub opróżniania bufora", r->records);
+    ok &= check(r->mounted == r->records, "po restarcie brakuje rekordow", r->records);
+    ok &= check(r->drained == r->mounted, "nie oprozniono calego bufora", r->records);
+    ok &= check(r->flash_per_record <= CHECK_FLASH_PER_RECORD, "za duzo bajtow flasha na rekord", r->records);
+    ok &= check(r->drain_nvs_writes <= (r->drained + DRAIN_CHUNK_RECORDS - 1) / DRAIN_CHUNK_RECORDS + 1,
+                "za duzo zapisow NVS przy oproznianiu", r->records);
+    // Licznik zużycia zapisuje NVS przy każdym kasowaniu - poza tym zapis pomiarów nie dotyka NVS
+    ok &= check(r->append_nvs_writes <= r->append_erases + 1, "zapisy NVS przy dopisywaniu", r->records);
+    return ok;
+}
+
+static void parse_sizes(const char *arg, size_t *sizes, size_t *count, size_t max) {
+    *count = 0;
+    char *copy = strdup(arg);
+    for (char *tok = strtok(copy, ","); tok != NULL && *count < max; tok = strtok(NULL, ",")) {
+        long v = strtol(tok, NULL, 10);
+        if (v > 0) sizes[(*count)++] = v;
+    }
+    free(copy);
+}
+
+static void usage(const char *prog) {
+    printf("Uzycie: %s [--quick] [--sizes 10,1000,...] [--check] [--csv] [--dir KATALOG] [-v]\n", prog);
+}
+
+int main(int argc, char **argv) {
+    size_t sizes[16];
+    size_t size_count = sizeof(DEFAULT_SIZES) / sizeof(DEFAULT_SIZES[0]);
+    memcpy(sizes, DEFAULT_SIZES, sizeof(DEFAULT_SIZES));
+    bool do_check = false, csv = false;
+    esp_log_level_t level = ESP_LOG_ERROR;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            size_count = sizeof(QUICK_SIZES) / sizeof(QUICK_SIZES[0]);
+            memcpy(sizes, QUICK_SIZES, sizeof(QUICK_SIZES));
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            parse_sizes(argv[++i], sizes, &size_count, sizeof(sizes) / sizeof(sizes[0]));
+        } else if (strcmp(argv[i], "--check") == 0) {
+            do_check = true;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            s_dir = argv[++i];
+        } else if (strcmp(argv[i], "-v") == 0) {
+            level = ESP_LOG_INFO;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (mkdir(s_dir, 0755) != 0 && errno != EEXIST) {
+        printf("Nie mozna utworzyc katalogu %s\n", s_dir);
+        return 2;
+    }
+    esp_log_level_set("*", level);
+
+    bool ok = true;
+
+    if (csv) {
+        printf("records,append_ns,append_io_ns,flash_b_per_rec,erases,append_nvs_writes,mount_ms,"
+               "drain_ns,drain_io_ns,drain_flash_b,drain_nvs_writes,drain_nvs_commits,"
+               "encode_ns,encode_b_per_rec,json_ns,json_b_per_rec\n");
+    } else {
+        printf("Bufor offline (%d czujnikow co %d s) i paczka MQTT; ns/rek bez czasu I/O hosta\n\n",
+               SENSORS_PER_CYCLE, CYCLE_INTERVAL_S);
+        printf("%8s | %9s %7s %5s %4s | %8s | %9s %8s %5s | %9s %6s %8s %6s\n",
+               "rekordy", "zapis ns", "B/rek", "kas.", "NVS", "start ms",
+               "oprozn ns", "flash B", "NVS", "kod. ns", "B/rek", "json ns", "B/rek");
+    }
+
+    for (size_t i = 0; i < size_count; i++) {
+        ring_result_t ring = { 0 };
+        encode_result_t enc = { 0 };
+        bool child_ok = run_child(child_append, &sizes[i], &ring, sizeof(ring)) && ring.ok;
+        ring_result_t appended = ring;
+        child_ok = child_ok && run_child(child_drain, &appended, &ring, sizeof(ring));
+        bench_encode(sizes[i], &enc);
+
+        if (csv) {
+            printf("%zu,%.1f,%.1f,%.3f,%u,%u,%.3f,%.1f,%.1f,%llu,%u,%u,%.1f,%.3f,%.1f,%.2f\n",
+                   ring.records, ring.append_ns, ring.append_io_ns, ring.flash_per_record,
+                   ring.append_erases, ring.append_nvs_writes, ring.mount_ms, ring.drain_ns, ring.drain_io_ns,
+                   (unsigned long long)ring.drain_flash, ring.drain_nvs_writes, ring.drain_nvs_commits,
+                   enc.binary_ns, enc.binary_bytes, enc.json_ns, enc.json_bytes);
+        } else {
+            printf("%8zu | %9.0f %7.2f %5u %4u | %8.2f | %9.0f %8llu %5u | %9.1f %6.2f %8.0f %6.1f\n",
+                   sizes[i], ring.append_ns, ring.flash_per_record, ring.append_erases, ring.append_nvs_writes,
+                   ring.mount_ms, ring.drain_ns, (unsigned long long)ring.drain_flash, ring.drain_nvs_writes,
+                   enc.binary_ns, enc.binary_bytes, enc.json_ns, enc.json_bytes);
+        }
+
+        if (!child_ok) {
+            printf("BLAD: pomiar bufora dla %zu rekordow nie powiodl sie\n", sizes[i]);
+            ok = false;
+        } else if (do_check) {
+            ok &= check_ring(&ring);
+        }
+        // Przy kilku rekordach dominuje nagłówek wiadomości
+        if (do_check && sizes[i] >= MQTT_PAYLOAD_MAX_RECORDS) {
+            ok &= check(enc.binary_bytes <= CHECK_PAYLOAD_PER_RECORD, "za duza paczka MQTT na rekord", sizes[i]);
+        }
+    }
+
+    nvs_result_t nvs = { 0 };
+    bool prepared = false;
+    bool nvs_ok = run_child(child_nvs_prepare, NULL, &prepared, sizeof(prepared)) && prepared &&
+                  run_child(child_nvs, NULL, &nvs, sizeof(nvs)) && nvs.ok;
+    if (!csv) {
+        printf("\nstorage_manager (us na operacje):\n");
+        printf("  pierwszy odczyt namespace (10 kluczy)  %8.1f\n", nvs.cold_load_us);
+        printf("  odczyt z migawki RAM                   %8.3f\n", nvs.load_us);
+        printf("  zapis bez zmiany wartosci              %8.3f\n", nvs.save_same_us);
+        printf("  zapis blob 16 B + commit               %8.1f  (I/O hosta %.1f)\n", nvs.save_us, nvs.save_io_us);
+        printf("  transakcja 4 kluczy                    %8.1f  (%.1f nvs_commit)\n", nvs.txn_us, nvs.txn_nvs_commits);
+    }
+    if (!nvs_ok) {
+        printf("BLAD: pomiar NVS nie powiodl sie\n");
+        ok = false;
+    } else if (do_check) {
+        ok &= check(nvs.txn_nvs_commits <= 1.0, "transakcja robi wiecej niz jeden nvs_commit", 0);
+        ok &= check(nvs.save_same_us < nvs.save_us, "zapis niezmienionej wartosci dotyka NVS", 0);
+    }
+
+    if (do_check) printf("\n%s\n", ok ? "Limity OK" : "Przekroczone limity");
+    return ok ? 0 : 1;
+}
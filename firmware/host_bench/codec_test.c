@@ -0,0 +1,58 @@
+// Najgorszy przypadek kodowania bloku (block_codec.h): rekord, którego każde pole zajmuje
+// najdłuższy varint, musi zmieścić się w BLOCK_MAX_RECORD_SIZE i nie pisać za bufor.
+#include "block_codec.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CANARY          0xA5
+#define CANARY_SIZE     16
+
+static bool check(bool cond, const char *what) {
+    if (!cond) printf("BLAD: %s\n", what);
+    return cond;
+}
+
+int main(void) {
+    // Rekord 0 ustawia punkt odniesienia, rekord 1 ma wszystkie różnice maksymalne
+    SensorData records[2] = {
+        { .timestamp = 0, .temp = 0.0f, .pressure = 1, .sensor_id = 0, .seq = 1, .seq_epoch = 0xDEADBEEF,
+          .temp_min = 0.0f, .temp_max = 0.0f, .count = 1, .peak_dt = 0 },
+        { .timestamp = UINT32_MAX, .temp = 1.0e8f, .pressure = UINT32_MAX, .sensor_id = INT32_MIN,
+          .seq = 0x80000001u, .seq_epoch = 0xDEADBEEF, .temp_min = 0.0f, .temp_max = 0.0f, .count = UINT16_MAX, .peak_dt = UINT16_MAX },
+    };
+
+    size_t consumed;
+    uint8_t first[BLOCK_MAX_HEADER_SIZE + BLOCK_MAX_RECORD_SIZE];
+    size_t first_len = block_encode(records, 1, first, sizeof(first), &consumed);
+    bool ok = check(consumed == 1 && first_len > BLOCK_MAX_HEADER_SIZE, "kodowanie rekordu odniesienia");
+
+    // Bufor dokładnie na nagłówek, rekord 0 i jeden rekord najgorszego przypadku, dalej kanarek
+    size_t buf_len = first_len + BLOCK_MAX_RECORD_SIZE;
+    uint8_t buf[BLOCK_MAX_HEADER_SIZE + 2 * BLOCK_MAX_RECORD_SIZE + CANARY_SIZE];
+    memset(buf, CANARY, sizeof(buf));
+
+    size_t len = block_encode(records, 2, buf, buf_len, &consumed);
+    ok &= check(consumed == 2, "nie zakodowano obu rekordow");
+    ok &= check(len <= buf_len, "blok dluzszy niz bufor");
+    ok &= check(len - first_len == BLOCK_MAX_RECORD_SIZE, "rekord najgorszego przypadku ma inna dlugosc");
+    for (size_t i = buf_len; i < sizeof(buf); i++) {
+        if (buf[i] != CANARY) {
+            ok &= check(false, "zapis za koncem bufora");
+            break;
+        }
+    }
+
+    SensorData out[2];
+    ok &= check(block_decode(buf, len, out, 2) == 2, "dekodowanie bloku");
+    ok &= check(out[1].timestamp == records[1].timestamp && out[1].pressure == records[1].pressure &&
+                out[1].sensor_id == records[1].sensor_id && out[1].seq == records[1].seq &&
+                out[1].seq_epoch == records[1].seq_epoch &&
+                out[1].count == records[1].count && out[1].peak_dt == records[1].peak_dt,
+                "rekord po dekodowaniu rozni sie od zakodowanego");
+
+    printf("Rekord najgorszego przypadku: %zu B (limit %d B) - %s\n", len - first_len, BLOCK_MAX_RECORD_SIZE,
+           ok ? "OK" : "BLAD");
+    return ok ? 0 : 1;
+}
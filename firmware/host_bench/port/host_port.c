@@ -0,0 +1,35 @@
+#include "port_internal.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+host_port_stats_t g_host_stats;
+
+static char s_dir[256] = ".";
+
+void host_port_path(const char *name, char *buf, size_t len) {
+    snprintf(buf, len, "%s/%s", s_dir, name);
+}
+
+void host_port_init(const char *dir, bool wipe) {
+    snprintf(s_dir, sizeof(s_dir), "%s", dir != NULL ? dir : ".");
+    host_partition_reset();
+    host_nvs_reset();
+
+    if (wipe) {
+        char path[300];
+        host_port_path("storage.bin", path, sizeof(path));
+        unlink(path);
+        host_port_path("nvs.bin", path, sizeof(path));
+        unlink(path);
+    }
+    host_port_reset_stats();
+}
+
+void host_port_get_stats(host_port_stats_t *out) {
+    *out = g_host_stats;
+}
+
+void host_port_reset_stats(void) {
+    memset(&g_host_stats, 0, sizeof(g_host_stats));
+}
@@ -0,0 +1,31 @@
+// Zegar i taski dla pomiarów (bez planisty): czas monotoniczny, task = bieżący wątek.
+// host_sim ma własną wersję z wirtualnym zegarem i taskami na wątkach.
+#define _GNU_SOURCE     // pthread_getname_np
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <time.h>
+
+int64_t esp_timer_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return (TaskHandle_t)pthread_self();
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    static char name[16];
+    if (pthread_getname_np((pthread_t)task, name, sizeof(name)) != 0) {
+        snprintf(name, sizeof(name), "host");
+    }
+    return name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Na hoście nie ma pamięci RTC ani IRAM. Zmienne RTC trafiają do osobnej sekcji
+// (__start_rtc_data..__stop_rtc_data), którą host_sim zachowuje na czas deep sleep.
+#define RTC_DATA_ATTR   __attribute__((section("rtc_data")))
+#define RTC_NOINIT_ATTR __attribute__((section("rtc_data")))
+#define IRAM_ATTR
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// CRC32 jak w ROM ESP32 (= crc32 z zlib)
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// Mikrosekundy zegara monotonicznego od startu procesu
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,31 @@
+#ifndef HOST_PORT_H
+#define HOST_PORT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Zamienniki ESP-IDF do budowania komponentów na Linuksie (host_bench).
+// Partycja "storage" i NVS leżą w plikach w katalogu z host_port_init, więc stan
+// przeżywa restart procesu jak na urządzeniu.
+
+#define HOST_STORAGE_SIZE   0xCF000     // partitions.csv: storage
+#define HOST_SECTOR_SIZE    4096
+
+typedef struct {
+    uint64_t flash_read;        // B odczytane z partycji
+    uint64_t flash_written;     // B zaprogramowane
+    uint32_t flash_erases;      // skasowane sektory
+    uint32_t nvs_writes;        // nvs_set_* i nvs_erase_key
+    uint64_t nvs_bytes;         // B zapisane do NVS (wpisy po 32 B jak w nvs_flash)
+    uint32_t nvs_commits;
+    uint64_t io_us;             // czas w zamiennikach flasha i NVS (I/O hosta, nie firmware)
+} host_port_stats_t;
+
+// Katalog plików partycji; wipe = zaczynamy od pustego flasha i NVS
+void host_port_init(const char *dir, bool wipe);
+
+void host_port_get_stats(host_port_stats_t *out);
+
+void host_port_reset_stats(void);
+
+#endif // HOST_PORT_H
@@ -0,0 +1,4 @@
+// Wartości domyślne z main/Kconfig.projbuild dla budowania na hoście
+#pragma once
+
+#define CONFIG_HIVE_FLASH_ENDURANCE_CYCLES 100000
@@ -0,0 +1,309 @@
+// NVS jako tablica wpisów w RAM, zapisywana w całości do pliku przy każdej zmianie.
+// Jak w nvs_flash zmiana trafia na nośnik od razu, a nvs_commit niczego nie dopisuje.
+#include "nvs_flash.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "port_internal.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "HOST_NVS";
+
+#define MAX_ENTRIES         256
+#define MAX_NAMESPACES      32
+#define NVS_ENTRY_SIZE      32      // wpis nvs_flash; str/blob zajmują dodatkowe wpisy na dane
+
+typedef struct {
+    char ns[NVS_NS_NAME_MAX_SIZE];
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    size_t len;
+    uint8_t *data;
+} nvs_entry_t;
+
+struct nvs_opaque_iterator_t {
+    char ns[NVS_NS_NAME_MAX_SIZE];
+    nvs_type_t type;
+    size_t index;
+};
+
+static nvs_entry_t s_entries[MAX_ENTRIES];
+static size_t s_count = 0;
+static bool s_initialized = false;
+
+// Uchwyt = indeks namespace + 1
+static char s_namespaces[MAX_NAMESPACES][NVS_NS_NAME_MAX_SIZE];
+static size_t s_ns_count = 0;
+
+static void clear_entries(void) {
+    for (size_t i = 0; i < s_count; i++) {
+        free(s_entries[i].data);
+    }
+    memset(s_entries, 0, sizeof(s_entries));
+    s_count = 0;
+}
+
+void host_nvs_reset(void) {
+    clear_entries();
+    s_ns_count = 0;
+    s_initialized = false;
+}
+
+static void save_file(void) {
+    char path[300];
+    host_port_path("nvs.bin", path, sizeof(path));
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Nie mozna zapisac %s", path);
+        return;
+    }
+
+    uint32_t count = s_count;
+    fwrite(&count, sizeof(count), 1, f);
+    for (size_t i = 0; i < s_count; i++) {
+        const nvs_entry_t *e = &s_entries[i];
+        uint32_t type = e->type;
+        uint32_t len = e->len;
+        fwrite(e->ns, sizeof(e->ns), 1, f);
+        fwrite(e->key, sizeof(e->key), 1, f);
+        fwrite(&type, sizeof(type), 1, f);
+        fwrite(&len, sizeof(len), 1, f);
+        fwrite(e->data, 1, e->len, f);
+    }
+    fclose(f);
+}
+
+static bool load_file(void) {
+    char path[300];
+    host_port_path("nvs.bin", path, sizeof(path));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return true;     // pusty NVS
+
+    uint32_t count = 0;
+    bool ok = fread(&count, sizeof(count), 1, f) == 1 && count <= MAX_ENTRIES;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        nvs_entry_t *e = &s_entries[i];
+        uint32_t type = 0, len = 0;
+        ok = fread(e->ns, sizeof(e->ns), 1, f) == 1 &&
+             fread(e->key, sizeof(e->key), 1, f) == 1 &&
+             fread(&type, sizeof(type), 1, f) == 1 &&
+             fread(&len, sizeof(len), 1, f) == 1 &&
+             (e->data = malloc(len > 0 ? len : 1)) != NULL &&
+             fread(e->data, 1, len, f) == len;
+        e->type = type;
+        e->len = len;
+        s_count = i + 1;
+    }
+    fclose(f);
+
+    if (!ok) clear_entries();
+    return ok;
+}
+
+esp_err_t nvs_flash_init(void) {
+    if (s_initialized) return ESP_OK;
+
+    int64_t start_us = esp_timer_get_time();
+    bool ok = load_file();
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    if (!ok) return ESP_ERR_NVS_NO_FREE_PAGES;   // uszkodzony plik - storage_init skasuje NVS
+
+    s_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    clear_entries();
+    s_ns_count = 0;
+    s_initialized = false;
+
+    char path[300];
+    host_port_path("nvs.bin", path, sizeof(path));
+    remove(path);
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    (void)open_mode;
+    if (!s_initialized) return ESP_ERR_NVS_NOT_INITIALIZED;
+    if (strlen(namespace_name) >= NVS_NS_NAME_MAX_SIZE) return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < s_ns_count; i++) {
+        if (strcmp(s_namespaces[i], namespace_name) == 0) {
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+    if (s_ns_count >= MAX_NAMESPACES) return ESP_ERR_NO_MEM;
+
+    snprintf(s_namespaces[s_ns_count], NVS_NS_NAME_MAX_SIZE, "%s", namespace_name);
+    *out_handle = ++s_ns_count;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    if (handle == 0 || handle > s_ns_count) return ESP_ERR_NVS_INVALID_HANDLE;
+    g_host_stats.nvs_commits++;
+    return ESP_OK;
+}
+
+static nvs_entry_t *find(nvs_handle_t handle, const char *key) {
+    if (handle == 0 || handle > s_ns_count) return NULL;
+
+    const char *ns = s_namespaces[handle - 1];
+    for (size_t i = 0; i < s_count; i++) {
+        if (strcmp(s_entries[i].ns, ns) == 0 && strcmp(s_entries[i].key, key) == 0) {
+            return &s_entries[i];
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, nvs_type_t type, const void *data, size_t len) {
+    if (handle == 0 || handle > s_ns_count) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (strlen(key) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_INVALID_ARG;
+
+    int64_t start_us = esp_timer_get_time();
+    nvs_entry_t *e = find(handle, key);
+    if (e == NULL) {
+        if (s_count >= MAX_ENTRIES) return ESP_ERR_NVS_NO_FREE_PAGES;
+        e = &s_entries[s_count++];
+        snprintf(e->ns, sizeof(e->ns), "%s", s_namespaces[handle - 1]);
+        snprintf(e->key, sizeof(e->key), "%s", key);
+    }
+
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    if (copy == NULL) return ESP_ERR_NO_MEM;
+    memcpy(copy, data, len);
+    free(e->data);
+    e->data = copy;
+    e->len = len;
+    e->type = type;
+
+    save_file();
+    g_host_stats.nvs_writes++;
+    g_host_stats.nvs_bytes += NVS_ENTRY_SIZE +
+        (type == NVS_TYPE_STR || type == NVS_TYPE_BLOB ? (len + NVS_ENTRY_SIZE - 1) / NVS_ENTRY_SIZE * NVS_ENTRY_SIZE : 0);
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+static esp_err_t get_value(nvs_handle_t handle, const char *key, nvs_type_t type, void *out, size_t *len) {
+    if (handle == 0 || handle > s_ns_count) return ESP_ERR_NVS_INVALID_HANDLE;
+
+    const nvs_entry_t *e = find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+    if (e->type != type) return ESP_ERR_NVS_TYPE_MISMATCH;
+
+    if (out == NULL) {
+        *len = e->len;
+        return ESP_OK;
+    }
+    if (*len < e->len) return ESP_ERR_NVS_INVALID_LENGTH;
+    memcpy(out, e->data, e->len);
+    *len = e->len;
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value) {
+    return set_value(handle, key, NVS_TYPE_I32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value) {
+    size_t len = sizeof(*out_value);
+    return get_value(handle, key, NVS_TYPE_I32, out_value, &len);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value) {
+    return set_value(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length) {
+    return get_value(handle, key, NVS_TYPE_STR, out_value, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    return set_value(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    return get_value(handle, key, NVS_TYPE_BLOB, out_value, length);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+    nvs_entry_t *e = find(handle, key);
+    if (e == NULL) return ESP_ERR_NVS_NOT_FOUND;
+
+    int64_t start_us = esp_timer_get_time();
+    free(e->data);
+    *e = s_entries[--s_count];
+    memset(&s_entries[s_count], 0, sizeof(s_entries[s_count]));
+
+    save_file();
+    g_host_stats.nvs_writes++;
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+// Iterator stoi na wpisie index; przesuwa się do następnego pasującego
+static bool seek(struct nvs_opaque_iterator_t *it) {
+    for (; it->index < s_count; it->index++) {
+        const nvs_entry_t *e = &s_entries[it->index];
+        if (strcmp(e->ns, it->ns) == 0 && (it->type == NVS_TYPE_ANY || it->type == e->type)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t nvs_entry_find(const char *part_name, const char *namespace_name, nvs_type_t type,
+                         nvs_iterator_t *output_iterator) {
+    (void)part_name;
+    *output_iterator = NULL;
+    if (!s_initialized) return ESP_ERR_NVS_NOT_INITIALIZED;
+
+    struct nvs_opaque_iterator_t *it = calloc(1, sizeof(*it));
+    if (it == NULL) return ESP_ERR_NO_MEM;
+    snprintf(it->ns, sizeof(it->ns), "%s", namespace_name);
+    it->type = type;
+
+    if (!seek(it)) {
+        free(it);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *output_iterator = it;
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_next(nvs_iterator_t *iterator) {
+    if (*iterator == NULL) return ESP_ERR_INVALID_ARG;
+
+    (*iterator)->index++;
+    if (!seek(*iterator)) {
+        free(*iterator);
+        *iterator = NULL;
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+esp_err_t nvs_entry_info(nvs_iterator_t iterator, nvs_entry_info_t *out_info) {
+    if (iterator == NULL || iterator->index >= s_count) return ESP_ERR_INVALID_ARG;
+
+    const nvs_entry_t *e = &s_entries[iterator->index];
+    memset(out_info, 0, sizeof(*out_info));
+    snprintf(out_info->namespace_name, sizeof(out_info->namespace_name), "%s", e->ns);
+    snprintf(out_info->key, sizeof(out_info->key), "%s", e->key);
+    out_info->type = e->type;
+    return ESP_OK;
+}
+
+void nvs_release_iterator(nvs_iterator_t iterator) {
+    free(iterator);
+}
@@ -0,0 +1,126 @@
+// Partycja "storage" jako plik zmapowany w pamięć - odczyt i zapis bez wywołań systemowych,
+// więc w pomiarach dominuje kod firmware, a nie I/O hosta
+#include "esp_partition.h"
+#include "esp_spiffs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "port_internal.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *TAG = "HOST_FLASH";
+
+static esp_partition_t s_storage = {
+    .type = ESP_PARTITION_TYPE_DATA,
+    .subtype = ESP_PARTITION_SUBTYPE_DATA_SPIFFS,
+    .address = 0x310000,
+    .size = HOST_STORAGE_SIZE,
+    .erase_size = HOST_SECTOR_SIZE,
+    .label = "storage",
+};
+
+static uint8_t *s_map = NULL;
+
+void host_partition_reset(void) {
+    if (s_map != NULL) {
+        munmap(s_map, HOST_STORAGE_SIZE);
+        s_map = NULL;
+    }
+}
+
+static bool open_storage(void) {
+    if (s_map != NULL) return true;
+
+    char path[300];
+    host_port_path("storage.bin", path, sizeof(path));
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Nie mozna otworzyc %s", path);
+        return false;
+    }
+
+    struct stat st;
+    bool fresh = fstat(fd, &st) == 0 && st.st_size != HOST_STORAGE_SIZE;
+    if (fresh && ftruncate(fd, HOST_STORAGE_SIZE) != 0) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, HOST_STORAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        ESP_LOGE(TAG, "mmap %s nie powiodl sie", path);
+        return false;
+    }
+
+    s_map = map;
+    if (fresh) {
+        // Nowy układ jest skasowany
+        memset(s_map, 0xFF, HOST_STORAGE_SIZE);
+    }
+    return true;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label) {
+    if (type != ESP_PARTITION_TYPE_DATA || label == NULL || strcmp(label, s_storage.label) != 0) {
+        return NULL;
+    }
+    if (subtype != ESP_PARTITION_SUBTYPE_ANY && subtype != s_storage.subtype) {
+        return NULL;
+    }
+    return open_storage() ? &s_storage : NULL;
+}
+
+static bool in_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    return partition == &s_storage && s_map != NULL &&
+           offset <= HOST_STORAGE_SIZE && size <= HOST_STORAGE_SIZE - offset;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size) {
+    if (!in_range(partition, src_offset, size)) return ESP_ERR_INVALID_SIZE;
+
+    int64_t start_us = esp_timer_get_time();
+    memcpy(dst, s_map + src_offset, size);
+    g_host_stats.flash_read += size;
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size) {
+    if (!in_range(partition, dst_offset, size)) return ESP_ERR_INVALID_SIZE;
+
+    int64_t start_us = esp_timer_get_time();
+    // NOR flash: programowanie tylko zeruje bity
+    const uint8_t *in = src;
+    for (size_t i = 0; i < size; i++) {
+        s_map[dst_offset + i] &= in[i];
+    }
+    g_host_stats.flash_written += size;
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+    if (!in_range(partition, offset, size)) return ESP_ERR_INVALID_SIZE;
+    if (offset % HOST_SECTOR_SIZE != 0 || size % HOST_SECTOR_SIZE != 0) return ESP_ERR_INVALID_SIZE;
+
+    int64_t start_us = esp_timer_get_time();
+    memset(s_map + offset, 0xFF, size);
+    g_host_stats.flash_erases += size / HOST_SECTOR_SIZE;
+    g_host_stats.io_us += esp_timer_get_time() - start_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_vfs_spiffs_register(const esp_vfs_spiffs_conf_t *conf) {
+    (void)conf;
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t esp_vfs_spiffs_unregister(const char *partition_label) {
+    (void)partition_label;
+    return ESP_OK;
+}
@@ -0,0 +1,17 @@
+#ifndef PORT_INTERNAL_H
+#define PORT_INTERNAL_H
+
+#include "host_port.h"
+#include <stddef.h>
+
+// Wspólne dla zamienników flasha i NVS
+extern host_port_stats_t g_host_stats;
+
+// <katalog z host_port_init>/<name>
+void host_port_path(const char *name, char *buf, size_t len);
+
+// Zamyka pliki, przy następnym użyciu zamienniki otworzą je od nowa
+void host_partition_reset(void);
+void host_nvs_reset(void);
+
+#endif // PORT_INTERNAL_H
@@ -0,0 +1,277 @@
+"""
+Flota symulowanych urządzeń (host_sim) przeciw lokalnemu brokerowi MQTT: wspólna przerwa
+łącza dla wszystkich jednostek i pomiar powrotu - czas opróżnienia bufora offline, duplikaty,
+brakujące rekordy i opóźnienie end-to-end pomiarów na żywo.
+
+  cmake -S firmware/host_sim -B build-sim && cmake --build build-sim
+  mosquitto -p 1883 &
+  python firmware/host_sim/fleet.py --build build-sim --units 200 --outage-h 48
+
+Przebieg (czas wirtualny = czas urządzeń, sim.h):
+  1. rozgrzewka (--warmup-s, czas rzeczywisty): zimny start, SNTP, pierwsze wysyłki;
+     zegar wirtualny jest o długość przerwy wcześniej niż rzeczywisty
+  2. przerwa łącza: zegar przyspiesza --speed razy, aż dogoni czas rzeczywisty - 48 h
+     pomiarów trafia do bufora offline w kilka minut
+  3. koniec przerwy (rozrzucony o --spread-s między jednostkami) przypada już po dogonieniu,
+     więc odzyskiwanie połączeń i opróżnianie bufora biegną w czasie rzeczywistym
+  4. obserwacja (--observe-s), potem podsumowanie
+
+Przy wielu jednostkach na kilku rdzeniach zmniejsz --speed: w czasie przerwy każda jednostka
+robi cykl pomiaru co 300/speed s rzeczywistych i gdy host nie nadąża, scheduler pomija sloty
+(mniejsza zaległość na jednostkę niż wynika z długości przerwy).
+
+Dekodowanie paczek: backend/app/services/payload_decoder.py (temat <baza>/<jednostka>/batch).
+"""
+import argparse
+import importlib.util
+import os
+import random
+import shutil
+import signal
+import statistics
+import subprocess
+import sys
+import threading
+import time
+from collections import defaultdict
+import paho.mqtt.client as mqtt
+
+ROOT = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", ".."))
+BASE_TOPIC = "esp32/smartfridge"
+
+
+def load_decoder():
+    # Bez importu pakietu app (Flask, baza) - dekoder używa tylko struct
+    path = os.path.join(ROOT, "backend", "app", "services", "payload_decoder.py")
+    spec = importlib.util.spec_from_file_location("payload_decoder", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+class Clock:
+    """Ten sam zegar wirtualny co sim_clock.c."""
+
+    def __init__(self, t0, lead_s, speed):
+        self.t0 = t0
+        self.lead = lead_s
+        self.speed = speed
+        self.catch_up = t0 + lead_s / (speed - 1.0) if speed > 1.0 else t0 + lead_s
+
+    def virtual(self, real):
+        gained = min(max(real - self.t0, 0.0) * (self.speed - 1.0), self.lead) if self.speed > 1.0 else 0.0
+        return real - self.lead + gained
+
+
+class Collector:
+    """Subskrybent paczek: zapisuje każdy rekord z chwilą odbioru (czas rzeczywisty)."""
+
+    def __init__(self, decoder, host, port, user, password):
+        self.decoder = decoder
+        self.lock = threading.Lock()
+        self.records = defaultdict(list)    # jednostka -> [(odbiór, rekord)]
+        self.messages = 0
+        self.bad = 0
+        self.diag = 0
+        self.client = mqtt.Client(mqtt.CallbackAPIVersion.VERSION2, client_id=f"fleet-{os.getpid()}")
+        if user:
+            self.client.username_pw_set(user, password)
+        self.client.on_connect = self.on_connect
+        self.client.on_message = self.on_message
+        self.client.connect(host, port, keepalive=60)
+        self.client.loop_start()
+
+    def on_connect(self, client, userdata, flags, reason_code, properties):
+        client.subscribe([(f"{BASE_TOPIC}/+/batch", 1), (f"{BASE_TOPIC}/+/diag", 0)])
+
+    def on_message(self, client, userdata, msg):
+        arrival = time.time()
+        parts = msg.topic.split("/")
+        if parts[-1] == "diag":
+            self.diag += 1
+            return
+        try:
+            records = self.decoder.decode_batch(msg.payload)
+        except ValueError:
+            with self.lock:
+                self.bad += 1
+            return
+        with self.lock:
+            self.messages += 1
+            self.records[parts[2]].extend((arrival, r) for r in records)
+
+    def stop(self):
+        self.client.loop_stop()
+        self.client.disconnect()
+
+
+def percentile(values, p):
+    if not values:
+        return float("nan")
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(p / 100.0 * len(ordered)))]
+
+
+def describe(values, unit="s"):
+    if not values:
+        return "brak danych"
+    return (f"mediana {statistics.median(values):.1f} {unit}, p95 {percentile(values, 95):.1f} {unit}, "
+            f"max {max(values):.1f} {unit}")
+
+
+def parse_broker(uri):
+    host_port = uri.split("://", 1)[-1]
+    host, _, port = host_port.partition(":")
+    return host, int(port or 1883)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flota host_sim: przerwa łącza i powrót do brokera")
+    parser.add_argument("--build", default=os.path.join(ROOT, "build-sim"), help="katalog budowania host_sim")
+    parser.add_argument("--dir", default="/tmp/host_sim_fleet", help="katalog flasha, NVS i logów jednostek")
+    parser.add_argument("--units", type=int, default=20)
+    parser.add_argument("--broker", default="mqtt://127.0.0.1:1883")
+    parser.add_argument("--user", default=os.getenv("MQTT_LOGIN"))
+    parser.add_argument("--password", default=os.getenv("MQTT_PASS"))
+    parser.add_argument("--outage-h", type=float, default=48.0, help="długość przerwy łącza (h czasu wirtualnego)")
+    parser.add_argument("--speed", type=float, default=1440.0, help="przyspieszenie zegara w czasie przerwy")
+    parser.add_argument("--warmup-s", type=float, default=30.0, help="rozgrzewka przed przerwą (s rzeczywiste)")
+    parser.add_argument("--spread-s", type=float, default=5.0, help="rozrzut końca przerwy między jednostkami")
+    # Jednostka wraca do sieci dopiero w swoim slocie wysyłki (domyślnie co 300 s)
+    parser.add_argument("--observe-s", type=float, default=600.0, help="obserwacja po końcu przerwy")
+    parser.add_argument("--deep-sleep", action="store_true", help="host_sim_sleep zamiast trybu ciągłego")
+    parser.add_argument("--sensors", default=None, help="SIM_SENSORS dla wszystkich jednostek")
+    parser.add_argument("--crc-faults", type=float, default=0.0, help="prawdopodobieństwo błędu CRC odczytu")
+    parser.add_argument("--wifi-fail", type=float, default=0.0, help="prawdopodobieństwo nieudanego skojarzenia")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    binary = os.path.join(args.build, "host_sim_sleep" if args.deep_sleep else "host_sim")
+    if not os.path.exists(binary):
+        sys.exit(f"Brak {binary} - zbuduj firmware/host_sim")
+
+    decoder = load_decoder()
+    host, port = parse_broker(args.broker)
+    collector = Collector(decoder, host, port, args.user, args.password)
+
+    lead = args.outage_h * 3600.0
+    t0 = time.time() + args.warmup_s
+    clock = Clock(t0, lead, args.speed)
+    outage_from = t0 - lead                     # czas wirtualny w chwili T0
+    end = clock.catch_up + args.spread_s + args.observe_s
+    rng = random.Random(args.seed)
+
+    shutil.rmtree(args.dir, ignore_errors=True)
+    units = {}
+    for i in range(args.units):
+        name = f"sim{i:03d}"
+        unit_dir = os.path.join(args.dir, name)
+        os.makedirs(unit_dir)
+        outage_to = clock.catch_up + rng.uniform(0, args.spread_s)
+        env = dict(os.environ,
+                   SIM_UNIT=name,
+                   SIM_DIR=unit_dir,
+                   SIM_BROKER=args.broker,
+                   SIM_TOPIC_BASE=BASE_TOPIC,
+                   SIM_CLOCK_T0=f"{t0:.6f}",
+                   SIM_CLOCK_LEAD_S=f"{lead:.0f}",
+                   SIM_CLOCK_SPEED=f"{args.speed}",
+                   SIM_WIFI_OUTAGES=f"{outage_from:.3f}-{outage_to:.3f}",
+                   SIM_WIFI_FAIL=f"{args.wifi_fail}",
+                   SIM_CRC_FAULTS=f"{args.crc_faults}",
+                   SIM_END_S=f"{end:.3f}",
+                   SIM_SEED=str(args.seed + i),
+                   SIM_LOG=os.getenv("SIM_LOG", "warn"))
+        if args.user:
+            env.update(SIM_MQTT_USER=args.user, SIM_MQTT_PASS=args.password or "")
+        if args.sensors:
+            env["SIM_SENSORS"] = args.sensors
+        log = open(os.path.join(unit_dir, "log.txt"), "w")
+        process = subprocess.Popen([binary], env=env, stdout=log, stderr=subprocess.STDOUT)
+        units[name] = {"process": process, "log": log, "outage_to": outage_to}
+
+    print(f"{args.units} jednostek, przerwa {args.outage_h:g} h od T0 za {args.warmup_s:.0f} s, "
+          f"przyspieszenie x{args.speed:g} (dogonienie po {clock.catch_up - t0:.0f} s), "
+          f"koniec za {end - time.time():.0f} s")
+
+    interrupted = False
+    try:
+        while time.time() < end + 5 and any(u["process"].poll() is None for u in units.values()):
+            time.sleep(1)
+    except KeyboardInterrupt:
+        interrupted = True
+    for u in units.values():
+        if u["process"].poll() is None:
+            u["process"].send_signal(signal.SIGTERM)
+    for u in units.values():
+        try:
+            u["process"].wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            u["process"].kill()
+        u["log"].close()
+    collector.stop()
+
+    report(args, clock, units, collector, interrupted)
+
+
+def report(args, clock, units, collector, interrupted):
+    drain_times = []
+    backlog_sizes = []
+    live_latency = []
+    total = unique = duplicates = missing = 0
+    not_drained = []
+    crashed = [name for name, u in units.items() if u["process"].returncode not in (0, -signal.SIGTERM)]
+
+    for name, u in units.items():
+        first_arrival = {}      # seq -> pierwszy odbiór
+        first_live_seq = None
+        for arrival, record in collector.records.get(name, []):
+            total += 1
+            # Jedna epoka numeracji na jednostkę - flota startuje z pustym flashem i NVS
+            key = record["seq"] if record["seq"] is not None else (record["ts"], record["id"])
+            if key in first_arrival:
+                duplicates += 1
+                continue
+            first_arrival[key] = arrival
+            if record["ts"] >= u["outage_to"]:
+                live_latency.append(clock.virtual(arrival) - record["ts"])
+                if record["seq"] is not None and (first_live_seq is None or record["seq"] < first_live_seq):
+                    first_live_seq = record["seq"]
+        unique += len(first_arrival)
+
+        # Numery rosną z chwilą pomiaru (record_seq.h), więc zaległość po przerwie to wszystkie
+        # numery przed pierwszym pomiarem na żywo; opróżniona = wszystkie dotarły
+        seqs = [k for k in first_arrival if isinstance(k, int)]
+        if not seqs:
+            not_drained.append(name)
+            continue
+        backlog_end = first_live_seq if first_live_seq is not None else max(seqs) + 1
+        backlog = range(min(seqs), backlog_end)
+        absent = sum(1 for seq in backlog if seq not in first_arrival)
+        missing += absent
+        backlog_sizes.append(len(backlog))
+        if absent or first_live_seq is None:
+            not_drained.append(name)
+        else:
+            last = max(first_arrival[seq] for seq in backlog)
+            drain_times.append(max(last - u["outage_to"], 0.0))
+
+    print()
+    print(f"Wiadomości: {collector.messages} (błędne: {collector.bad}, diag: {collector.diag})")
+    print(f"Rekordy: {total}, unikalne {unique}, duplikaty {duplicates} "
+          f"({100.0 * duplicates / total if total else 0:.2f}%), brakujące z zaległości {missing}")
+    print(f"Zaległość na jednostkę: {describe(backlog_sizes, 'rekordów')}")
+    print(f"Opróżnienie bufora po przerwie {args.outage_h:g} h ({len(drain_times)}/{len(units)} jednostek): "
+          f"{describe(drain_times)}")
+    if not_drained:
+        print(f"Nieopróżnione do końca obserwacji: {', '.join(not_drained[:10])}"
+              f"{' ...' if len(not_drained) > 10 else ''} - wydłuż --observe-s")
+    print(f"Opóźnienie end-to-end pomiarów na żywo: {describe(live_latency)}")
+    if crashed:
+        print(f"Nieoczekiwany koniec procesu: {', '.join(crashed)} (logi w {args.dir})")
+    if interrupted:
+        print("Przerwano - wyniki częściowe")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_NC     (-1)
+#define GPIO_NUM_0      0
+#define GPIO_NUM_4      4
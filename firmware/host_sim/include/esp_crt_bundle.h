@@ -0,0 +1,6 @@
+#pragma once
+
+#include "esp_err.h"
+
+// Połączenie z lokalnym brokerem jest bez TLS - certyfikaty nie są używane
+esp_err_t esp_crt_bundle_attach(void *conf);
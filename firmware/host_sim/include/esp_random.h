@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+// Losowe 32 bity (sim_main.c, z generatora instancji)
+uint32_t esp_random(void);
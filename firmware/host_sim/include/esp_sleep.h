@@ -0,0 +1,20 @@
+#pragma once
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include <stdint.h>
+
+// Deep sleep = zapis pamięci RTC, uśpienie procesu i execv tego samego programu (sim_sleep.c)
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,     // zimny start
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+} esp_sleep_wakeup_cause_t;
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us);
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level);
+void esp_deep_sleep_start(void) __attribute__((noreturn));
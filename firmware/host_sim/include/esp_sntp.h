@@ -0,0 +1,18 @@
+#pragma once
+
+// SNTP bez sieci: synchronizacja = ustawienie zegara urządzenia na czas wirtualny,
+// kiedy WiFi jest połączone (sim_wifi.c)
+
+#define SNTP_OPMODE_POLL    0
+
+typedef enum {
+    SNTP_SYNC_STATUS_RESET,
+    SNTP_SYNC_STATUS_COMPLETED,
+    SNTP_SYNC_STATUS_IN_PROGRESS,
+} sntp_sync_status_t;
+
+void esp_sntp_setoperatingmode(int mode);
+void esp_sntp_setservername(int idx, const char *server);
+void esp_sntp_init(void);
+void esp_sntp_stop(void);
+sntp_sync_status_t sntp_get_sync_status(void);
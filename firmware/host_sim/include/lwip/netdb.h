@@ -0,0 +1,3 @@
+#pragma once
+
+// Bez odpowiednika na hoście - wszystko, czego używa firmware, jest w lwip/sockets.h
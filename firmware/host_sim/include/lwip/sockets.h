@@ -0,0 +1,11 @@
+#pragma once
+
+// Gniazda lwIP = gniazda systemowe (test WAN w wifi_connect.c, domyślnie wyłączony)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ipaddr_addr(cp)     inet_addr(cp)
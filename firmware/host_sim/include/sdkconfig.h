@@ -0,0 +1,40 @@
+// Konfiguracja firmware dla host_sim: wartości domyślne z main/Kconfig.projbuild,
+// broker i temat MQTT z konfiguracji instancji (sim.h), OTA i BLE wyłączone.
+#pragma once
+
+#include "sim.h"
+
+#define CONFIG_HIVE_MQTT_BROKER_URI             sim_broker_uri()
+#define CONFIG_HIVE_MQTT_USERNAME               sim_mqtt_username()
+#define CONFIG_HIVE_MQTT_PASSWORD               sim_mqtt_password()
+#define CONFIG_HIVE_MQTT_TOPIC                  sim_mqtt_topic()
+#define CONFIG_HIVE_MQTT_INFLIGHT_WINDOW        16
+#define CONFIG_HIVE_MQTT_BATCH_PAYLOAD          1
+#define CONFIG_HIVE_BACKLOG_MAX_RECORDS         1024
+#define CONFIG_HIVE_BACKLOG_MAX_MS              15000
+#define CONFIG_HIVE_FLASH_ENDURANCE_CYCLES      100000
+#define CONFIG_HIVE_DIAG                        1
+
+#define CONFIG_HIVE_ONEWIRE_GPIOS               "4"
+#define CONFIG_HIVE_ONEWIRE_SENSORS_PER_BUS     10
+#define CONFIG_HIVE_DS18B20_RESOLUTION          12
+#define CONFIG_HIVE_DS18B20_RESCAN_S            3600
+
+// Dwa pliki wykonywalne: host_sim (tryb ciągły) i host_sim_sleep (SIM_DEEP_SLEEP=1)
+#if SIM_DEEP_SLEEP
+#define CONFIG_HIVE_DEEP_SLEEP                  1
+#define CONFIG_HIVE_SLEEP_INTERVAL_S            300
+#define CONFIG_HIVE_DEEP_SLEEP_UPLINK_EVERY     12
+#endif
+
+#define CONFIG_HIVE_WIFI_IP_DHCP                1
+
+#define CONFIG_HIVE_ALARM_HIGH                  80
+#define CONFIG_HIVE_ALARM_LOW                   -300
+#define CONFIG_HIVE_ALARM_HYSTERESIS            5
+#define CONFIG_HIVE_ALARM_MIN_DURATION_S        60
+#define CONFIG_HIVE_ALARM_WATCH_PERIOD_S        15
+
+#define CONFIG_HIVE_DEADBAND_EPSILON            20
+#define CONFIG_HIVE_DEADBAND_HEARTBEAT_S        3600
+#define CONFIG_HIVE_AGGREGATION_WINDOW_S        300
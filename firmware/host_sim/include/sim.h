@@ -0,0 +1,58 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Wspólne dla zamienników host_sim. Konfiguracja instancji ze zmiennych środowiska
+// (przeżywają deep sleep = execv), opis w CMakeLists.txt.
+
+// --- Zegar wirtualny ---
+// Wspólny dla wszystkich instancji: v(t) = t - L + min(max(t - T0, 0) * (S - 1), L),
+// czyli od T0 biegnie S razy szybciej, aż dogoni czas rzeczywisty (SIM_CLOCK_T0/LEAD_S/SPEED).
+// Wszystkie opóźnienia i timeouty firmware liczone są w tym zegarze.
+
+void sim_clock_init(void);
+
+// Czas wirtualny (us od 1970) - "prawdziwy" czas świata symulacji
+int64_t sim_now_us(void);
+
+// Chwila rzeczywista (CLOCK_REALTIME), w której zegar wirtualny osiągnie virtual_us
+void sim_real_deadline(int64_t virtual_us, struct timespec *out);
+
+// Uśpienie wątku do chwili wirtualnej
+void sim_sleep_until(int64_t virtual_us);
+
+// Zegar urządzenia (time/gettimeofday): po zimnym starcie od 1970, po SNTP = czas wirtualny.
+// Przesunięcie trzymane w pamięci RTC, więc deep sleep go nie kasuje.
+void sim_wall_init(bool cold_boot);
+void sim_wall_sync(void);
+
+// --- Sieć ---
+// Łącze (WiFi + droga do brokera) wg SIM_WIFI_OUTAGES: "od-do,od-do" w sekundach czasu wirtualnego
+bool sim_link_up(void);
+bool sim_wifi_connected(void);
+
+// --- Konfiguracja instancji ---
+const char *sim_env(const char *name, const char *def);
+double sim_env_double(const char *name, double def);
+
+const char *sim_unit_name(void);
+const char *sim_broker_uri(void);
+const char *sim_mqtt_username(void);
+const char *sim_mqtt_password(void);
+const char *sim_mqtt_topic(void);
+
+// Koniec symulacji (SIM_END_S, czas wirtualny); 0 = bez końca
+int64_t sim_end_us(void);
+
+// Liczba losowa [0, 1) - ziarno z SIM_SEED i nazwy jednostki
+double sim_random(void);
+
+// --- Deep sleep ---
+// Odtwarza pamięć RTC po wybudzeniu; false = zimny start
+bool sim_rtc_restore(void);
+void sim_set_argv(char **argv);
+
+#endif // SIM_H
@@ -0,0 +1,106 @@
+// Zegar wirtualny (sim.h): esp_timer, zegar urządzenia (time/gettimeofday przez -Wl,--wrap)
+// i przeliczanie chwil wirtualnych na rzeczywiste dla opóźnień i timeoutów
+#include "sim.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+static int64_t s_t0_us;         // chwila rzeczywista startu przyspieszenia
+static int64_t s_lead_us;       // o ile zegar wirtualny jest wcześniej w chwili T0
+static double s_speed = 1.0;
+static int64_t s_boot_us;       // czas wirtualny startu procesu (esp_timer = 0)
+
+// Zegar urządzenia = czas wirtualny + przesunięcie; pamięć RTC, więc przeżywa deep sleep
+static RTC_DATA_ATTR int64_t s_wall_offset_us;
+
+static int64_t real_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int64_t virtual_at(int64_t real_us) {
+    int64_t gained = 0;
+    if (s_speed > 1.0 && real_us > s_t0_us) {
+        double ahead = (double)(real_us - s_t0_us) * (s_speed - 1.0);
+        gained = (ahead < (double)s_lead_us) ? (int64_t)ahead : s_lead_us;
+    }
+    return real_us - s_lead_us + gained;
+}
+
+void sim_clock_init(void) {
+    // T0 zapisany w środowisku - kolejne wybudzenia (execv) liczą ten sam zegar
+    if (getenv("SIM_CLOCK_T0") == NULL) {
+        char t0[32];
+        snprintf(t0, sizeof(t0), "%.6f", real_now_us() / 1e6);
+        setenv("SIM_CLOCK_T0", t0, 1);
+    }
+    s_t0_us = (int64_t)(sim_env_double("SIM_CLOCK_T0", 0) * 1e6);
+    s_lead_us = (int64_t)(sim_env_double("SIM_CLOCK_LEAD_S", 0) * 1e6);
+    s_speed = sim_env_double("SIM_CLOCK_SPEED", 1.0);
+    if (s_speed < 1.0) s_speed = 1.0;
+    if (s_lead_us < 0) s_lead_us = 0;
+
+    s_boot_us = sim_now_us();
+}
+
+int64_t sim_now_us(void) {
+    return virtual_at(real_now_us());
+}
+
+void sim_real_deadline(int64_t virtual_us, struct timespec *out) {
+    int64_t real_us;
+    int64_t v0 = s_t0_us - s_lead_us;   // czas wirtualny w chwili T0
+
+    if (s_speed <= 1.0 || s_lead_us == 0 || virtual_us <= v0) {
+        real_us = virtual_us + s_lead_us;
+    } else {
+        // Po dogonieniu (v == t) zegar biegnie już normalnie
+        int64_t catch_up_us = s_t0_us + (int64_t)(s_lead_us / (s_speed - 1.0));
+        real_us = (virtual_us >= catch_up_us) ? virtual_us
+                                              : s_t0_us + (int64_t)((virtual_us - v0) / s_speed);
+    }
+    out->tv_sec = real_us / 1000000;
+    out->tv_nsec = (real_us % 1000000) * 1000;
+}
+
+void sim_sleep_until(int64_t virtual_us) {
+    struct timespec deadline;
+    sim_real_deadline(virtual_us, &deadline);
+    while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+int64_t esp_timer_get_time(void) {
+    return sim_now_us() - s_boot_us;
+}
+
+void sim_wall_init(bool cold_boot) {
+    if (cold_boot) {
+        s_wall_offset_us = -s_boot_us;  // zegar RTC po włączeniu zasilania: 1970
+    }
+}
+
+void sim_wall_sync(void) {
+    s_wall_offset_us = 0;
+}
+
+time_t __wrap_time(time_t *out);
+int __wrap_gettimeofday(struct timeval *tv, void *tz);
+
+time_t __wrap_time(time_t *out) {
+    time_t now = (time_t)((sim_now_us() + s_wall_offset_us) / 1000000);
+    if (out != NULL) *out = now;
+    return now;
+}
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz) {
+    (void)tz;
+    int64_t now_us = sim_now_us() + s_wall_offset_us;
+    tv->tv_sec = (time_t)(now_us / 1000000);
+    tv->tv_usec = (suseconds_t)(now_us % 1000000);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Start instancji: konfiguracja ze zmiennych środowiska, pamięć RTC po wybudzeniu, app_main()
+// z main/main.c. Proces działa do SIM_END_S (czas wirtualny) albo do sygnału.
+#include "sim.h"
+#include "host_port.h"
+#include "ble_config.h"
+#include "esp_random.h"
+#include "esp_log.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+void app_main(void);
+
+// --- Konfiguracja instancji ---
+
+const char *sim_env(const char *name, const char *def) {
+    const char *value = getenv(name);
+    return (value != NULL && value[0] != '\0') ? value : def;
+}
+
+double sim_env_double(const char *name, double def) {
+    const char *value = getenv(name);
+    if (value == NULL || value[0] == '\0') return def;
+    return strtod(value, NULL);
+}
+
+const char *sim_unit_name(void) {
+    return sim_env("SIM_UNIT", "sim0");
+}
+
+const char *sim_broker_uri(void) {
+    return sim_env("SIM_BROKER", "mqtt://127.0.0.1:1883");
+}
+
+// NULL = połączenie bez logowania (anonimowy broker)
+const char *sim_mqtt_username(void) {
+    return sim_env("SIM_MQTT_USER", NULL);
+}
+
+const char *sim_mqtt_password(void) {
+    return sim_env("SIM_MQTT_PASS", NULL);
+}
+
+// Jak CONFIG_HIVE_MQTT_TOPIC: ostatni człon jest obcinany, zostaje prefiks <baza>/<jednostka>
+static char s_topic[160];
+static pthread_once_t s_topic_once = PTHREAD_ONCE_INIT;
+
+static void build_topic(void) {
+    snprintf(s_topic, sizeof(s_topic), "%s/%s/data", sim_env("SIM_TOPIC_BASE", "esp32/smartfridge"),
+             sim_unit_name());
+}
+
+const char *sim_mqtt_topic(void) {
+    pthread_once(&s_topic_once, build_topic);
+    return s_topic;
+}
+
+int64_t sim_end_us(void) {
+    return (int64_t)(sim_env_double("SIM_END_S", 0) * 1e6);
+}
+
+static uint64_t s_random_state;
+static pthread_mutex_t s_random_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void seed_random(void) {
+    uint64_t seed = (uint64_t)sim_env_double("SIM_SEED", 1);
+    for (const char *p = sim_unit_name(); *p; p++) seed = (seed ^ (uint8_t)*p) * 0x100000001B3ull;
+    seed ^= (uint64_t)sim_now_us();     // inny ciąg po każdym wybudzeniu
+    s_random_state = seed ? seed : 0x9E3779B97F4A7C15ull;
+}
+
+// xorshift64* - wystarczy do szumu i wstrzykiwania błędów
+double sim_random(void) {
+    pthread_mutex_lock(&s_random_lock);
+    uint64_t x = s_random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    s_random_state = x;
+    pthread_mutex_unlock(&s_random_lock);
+    return (double)((x * 0x2545F4914F6CDD1Dull) >> 11) / (double)(1ull << 53);
+}
+
+uint32_t esp_random(void) {
+    return (uint32_t)(sim_random() * 4294967296.0);
+}
+
+// --- BLE: bez radia, sesja konfiguracji nigdy nie jest aktywna ---
+
+void ble_config_init(gpio_num_t boot_btn_gpio) {
+    (void)boot_btn_gpio;
+}
+
+void ble_config_stop(void) {
+}
+
+bool ble_config_is_active(void) {
+    return false;
+}
+
+static esp_log_level_t parse_log_level(const char *name) {
+    static const char *names[] = { "none", "error", "warn", "info", "debug", "verbose" };
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) return (esp_log_level_t)i;
+    }
+    return ESP_LOG_INFO;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    sim_set_argv(argv);
+    setvbuf(stderr, NULL, _IOLBF, 0);   // logi wielu instancji do plików, linia po linii
+    esp_log_level_set("*", parse_log_level(sim_env("SIM_LOG", "info")));
+
+    sim_clock_init();
+    host_port_init(sim_env("SIM_DIR", "."), false);
+    bool woke = sim_rtc_restore();
+    sim_wall_init(!woke);
+    seed_random();
+
+    app_main();
+
+    // app_main wraca po starcie tasków (tryb ciągły); deep sleep kończy się execv w esp_deep_sleep_start
+    int64_t end_us = sim_end_us();
+    if (end_us > 0) {
+        sim_sleep_until(end_us);
+        fflush(NULL);
+        exit(0);
+    }
+    for (;;) pause();
+}
@@ -0,0 +1,608 @@
+// Klient MQTT 3.1.1 nad zwykłym TCP z API esp-mqtt (mqtt_client.h): task klienta łączy się,
+// odbiera pakiety i woła zdarzenia; po zerwaniu wznawia połączenie jak esp-mqtt.
+// Połączenie działa tylko przy połączonym symulowanym WiFi (sim_wifi.c).
+#include "sim.h"
+#include "mqtt_client.h"
+#include "esp_crt_bundle.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char *TAG = "SIM_MQTT";
+
+#define DEFAULT_PORT            1883
+#define DEFAULT_KEEPALIVE_S     120
+#define DEFAULT_TIMEOUT_MS      10000
+#define DEFAULT_RECONNECT_MS    10000
+#define POLL_SLICE_MS           50      // rzeczywiste ms - jak często task sprawdza łącze i stop
+#define RX_BUFFER_INITIAL       2048
+
+#define PKT_CONNECT     0x10
+#define PKT_CONNACK     0x20
+#define PKT_PUBLISH     0x30
+#define PKT_PUBACK      0x40
+#define PKT_SUBSCRIBE   0x82
+#define PKT_SUBACK      0x90
+#define PKT_PINGREQ     0xC0
+#define PKT_PINGRESP    0xD0
+#define PKT_DISCONNECT  0xE0
+
+#define CLIENT_STOP_BIT     BIT0
+#define CLIENT_STOPPED_BIT  BIT1
+
+struct esp_mqtt_client {
+    char host[128];
+    char port[8];
+    char client_id[64];
+    char *username;
+    char *password;
+    int keepalive_s;
+    int timeout_ms;
+    int reconnect_ms;
+    bool auto_reconnect;
+
+    esp_event_handler_t handler;
+    void *handler_arg;
+
+    pthread_mutex_t lock;       // stan połączenia i zapis do gniazda
+    int sock;
+    bool connected;
+    bool running;
+    uint16_t last_msg_id;
+    int64_t last_tx_us;
+    int64_t ping_sent_us;       // 0 = brak PINGREQ bez odpowiedzi
+
+    uint8_t *rx;
+    size_t rx_len;
+    size_t rx_cap;
+
+    EventGroupHandle_t state;
+    esp_mqtt_error_codes_t error;
+};
+
+static void dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, esp_mqtt_event_t *event) {
+    esp_mqtt_event_t empty = {0};
+    if (event == NULL) event = &empty;
+    event->event_id = id;
+    event->client = client;
+    event->error_handle = &client->error;
+    if (client->handler != NULL) {
+        client->handler(client->handler_arg, "MQTT_EVENTS", id, event);
+    }
+}
+
+// --- Kodowanie pakietów ---
+
+static size_t put_remaining_length(uint8_t *p, size_t len) {
+    size_t n = 0;
+    do {
+        uint8_t byte = len % 128;
+        len /= 128;
+        p[n++] = byte | (len > 0 ? 0x80 : 0);
+    } while (len > 0);
+    return n;
+}
+
+static size_t put_string(uint8_t *p, const char *s, size_t len) {
+    p[0] = (uint8_t)(len >> 8);
+    p[1] = (uint8_t)len;
+    memcpy(p + 2, s, len);
+    return len + 2;
+}
+
+// Wysyła pakiet: nagłówek + body; wołać z client->lock
+static bool send_packet(esp_mqtt_client_handle_t client, uint8_t type, const uint8_t *body, size_t body_len,
+                        const uint8_t *tail, size_t tail_len) {
+    if (client->sock < 0) return false;
+
+    uint8_t header[5];
+    header[0] = type;
+    size_t header_len = 1 + put_remaining_length(header + 1, body_len + tail_len);
+
+    struct iovec parts[3] = {
+        { header, header_len },
+        { (void *)body, body_len },
+        { (void *)tail, tail_len },
+    };
+    struct msghdr msg = { .msg_iov = parts, .msg_iovlen = tail_len ? 3 : 2 };
+    size_t total = header_len + body_len + tail_len;
+
+    while (total > 0) {
+        ssize_t sent = sendmsg(client->sock, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            client->error.esp_transport_sock_errno = errno;
+            shutdown(client->sock, SHUT_RDWR);  // task klienta zobaczy zerwanie
+            return false;
+        }
+        total -= (size_t)sent;
+        while (sent > 0 && msg.msg_iovlen > 0) {
+            size_t chunk = (size_t)sent < msg.msg_iov->iov_len ? (size_t)sent : msg.msg_iov->iov_len;
+            msg.msg_iov->iov_base = (uint8_t *)msg.msg_iov->iov_base + chunk;
+            msg.msg_iov->iov_len -= chunk;
+            sent -= (ssize_t)chunk;
+            if (msg.msg_iov->iov_len == 0) {
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            }
+        }
+    }
+    client->last_tx_us = sim_now_us();
+    return true;
+}
+
+static uint16_t next_msg_id(esp_mqtt_client_handle_t client) {
+    if (++client->last_msg_id == 0) client->last_msg_id = 1;
+    return client->last_msg_id;
+}
+
+// --- Odbiór ---
+
+// Całkowita długość pierwszego pakietu w buforze; 0 = jeszcze niekompletny
+static size_t packet_length(const uint8_t *buf, size_t len, size_t *header_len, size_t *body_len) {
+    size_t value = 0;
+    for (size_t i = 1; i < len && i <= 4; i++) {
+        value |= (size_t)(buf[i] & 0x7F) << (7 * (i - 1));
+        if (!(buf[i] & 0x80)) {
+            *header_len = i + 1;
+            *body_len = value;
+            return (len >= i + 1 + value) ? i + 1 + value : 0;
+        }
+    }
+    return 0;
+}
+
+static void handle_publish(esp_mqtt_client_handle_t client, uint8_t flags, uint8_t *body, size_t len) {
+    if (len < 2) return;
+    size_t topic_len = ((size_t)body[0] << 8) | body[1];
+    int qos = (flags >> 1) & 0x03;
+    size_t offset = 2 + topic_len;
+    uint16_t msg_id = 0;
+    if (qos > 0) {
+        if (len < offset + 2) return;
+        msg_id = (uint16_t)((body[offset] << 8) | body[offset + 1]);
+        offset += 2;
+    }
+    if (offset > len) return;
+
+    esp_mqtt_event_t event = {
+        .topic = (char *)body + 2,
+        .topic_len = (int)topic_len,
+        .data = (char *)body + offset,
+        .data_len = (int)(len - offset),
+        .total_data_len = (int)(len - offset),
+        .current_data_offset = 0,
+        .msg_id = msg_id,
+        .retain = flags & 0x01,
+        .qos = qos,
+        .dup = (flags & 0x08) != 0,
+    };
+    dispatch(client, MQTT_EVENT_DATA, &event);
+
+    if (qos == 1) {
+        uint8_t ack[2] = { (uint8_t)(msg_id >> 8), (uint8_t)msg_id };
+        pthread_mutex_lock(&client->lock);
+        send_packet(client, PKT_PUBACK, ack, sizeof(ack), NULL, 0);
+        pthread_mutex_unlock(&client->lock);
+    }
+}
+
+static void handle_packet(esp_mqtt_client_handle_t client, uint8_t type, uint8_t *body, size_t len) {
+    esp_mqtt_event_t event = {0};
+    switch (type & 0xF0) {
+        case PKT_PUBLISH:
+            handle_publish(client, type & 0x0F, body, len);
+            break;
+        case PKT_PUBACK:
+            if (len < 2) break;
+            event.msg_id = (body[0] << 8) | body[1];
+            dispatch(client, MQTT_EVENT_PUBLISHED, &event);
+            break;
+        case PKT_SUBACK:
+            if (len < 2) break;
+            event.msg_id = (body[0] << 8) | body[1];
+            event.data = (char *)body + 2;
+            event.data_len = (int)len - 2;
+            dispatch(client, MQTT_EVENT_SUBSCRIBED, &event);
+            break;
+        case PKT_PINGRESP:
+            client->ping_sent_us = 0;
+            break;
+        default:
+            ESP_LOGW(TAG, "Nieobslugiwany pakiet 0x%02x", type);
+            break;
+    }
+}
+
+// Czyta z gniazda, co jest dostępne (czeka najwyżej wait_ms rzeczywistych). false = zerwanie.
+static bool receive(esp_mqtt_client_handle_t client, int wait_ms) {
+    struct pollfd pfd = { .fd = client->sock, .events = POLLIN };
+    int ready = poll(&pfd, 1, wait_ms);
+    if (ready < 0) return errno == EINTR;
+    if (ready == 0) return true;
+
+    if (client->rx_cap - client->rx_len < 512) {
+        size_t cap = client->rx_cap * 2;
+        uint8_t *rx = realloc(client->rx, cap);
+        if (rx == NULL) return false;
+        client->rx = rx;
+        client->rx_cap = cap;
+    }
+    ssize_t n = recv(client->sock, client->rx + client->rx_len, client->rx_cap - client->rx_len, 0);
+    if (n <= 0) {
+        client->error.esp_transport_sock_errno = (n == 0) ? ECONNRESET : errno;
+        return false;
+    }
+    client->rx_len += (size_t)n;
+    return true;
+}
+
+// Obsługuje i zdejmuje z bufora wszystkie kompletne pakiety
+static void process_rx(esp_mqtt_client_handle_t client) {
+    size_t header_len, body_len, total;
+    while ((total = packet_length(client->rx, client->rx_len, &header_len, &body_len)) > 0) {
+        handle_packet(client, client->rx[0], client->rx + header_len, body_len);
+        memmove(client->rx, client->rx + total, client->rx_len - total);
+        client->rx_len -= total;
+    }
+}
+
+// --- Sesja ---
+
+static bool parse_uri(esp_mqtt_client_handle_t client, const char *uri, uint32_t config_port) {
+    const char *host = strstr(uri, "://");
+    if (host == NULL || strncmp(uri, "mqtt://", 7) != 0) {
+        ESP_LOGE(TAG, "Obslugiwane tylko mqtt:// (broker lokalny bez TLS): %s", uri);
+        return false;
+    }
+    host += 3;
+    const char *colon = strchr(host, ':');
+    const char *slash = strchr(host, '/');
+    size_t host_len = colon ? (size_t)(colon - host) : slash ? (size_t)(slash - host) : strlen(host);
+    if (host_len == 0 || host_len >= sizeof(client->host)) return false;
+    memcpy(client->host, host, host_len);
+    client->host[host_len] = '\0';
+
+    // Port z URI ma pierwszeństwo (esp-mqtt tak samo)
+    unsigned port = colon ? (unsigned)strtoul(colon + 1, NULL, 10) : (config_port ? config_port : DEFAULT_PORT);
+    snprintf(client->port, sizeof(client->port), "%u", port);
+    return true;
+}
+
+static int tcp_connect(esp_mqtt_client_handle_t client) {
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(client->host, client->port, &hints, &res) != 0 || res == NULL) {
+        return EHOSTUNREACH;
+    }
+
+    int err = ECONNREFUSED;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        int sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock < 0) {
+            err = errno;
+            continue;
+        }
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) {
+            int one = 1;
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            client->sock = sock;
+            err = 0;
+            break;
+        }
+        err = errno;
+        close(sock);
+    }
+    freeaddrinfo(res);
+    return err;
+}
+
+static bool send_connect(esp_mqtt_client_handle_t client) {
+    size_t id_len = strlen(client->client_id);
+    size_t user_len = client->username ? strlen(client->username) : 0;
+    size_t pass_len = client->password ? strlen(client->password) : 0;
+    uint8_t *body = malloc(10 + 2 + id_len + 2 + user_len + 2 + pass_len);
+    if (body == NULL) return false;
+
+    uint8_t flags = 0x02;   // clean session
+    if (client->username) flags |= 0x80;
+    if (client->password) flags |= 0x40;
+
+    size_t n = put_string(body, "MQTT", 4);
+    body[n++] = 4;          // MQTT 3.1.1
+    body[n++] = flags;
+    body[n++] = (uint8_t)(client->keepalive_s >> 8);
+    body[n++] = (uint8_t)client->keepalive_s;
+    n += put_string(body + n, client->client_id, id_len);
+    if (client->username) n += put_string(body + n, client->username, user_len);
+    if (client->password) n += put_string(body + n, client->password, pass_len);
+
+    pthread_mutex_lock(&client->lock);
+    bool ok = send_packet(client, PKT_CONNECT, body, n, NULL, 0);
+    pthread_mutex_unlock(&client->lock);
+    free(body);
+    return ok;
+}
+
+static void close_socket(esp_mqtt_client_handle_t client) {
+    pthread_mutex_lock(&client->lock);
+    client->connected = false;
+    if (client->sock >= 0) {
+        close(client->sock);
+        client->sock = -1;
+    }
+    pthread_mutex_unlock(&client->lock);
+    client->rx_len = 0;
+}
+
+// TCP + CONNECT/CONNACK. Przy błędzie wypełnia client->error.
+static bool open_session(esp_mqtt_client_handle_t client, int *session_present) {
+    memset(&client->error, 0, sizeof(client->error));
+    client->error.error_type = MQTT_ERROR_TYPE_TCP_TRANSPORT;
+
+    // Bez WiFi nie ma trasy do brokera
+    if (!sim_wifi_connected() || !sim_link_up()) {
+        client->error.esp_transport_sock_errno = ENETUNREACH;
+        client->error.esp_tls_last_esp_err = ESP_FAIL;
+        return false;
+    }
+
+    int err = tcp_connect(client);
+    if (err != 0) {
+        client->error.esp_transport_sock_errno = err;
+        client->error.esp_tls_last_esp_err = ESP_FAIL;
+        return false;
+    }
+    if (!send_connect(client)) {
+        close_socket(client);
+        return false;
+    }
+
+    // Pierwszy pakiet od brokera to CONNACK
+    int64_t deadline_us = sim_now_us() + (int64_t)client->timeout_ms * 1000;
+    size_t header_len, body_len, total;
+    while ((total = packet_length(client->rx, client->rx_len, &header_len, &body_len)) == 0) {
+        if (sim_now_us() >= deadline_us || !client->running || !receive(client, POLL_SLICE_MS)) {
+            if (client->error.esp_transport_sock_errno == 0) client->error.esp_transport_sock_errno = ETIMEDOUT;
+            close_socket(client);
+            return false;
+        }
+    }
+
+    const uint8_t *body = client->rx + header_len;
+    bool accepted = (client->rx[0] == PKT_CONNACK && body_len >= 2 && body[1] == 0);
+    if (!accepted) {
+        client->error.error_type = MQTT_ERROR_TYPE_CONNECTION_REFUSED;
+        client->error.connect_return_code = body_len >= 2 ? body[1] : -1;
+        close_socket(client);
+        return false;
+    }
+    *session_present = body[0] & 0x01;
+    memmove(client->rx, client->rx + total, client->rx_len - total);
+    client->rx_len -= total;
+
+    pthread_mutex_lock(&client->lock);
+    client->connected = true;
+    client->ping_sent_us = 0;
+    pthread_mutex_unlock(&client->lock);
+    return true;
+}
+
+// Obsługa połączenia aż do zerwania albo zatrzymania klienta
+static void run_session(esp_mqtt_client_handle_t client) {
+    int64_t keepalive_us = (int64_t)client->keepalive_s * 1000000;
+    process_rx(client);
+
+    while (client->running) {
+        if (!sim_wifi_connected() || !sim_link_up()) {
+            client->error.esp_transport_sock_errno = ENETDOWN;
+            break;
+        }
+
+        int64_t now = sim_now_us();
+        if (client->ping_sent_us != 0 && now - client->ping_sent_us > (int64_t)client->timeout_ms * 1000) {
+            ESP_LOGE(TAG, "Brak odpowiedzi na PINGREQ");
+            client->error.esp_transport_sock_errno = ETIMEDOUT;
+            break;
+        }
+        if (keepalive_us > 0 && client->ping_sent_us == 0 && now - client->last_tx_us >= keepalive_us / 2) {
+            pthread_mutex_lock(&client->lock);
+            bool ok = send_packet(client, PKT_PINGREQ, NULL, 0, NULL, 0);
+            pthread_mutex_unlock(&client->lock);
+            if (!ok) break;
+            client->ping_sent_us = now;
+        }
+
+        if (!receive(client, POLL_SLICE_MS)) break;
+        process_rx(client);
+    }
+}
+
+static void client_task(void *arg) {
+    esp_mqtt_client_handle_t client = arg;
+
+    while (client->running) {
+        dispatch(client, MQTT_EVENT_BEFORE_CONNECT, NULL);
+
+        int session_present = 0;
+        if (open_session(client, &session_present)) {
+            esp_mqtt_event_t event = { .session_present = session_present };
+            dispatch(client, MQTT_EVENT_CONNECTED, &event);
+            run_session(client);
+            close_socket(client);
+            if (client->running) {
+                dispatch(client, MQTT_EVENT_ERROR, NULL);
+            }
+        } else {
+            ESP_LOGW(TAG, "Polaczenie z %s:%s nieudane (errno %d)", client->host, client->port,
+                     client->error.esp_transport_sock_errno);
+            dispatch(client, MQTT_EVENT_ERROR, NULL);
+        }
+
+        if (!client->running) break;
+        dispatch(client, MQTT_EVENT_DISCONNECTED, NULL);
+        if (!client->auto_reconnect) break;
+
+        xEventGroupWaitBits(client->state, CLIENT_STOP_BIT, pdFALSE, pdFALSE, pdMS_TO_TICKS(client->reconnect_ms));
+    }
+
+    xEventGroupSetBits(client->state, CLIENT_STOPPED_BIT);
+    vTaskDelete(NULL);
+}
+
+// --- API esp-mqtt ---
+
+esp_err_t esp_crt_bundle_attach(void *conf) {
+    (void)conf;
+    return ESP_OK;
+}
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config) {
+    esp_mqtt_client_handle_t client = calloc(1, sizeof(*client));
+    if (client == NULL) return NULL;
+
+    if (config->broker.address.uri == NULL || !parse_uri(client, config->broker.address.uri,
+                                                          config->broker.address.port)) {
+        free(client);
+        return NULL;
+    }
+    if (config->credentials.client_id != NULL) {
+        snprintf(client->client_id, sizeof(client->client_id), "%s", config->credentials.client_id);
+    } else {
+        // esp-mqtt: "ESP32_" + MAC; tu nazwa jednostki, żeby instancje się nie wyrzucały
+        snprintf(client->client_id, sizeof(client->client_id), "ESP32_%s", sim_unit_name());
+    }
+    client->username = config->credentials.username ? strdup(config->credentials.username) : NULL;
+    client->password = config->credentials.authentication.password ?
+                       strdup(config->credentials.authentication.password) : NULL;
+    client->keepalive_s = config->session.keepalive ? config->session.keepalive : DEFAULT_KEEPALIVE_S;
+    client->timeout_ms = config->network.timeout_ms ? config->network.timeout_ms : DEFAULT_TIMEOUT_MS;
+    client->reconnect_ms = config->network.reconnect_timeout_ms ? config->network.reconnect_timeout_ms
+                                                                : DEFAULT_RECONNECT_MS;
+    client->auto_reconnect = !config->network.disable_auto_reconnect;
+
+    client->sock = -1;
+    client->rx_cap = RX_BUFFER_INITIAL;
+    client->rx = malloc(client->rx_cap);
+    client->state = xEventGroupCreate();
+    pthread_mutex_init(&client->lock, NULL);
+    if (client->rx == NULL || client->state == NULL) {
+        esp_mqtt_client_destroy(client);
+        return NULL;
+    }
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void *arg) {
+    (void)event;    // jedna procedura dla wszystkich zdarzeń (firmware rejestruje ESP_EVENT_ANY_ID)
+    client->handler = handler;
+    client->handler_arg = arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client) {
+    if (client->running) return ESP_FAIL;
+    client->running = true;
+    xEventGroupClearBits(client->state, CLIENT_STOP_BIT | CLIENT_STOPPED_BIT);
+    if (xTaskCreate(client_task, "mqtt_task", 6144, client, 5, NULL) != pdPASS) {
+        client->running = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client) {
+    if (!client->running) return ESP_FAIL;
+
+    pthread_mutex_lock(&client->lock);
+    client->running = false;
+    if (client->connected) {
+        send_packet(client, PKT_DISCONNECT, NULL, 0, NULL, 0);
+    }
+    if (client->sock >= 0) {
+        shutdown(client->sock, SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    xEventGroupSetBits(client->state, CLIENT_STOP_BIT);
+    xEventGroupWaitBits(client->state, CLIENT_STOPPED_BIT, pdFALSE, pdFALSE, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client) {
+    if (client == NULL) return ESP_ERR_INVALID_ARG;
+    if (client->running) esp_mqtt_client_stop(client);
+
+    pthread_mutex_destroy(&client->lock);
+    vEventGroupDelete(client->state);
+    free(client->rx);
+    free(client->username);
+    free(client->password);
+    free(client);
+    return ESP_OK;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len,
+                            int qos, int retain) {
+    if (len == 0 && data != NULL) len = (int)strlen(data);
+    if (qos > 1) qos = 1;   // QoS 2 nieobsługiwane - firmware go nie używa
+
+    size_t topic_len = strlen(topic);
+    uint8_t header[2 + 256 + 2];
+    if (topic_len > 256) return -1;
+
+    pthread_mutex_lock(&client->lock);
+    if (!client->connected) {
+        pthread_mutex_unlock(&client->lock);
+        return -1;
+    }
+    uint16_t msg_id = qos > 0 ? next_msg_id(client) : 0;
+    size_t n = put_string(header, topic, topic_len);
+    if (qos > 0) {
+        header[n++] = (uint8_t)(msg_id >> 8);
+        header[n++] = (uint8_t)msg_id;
+    }
+    bool ok = send_packet(client, PKT_PUBLISH | (qos << 1) | (retain ? 0x01 : 0), header, n,
+                          (const uint8_t *)data, (size_t)len);
+    pthread_mutex_unlock(&client->lock);
+    return ok ? msg_id : -1;
+}
+
+// Zapis do gniazda nie blokuje (bufor jądra), więc kolejka esp-mqtt = zwykła publikacja
+int esp_mqtt_client_enqueue(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len,
+                            int qos, int retain, bool store) {
+    (void)store;
+    return esp_mqtt_client_publish(client, topic, data, len, qos, retain);
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos) {
+    size_t topic_len = strlen(topic);
+    uint8_t body[2 + 2 + 256 + 1];
+    if (topic_len > 256) return -1;
+
+    pthread_mutex_lock(&client->lock);
+    if (!client->connected) {
+        pthread_mutex_unlock(&client->lock);
+        return -1;
+    }
+    uint16_t msg_id = next_msg_id(client);
+    body[0] = (uint8_t)(msg_id >> 8);
+    body[1] = (uint8_t)msg_id;
+    size_t n = 2 + put_string(body + 2, topic, topic_len);
+    body[n++] = (uint8_t)qos;
+    bool ok = send_packet(client, PKT_SUBSCRIBE, body, n, NULL, 0);
+    pthread_mutex_unlock(&client->lock);
+    return ok ? msg_id : -1;
+}
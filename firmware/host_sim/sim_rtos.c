@@ -0,0 +1,348 @@
+// FreeRTOS na wątkach pthread: taski z powiadomieniami, kolejki, grupy zdarzeń.
+// Timeouty liczone w zegarze wirtualnym (sim.h) i przeliczane na chwilę rzeczywistą.
+#define _GNU_SOURCE     // pthread_setname_np
+#include "sim.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct sim_task {
+    pthread_t thread;
+    char name[16];
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notify_value;
+    bool notify_pending;
+};
+
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint8_t *items;
+    size_t item_size;
+    size_t length;
+    size_t head;
+    size_t count;
+};
+
+struct sim_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+};
+
+static __thread struct sim_task *s_current = NULL;
+
+// --- Oczekiwanie z timeoutem w tickach ---
+
+typedef struct {
+    bool forever;
+    struct timespec at;     // chwila rzeczywista
+} wait_deadline_t;
+
+static wait_deadline_t deadline_after(TickType_t ticks) {
+    wait_deadline_t d = { .forever = (ticks == portMAX_DELAY) };
+    if (!d.forever) {
+        sim_real_deadline(sim_now_us() + (int64_t)ticks * portTICK_PERIOD_MS * 1000, &d.at);
+    }
+    return d;
+}
+
+// false = minął termin
+static bool wait_on(pthread_cond_t *cond, pthread_mutex_t *lock, const wait_deadline_t *d) {
+    if (d->forever) {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, &d->at) != ETIMEDOUT;
+}
+
+// --- Taski ---
+
+static struct sim_task *task_new(const char *name) {
+    struct sim_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) return NULL;
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    return task;
+}
+
+static void *task_entry(void *arg) {
+    struct sim_task *task = arg;
+    s_current = task;
+    pthread_setname_np(pthread_self(), task->name);
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core) {
+    (void)stack_depth;
+    (void)priority;
+    (void)core;
+
+    struct sim_task *task = task_new(name);
+    if (task == NULL) return pdFAIL;
+    task->fn = fn;
+    task->arg = arg;
+    if (created != NULL) *created = task;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, task_entry, task);
+    pthread_attr_destroy(&attr);
+    if (err != 0) {
+        if (created != NULL) *created = NULL;
+        free(task);
+        return pdFAIL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *created) {
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, created, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == s_current) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+}
+
+// Wątki spoza xTaskCreate (np. main -> app_main) dostają uchwyt przy pierwszym użyciu
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (s_current == NULL) {
+        s_current = task_new("main");
+        s_current->thread = pthread_self();
+        pthread_setname_np(pthread_self(), "main");
+    }
+    return s_current;
+}
+
+char *pcTaskGetName(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+    return task->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+    (void)task;
+    return 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    if (ticks == 0) {
+        sched_yield();
+        return;
+    }
+    sim_sleep_until(sim_now_us() + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / 1000 / portTICK_PERIOD_MS);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+    BaseType_t ret = pdPASS;
+    pthread_mutex_lock(&task->lock);
+    switch (action) {
+        case eSetBits:
+            task->notify_value |= value;
+            break;
+        case eIncrement:
+            task->notify_value++;
+            break;
+        case eSetValueWithOverwrite:
+            task->notify_value = value;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (task->notify_pending) {
+                ret = pdFAIL;
+            } else {
+                task->notify_value = value;
+            }
+            break;
+        case eNoAction:
+            break;
+    }
+    task->notify_pending = true;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+    struct sim_task *task = xTaskGetCurrentTaskHandle();
+    wait_deadline_t deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&task->lock);
+    if (!task->notify_pending) {
+        task->notify_value &= ~clear_on_entry;
+    }
+    while (!task->notify_pending && ticks > 0 && wait_on(&task->cond, &task->lock, &deadline)) {
+    }
+
+    if (value != NULL) *value = task->notify_value;
+    BaseType_t ret = pdFALSE;
+    if (task->notify_pending) {
+        task->notify_value &= ~clear_on_exit;
+        task->notify_pending = false;
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return ret;
+}
+
+// --- Kolejki ---
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    struct sim_queue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL) return NULL;
+    queue->items = malloc((size_t)length * item_size);
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->item_size = item_size;
+    queue->length = length;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue == NULL) return;
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->changed);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    wait_deadline_t deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && ticks > 0 && wait_on(&queue->changed, &queue->lock, &deadline)) {
+    }
+    if (queue->count == queue->length) {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;     // errQUEUE_FULL
+    }
+
+    size_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    wait_deadline_t deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && ticks > 0 && wait_on(&queue->changed, &queue->lock, &deadline)) {
+    }
+    if (queue->count == 0) {
+        pthread_mutex_unlock(&queue->lock);
+        return pdFALSE;
+    }
+
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = (UBaseType_t)queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+// --- Grupy zdarzeń ---
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    struct sim_event_group *group = calloc(1, sizeof(*group));
+    if (group == NULL) return NULL;
+    pthread_mutex_init(&group->lock, NULL);
+    pthread_cond_init(&group->changed, NULL);
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    if (group == NULL) return;
+    pthread_mutex_destroy(&group->lock);
+    pthread_cond_destroy(&group->changed);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t now = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return now;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return before;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t bits = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return bits;
+}
+
+static bool bits_satisfied(EventBits_t current, EventBits_t wanted, BaseType_t wait_for_all) {
+    return wait_for_all ? (current & wanted) == wanted : (current & wanted) != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    wait_deadline_t deadline = deadline_after(ticks);
+
+    pthread_mutex_lock(&group->lock);
+    while (!bits_satisfied(group->bits, bits, wait_for_all) && ticks > 0 &&
+           wait_on(&group->changed, &group->lock, &deadline)) {
+    }
+
+    // Wynik = bity w chwili spełnienia warunku (albo timeoutu), przed ewentualnym skasowaniem
+    EventBits_t result = group->bits;
+    if (clear_on_exit && bits_satisfied(result, bits, wait_for_all)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return result;
+}
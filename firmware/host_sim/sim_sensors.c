@@ -0,0 +1,258 @@
+// Czujniki DS18B20 symulowane na magistrali 0: przebieg temperatury z konfiguracji instancji,
+// zdarzenia skryptowe (np. otwarte drzwi) i losowe błędy CRC odczytu
+#include "sim.h"
+#include "onewire_bus.h"
+#include "ds18b20.h"
+#include "esp_log.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SIM_SENSORS";
+
+#define SIM_MAX_SENSORS     10
+#define SIM_MAX_EVENTS      16
+#define DS18B20_FAMILY      0x28
+
+// Domyślnie: chłodziarka, zamrażarka, komora 0..4 C - wszystkie w domyślnym zakresie alarmów
+#define DEFAULT_SENSORS     "4,1.5,3600,0.05;-18,2,5400,0.1;2,0.5,86400,0.05"
+
+// Przebieg: base + amp * sin(2 pi t / period + faza) + szum, faza z kodu ROM
+typedef struct {
+    onewire_device_address_t rom;
+    double base;
+    double amp;
+    double period_s;
+    double noise;
+    double phase;
+} sim_sensor_t;
+
+// Zdarzenie: czujnik + delta przez [from, to) s czasu wirtualnego
+typedef struct {
+    int sensor;
+    int64_t from_s;
+    int64_t to_s;
+    double delta;
+} sim_temp_event_t;
+
+struct sim_onewire_bus {
+    int index;
+    int gpio;
+};
+
+struct sim_onewire_iter {
+    struct sim_onewire_bus *bus;
+    int next;
+};
+
+struct sim_ds18b20 {
+    int sensor;
+    uint8_t bits;
+};
+
+static sim_sensor_t s_sensors[SIM_MAX_SENSORS];
+static int s_sensor_count = 0;
+static sim_temp_event_t s_events[SIM_MAX_EVENTS];
+static int s_event_count = 0;
+static double s_crc_fault_rate = 0.0;
+static int64_t s_conversion_start_us = 0;
+static int s_bus_count = 0;
+static pthread_once_t s_config_once = PTHREAD_ONCE_INIT;
+
+uint8_t onewire_crc8(uint8_t init_crc, uint8_t *input, size_t input_size) {
+    uint8_t crc = init_crc;
+    for (size_t i = 0; i < input_size; i++) {
+        uint8_t byte = input[i];
+        for (int b = 0; b < 8; b++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+// Kod ROM: rodzina 0x28 | 48 bitów numeru (z nazwy jednostki i indeksu) | CRC8
+static onewire_device_address_t make_rom(int index) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = sim_unit_name(); *p; p++) hash = (hash ^ (uint8_t)*p) * 16777619u;
+
+    uint8_t rom[8] = { DS18B20_FAMILY };
+    uint64_t serial = ((uint64_t)hash << 16) | (uint16_t)(index + 1);
+    for (int i = 0; i < 6; i++) rom[1 + i] = (uint8_t)(serial >> (8 * i));
+    rom[7] = onewire_crc8(0, rom, 7);
+
+    onewire_device_address_t address = 0;
+    for (int i = 7; i >= 0; i--) address = (address << 8) | rom[i];
+    return address;
+}
+
+// SIM_SENSORS: "base,amp,period_s,noise;..." (brakujące pola = 0, okres 3600)
+// SIM_TEMP_EVENTS: "id@od+czas=delta;..." (od w s czasu wirtualnego, czas w s)
+static void load_config(void) {
+    const char *p = sim_env("SIM_SENSORS", DEFAULT_SENSORS);
+    while (*p != '\0' && s_sensor_count < SIM_MAX_SENSORS) {
+        double v[4] = { 0, 0, 3600, 0 };
+        for (int f = 0; f < 4; f++) {
+            char *end;
+            double value = strtod(p, &end);
+            if (end == p) break;
+            v[f] = value;
+            p = end;
+            if (*p != ',') break;
+            p++;
+        }
+        sim_sensor_t *s = &s_sensors[s_sensor_count];
+        s->rom = make_rom(s_sensor_count);
+        s->base = v[0];
+        s->amp = v[1];
+        s->period_s = v[2] > 0 ? v[2] : 3600;
+        s->noise = v[3];
+        s->phase = (double)(s->rom >> 8 & 0xFFFF) / 65536.0 * 2 * M_PI;
+        s_sensor_count++;
+        if (*p != ';') break;
+        p++;
+    }
+
+    p = sim_env("SIM_TEMP_EVENTS", "");
+    while (*p != '\0' && s_event_count < SIM_MAX_EVENTS) {
+        sim_temp_event_t e;
+        int used = 0;
+        double from, duration;
+        if (sscanf(p, "%d@%lf+%lf=%lf%n", &e.sensor, &from, &duration, &e.delta, &used) != 4) break;
+        e.from_s = (int64_t)from;
+        e.to_s = (int64_t)(from + duration);
+        s_events[s_event_count++] = e;
+        p += used;
+        if (*p == ';') p++;
+    }
+
+    s_crc_fault_rate = sim_env_double("SIM_CRC_FAULTS", 0.0);
+    ESP_LOGI(TAG, "%d czujnikow, %d zdarzen, bledy CRC %.1f%%", s_sensor_count, s_event_count,
+             s_crc_fault_rate * 100);
+}
+
+static double sensor_temperature(int index, int64_t now_us) {
+    const sim_sensor_t *s = &s_sensors[index];
+    double t = now_us / 1e6;
+    double value = s->base + s->amp * sin(2 * M_PI * t / s->period_s + s->phase) +
+                   s->noise * (2 * sim_random() - 1);
+    for (int i = 0; i < s_event_count; i++) {
+        if (s_events[i].sensor == index && t >= s_events[i].from_s && t < s_events[i].to_s) {
+            value += s_events[i].delta;
+        }
+    }
+    return value;
+}
+
+// --- Magistrala ---
+
+esp_err_t onewire_new_bus_rmt(const onewire_bus_config_t *bus_config, const onewire_bus_rmt_config_t *rmt_config,
+                              onewire_bus_handle_t *ret_bus) {
+    (void)rmt_config;
+    pthread_once(&s_config_once, load_config);
+
+    struct sim_onewire_bus *bus = calloc(1, sizeof(*bus));
+    if (bus == NULL) return ESP_ERR_NO_MEM;
+    bus->index = s_bus_count++;
+    bus->gpio = bus_config->bus_gpio_num;
+    *ret_bus = bus;
+    return ESP_OK;
+}
+
+static int bus_sensor_count(onewire_bus_handle_t bus) {
+    return bus->index == 0 ? s_sensor_count : 0;
+}
+
+esp_err_t onewire_bus_reset(onewire_bus_handle_t bus) {
+    // Brak impulsu obecności = pusta magistrala
+    return bus_sensor_count(bus) > 0 ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t onewire_bus_write_bytes(onewire_bus_handle_t bus, const uint8_t *tx_data, uint8_t tx_data_size) {
+    // SKIP ROM + CONVERT T: wszystkie czujniki mierzą od teraz
+    if (bus->index == 0 && tx_data_size == 2 && tx_data[0] == 0xCC && tx_data[1] == 0x44) {
+        s_conversion_start_us = sim_now_us();
+    }
+    return ESP_OK;
+}
+
+esp_err_t onewire_bus_read_bit(onewire_bus_handle_t bus, uint8_t *rx_bit) {
+    // Koniec konwersji 12-bitowej po 750 ms (zasilanie zewnętrzne)
+    *rx_bit = (bus_sensor_count(bus) == 0 || sim_now_us() - s_conversion_start_us >= 750000) ? 1 : 0;
+    return ESP_OK;
+}
+
+esp_err_t onewire_new_device_iter(onewire_bus_handle_t bus, onewire_device_iter_handle_t *ret_iter) {
+    struct sim_onewire_iter *iter = calloc(1, sizeof(*iter));
+    if (iter == NULL) return ESP_ERR_NO_MEM;
+    iter->bus = bus;
+    *ret_iter = iter;
+    return ESP_OK;
+}
+
+esp_err_t onewire_device_iter_get_next(onewire_device_iter_handle_t iter, onewire_device_t *dev) {
+    if (iter->next >= bus_sensor_count(iter->bus)) return ESP_ERR_NOT_FOUND;
+    dev->bus = iter->bus;
+    dev->address = s_sensors[iter->next++].rom;
+    return ESP_OK;
+}
+
+esp_err_t onewire_del_device_iter(onewire_device_iter_handle_t iter) {
+    free(iter);
+    return ESP_OK;
+}
+
+// --- DS18B20 ---
+
+esp_err_t ds18b20_new_device_from_enumeration(onewire_device_t *device, const ds18b20_config_t *config,
+                                              ds18b20_device_handle_t *ret_ds18b20) {
+    (void)config;
+    if ((device->address & 0xFF) != DS18B20_FAMILY) return ESP_ERR_NOT_SUPPORTED;
+
+    // Uchwyt powstaje też dla czujnika, którego nie ma na magistrali - wyjdzie przy odczycie
+    int sensor = -1;
+    for (int i = 0; i < bus_sensor_count(device->bus); i++) {
+        if (s_sensors[i].rom == device->address) sensor = i;
+    }
+
+    struct sim_ds18b20 *ds = calloc(1, sizeof(*ds));
+    if (ds == NULL) return ESP_ERR_NO_MEM;
+    ds->sensor = sensor;
+    ds->bits = 12;
+    *ret_ds18b20 = ds;
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_del_device(ds18b20_device_handle_t ds18b20) {
+    free(ds18b20);
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_set_resolution(ds18b20_device_handle_t ds18b20, ds18b20_resolution_t resolution) {
+    ds18b20->bits = (uint8_t)(9 + resolution);
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_trigger_temperature_conversion(ds18b20_device_handle_t ds18b20) {
+    (void)ds18b20;
+    s_conversion_start_us = sim_now_us();
+    return ESP_OK;
+}
+
+esp_err_t ds18b20_get_temperature(ds18b20_device_handle_t ds18b20, float *temperature) {
+    if (ds18b20->sensor < 0) return ESP_ERR_TIMEOUT;
+    if (sim_random() < s_crc_fault_rate) {
+        ESP_LOGD(TAG, "Symulowany blad CRC czujnika %d", ds18b20->sensor);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Kwantyzacja jak w rejestrze DS18B20: 0.0625 C przy 12 bitach, 0.5 C przy 9
+    double step = 0.0625 * (1 << (12 - ds18b20->bits));
+    double value = sensor_temperature(ds18b20->sensor, sim_now_us());
+    *temperature = (float)(round(value / step) * step);
+    return ESP_OK;
+}
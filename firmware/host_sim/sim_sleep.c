@@ -0,0 +1,108 @@
+// Deep sleep: pamięć RTC (sekcja rtc_data, esp_attr.h) do pliku, uśpienie do chwili wybudzenia
+// w zegarze wirtualnym i execv tego samego programu - reszta pamięci startuje od zera jak na ESP32
+#include "sim.h"
+#include "esp_sleep.h"
+#include "esp_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "SIM_SLEEP";
+
+#define RTC_FILE        "rtc.bin"
+#define WAKEUP_ENV      "SIM_WAKEUP"
+
+extern char __start_rtc_data[] __attribute__((weak));
+extern char __stop_rtc_data[] __attribute__((weak));
+
+static char **s_argv = NULL;
+static esp_sleep_wakeup_cause_t s_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+static uint64_t s_timer_wakeup_us = 0;
+
+static size_t rtc_size(void) {
+    return (size_t)(__stop_rtc_data - __start_rtc_data);
+}
+
+static void rtc_path(char *buf, size_t len) {
+    snprintf(buf, len, "%s/" RTC_FILE, sim_env("SIM_DIR", "."));
+}
+
+void sim_set_argv(char **argv) {
+    s_argv = argv;
+}
+
+bool sim_rtc_restore(void) {
+    char path[300];
+    rtc_path(path, sizeof(path));
+
+    const char *wake = getenv(WAKEUP_ENV);
+    if (wake == NULL || strcmp(wake, "timer") != 0) {
+        unlink(path);   // zimny start - pamięć RTC wyzerowana
+        return false;
+    }
+    unsetenv(WAKEUP_ENV);
+
+    size_t size = rtc_size();
+    char *image = malloc(size > 0 ? size : 1);
+    FILE *f = fopen(path, "rb");
+    bool ok = (image != NULL && f != NULL && fread(image, 1, size, f) == size);
+    if (f != NULL) fclose(f);
+
+    if (ok) {
+        memcpy(__start_rtc_data, image, size);
+        s_cause = ESP_SLEEP_WAKEUP_TIMER;
+    } else {
+        ESP_LOGE(TAG, "Brak obrazu pamieci RTC (%s) - zimny start", path);
+    }
+    free(image);
+    return ok;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void) {
+    return s_cause;
+}
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_in_us) {
+    s_timer_wakeup_us = time_in_us;
+    return ESP_OK;
+}
+
+// Przycisk nie jest symulowany
+esp_err_t esp_sleep_enable_ext0_wakeup(gpio_num_t gpio_num, int level) {
+    (void)gpio_num;
+    (void)level;
+    return ESP_OK;
+}
+
+static void rtc_save(void) {
+    char path[300], tmp[310];
+    rtc_path(path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL || fwrite(__start_rtc_data, 1, rtc_size(), f) != rtc_size()) {
+        ESP_LOGE(TAG, "Nie udalo sie zapisac pamieci RTC (%s)", tmp);
+    }
+    if (f != NULL) fclose(f);
+    rename(tmp, path);
+}
+
+void esp_deep_sleep_start(void) {
+    int64_t wake_at_us = sim_now_us() + (int64_t)s_timer_wakeup_us;
+    rtc_save();
+    fflush(NULL);
+
+    int64_t end_us = sim_end_us();
+    if (end_us > 0 && wake_at_us >= end_us) {
+        ESP_LOGI(TAG, "Koniec symulacji w czasie snu");
+        exit(0);
+    }
+
+    sim_sleep_until(wake_at_us);
+
+    setenv(WAKEUP_ENV, "timer", 1);
+    execv("/proc/self/exe", s_argv);
+    perror("execv");
+    _exit(1);
+}
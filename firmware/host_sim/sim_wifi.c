@@ -0,0 +1,398 @@
+// Sieć symulowana: pętla zdarzeń ESP-IDF, radio WiFi, esp_netif i SNTP.
+// Łącze (AP + droga do brokera) wg harmonogramu awarii SIM_WIFI_OUTAGES, w zegarze wirtualnym.
+#include "sim.h"
+#include "esp_event.h"
+#include "esp_wifi.h"
+#include "esp_netif.h"
+#include "esp_sntp.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "SIM_WIFI";
+
+esp_event_base_t const WIFI_EVENT = "WIFI_EVENT";
+esp_event_base_t const IP_EVENT = "IP_EVENT";
+
+// --- Pętla zdarzeń ---
+
+#define EVENT_QUEUE_LEN     32
+#define EVENT_DATA_MAX      64
+#define MAX_HANDLERS        16
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    size_t size;
+    uint8_t data[EVENT_DATA_MAX];
+} sim_event_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} sim_handler_t;
+
+static QueueHandle_t s_event_queue = NULL;
+static sim_handler_t s_handlers[MAX_HANDLERS];
+static int s_handler_count = 0;
+static pthread_mutex_t s_handler_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void event_task(void *arg) {
+    (void)arg;
+    sim_event_t event;
+    while (1) {
+        if (xQueueReceive(s_event_queue, &event, portMAX_DELAY) != pdTRUE) continue;
+
+        pthread_mutex_lock(&s_handler_lock);
+        int count = s_handler_count;
+        sim_handler_t handlers[MAX_HANDLERS];
+        memcpy(handlers, s_handlers, sizeof(handlers));
+        pthread_mutex_unlock(&s_handler_lock);
+
+        for (int i = 0; i < count; i++) {
+            if (handlers[i].base == event.base && (handlers[i].id == ESP_EVENT_ANY_ID || handlers[i].id == event.id)) {
+                handlers[i].handler(handlers[i].arg, event.base, event.id, event.size ? event.data : NULL);
+            }
+        }
+    }
+}
+
+esp_err_t esp_event_loop_create_default(void) {
+    if (s_event_queue != NULL) return ESP_ERR_INVALID_STATE;
+    s_event_queue = xQueueCreate(EVENT_QUEUE_LEN, sizeof(sim_event_t));
+    if (s_event_queue == NULL) return ESP_ERR_NO_MEM;
+    return xTaskCreate(event_task, "sys_evt", 2304, NULL, 20, NULL) == pdPASS ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler,
+                                              void *arg, esp_event_handler_instance_t *instance) {
+    pthread_mutex_lock(&s_handler_lock);
+    if (s_handler_count >= MAX_HANDLERS) {
+        pthread_mutex_unlock(&s_handler_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    s_handlers[s_handler_count] = (sim_handler_t){ base, id, handler, arg };
+    if (instance != NULL) *instance = &s_handlers[s_handler_count];
+    s_handler_count++;
+    pthread_mutex_unlock(&s_handler_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t base, int32_t id, esp_event_handler_t handler, void *arg) {
+    return esp_event_handler_instance_register(base, id, handler, arg, NULL);
+}
+
+esp_err_t esp_event_post(esp_event_base_t base, int32_t id, const void *data, size_t size, TickType_t ticks) {
+    if (s_event_queue == NULL) return ESP_ERR_INVALID_STATE;
+    if (size > EVENT_DATA_MAX) return ESP_ERR_INVALID_ARG;
+
+    sim_event_t event = { .base = base, .id = id, .size = size };
+    if (size > 0) memcpy(event.data, data, size);
+    return xQueueSend(s_event_queue, &event, ticks) == pdTRUE ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+// --- Łącze ---
+
+#define MAX_OUTAGES     32
+
+typedef struct {
+    int64_t from_us;
+    int64_t to_us;
+} outage_t;
+
+static outage_t s_outages[MAX_OUTAGES];
+static int s_outage_count = 0;
+static pthread_once_t s_outages_once = PTHREAD_ONCE_INIT;
+
+// "od-do,od-do" (s czasu wirtualnego, mogą być ułamki)
+static void load_outages(void) {
+    const char *p = sim_env("SIM_WIFI_OUTAGES", "");
+    while (*p != '\0' && s_outage_count < MAX_OUTAGES) {
+        char *end;
+        double from = strtod(p, &end);
+        if (end == p || *end != '-') break;
+        double to = strtod(end + 1, &end);
+        s_outages[s_outage_count++] = (outage_t){ (int64_t)(from * 1e6), (int64_t)(to * 1e6) };
+        p = (*end == ',') ? end + 1 : end;
+    }
+}
+
+bool sim_link_up(void) {
+    pthread_once(&s_outages_once, load_outages);
+    int64_t now = sim_now_us();
+    for (int i = 0; i < s_outage_count; i++) {
+        if (now >= s_outages[i].from_us && now < s_outages[i].to_us) return false;
+    }
+    return true;
+}
+
+// --- Radio ---
+
+// Skojarzenie z AP i DHCP: prosto do znanego BSSID na znanym kanale albo po pełnym skanie
+#define ASSOC_FAST_MS       300
+#define ASSOC_FULL_MS       2200
+#define ASSOC_JITTER_MS     400
+#define LINK_CHECK_MS       100
+
+static const uint8_t AP_BSSID[6] = { 0x24, 0x0a, 0xc4, 0x5a, 0x11, 0x01 };
+#define AP_CHANNEL          6
+
+struct esp_netif_obj {
+    int unused;
+};
+
+static struct esp_netif_obj s_netif;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_changed = PTHREAD_COND_INITIALIZER;
+static bool s_initialized = false;
+static bool s_started = false;
+static bool s_connecting = false;
+static bool s_connected = false;
+static int64_t s_connect_at_us = 0;
+static wifi_config_t s_config;
+static double s_fail_rate = 0.0;
+
+bool sim_wifi_connected(void) {
+    pthread_mutex_lock(&s_lock);
+    bool connected = s_connected;
+    pthread_mutex_unlock(&s_lock);
+    return connected;
+}
+
+static void post_disconnected(uint8_t reason) {
+    wifi_event_sta_disconnected_t event = { .reason = reason };
+    memcpy(event.bssid, AP_BSSID, sizeof(event.bssid));
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event), portMAX_DELAY);
+}
+
+static void post_got_ip(void) {
+    // Adres z "DHCP" stały dla jednostki - tak jak dzierżawa z routera
+    uint32_t host = 10;
+    for (const char *p = sim_unit_name(); *p; p++) host = host * 31 + (uint8_t)*p;
+
+    ip_event_got_ip_t event = { .esp_netif = &s_netif };
+    event.ip_info.ip.addr = 0x0001A8C0u | ((host % 200 + 20) << 24);     // 192.168.1.x (sieciowa kolejność bajtów)
+    event.ip_info.netmask.addr = 0x00FFFFFFu;
+    event.ip_info.gw.addr = 0x0101A8C0u;
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, NULL, 0, portMAX_DELAY);
+    esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &event, sizeof(event), portMAX_DELAY);
+}
+
+static void wait_changed_until(int64_t virtual_us) {
+    struct timespec deadline;
+    sim_real_deadline(virtual_us, &deadline);
+    pthread_cond_timedwait(&s_changed, &s_lock, &deadline);
+}
+
+static void wifi_task(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&s_lock);
+    while (1) {
+        if (s_connecting) {
+            if (sim_now_us() < s_connect_at_us) {
+                wait_changed_until(s_connect_at_us);
+                continue;
+            }
+            s_connecting = false;
+            s_connected = sim_link_up() && sim_random() >= s_fail_rate;
+            bool connected = s_connected;
+            pthread_mutex_unlock(&s_lock);
+
+            if (connected) {
+                post_got_ip();
+            } else {
+                post_disconnected(WIFI_REASON_NO_AP_FOUND);
+            }
+            pthread_mutex_lock(&s_lock);
+        } else if (s_connected) {
+            wait_changed_until(sim_now_us() + LINK_CHECK_MS * 1000);
+            if (s_connected && !sim_link_up()) {
+                s_connected = false;
+                pthread_mutex_unlock(&s_lock);
+                ESP_LOGW(TAG, "Awaria lacza - rozlaczenie z AP");
+                post_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+                pthread_mutex_lock(&s_lock);
+            }
+        } else {
+            pthread_cond_wait(&s_changed, &s_lock);
+        }
+    }
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config) {
+    (void)config;
+    pthread_mutex_lock(&s_lock);
+    bool first = !s_initialized;
+    s_initialized = true;
+    pthread_mutex_unlock(&s_lock);
+
+    if (first) {
+        s_fail_rate = sim_env_double("SIM_WIFI_FAIL", 0.0);
+        xTaskCreate(wifi_task, "wifi", 3584, NULL, 23, NULL);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode) {
+    (void)mode;
+    return s_initialized ? ESP_OK : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *config) {
+    (void)interface;
+    pthread_mutex_lock(&s_lock);
+    s_config = *config;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void) {
+    pthread_mutex_lock(&s_lock);
+    if (!s_initialized) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    bool was_started = s_started;
+    s_started = true;
+    pthread_mutex_unlock(&s_lock);
+
+    if (!was_started) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void) {
+    pthread_mutex_lock(&s_lock);
+    bool was_started = s_started;
+    s_started = false;
+    s_connecting = false;
+    s_connected = false;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+
+    if (was_started) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0, portMAX_DELAY);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void) {
+    pthread_mutex_lock(&s_lock);
+    if (!s_started) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+
+    // Zły zapamiętany BSSID/kanał = AP nie odpowiada, jak na prawdziwym radiu
+    int64_t assoc_ms;
+    if (s_config.sta.bssid_set) {
+        bool same_ap = memcmp(s_config.sta.bssid, AP_BSSID, sizeof(AP_BSSID)) == 0 &&
+                       (s_config.sta.channel == 0 || s_config.sta.channel == AP_CHANNEL);
+        assoc_ms = same_ap ? ASSOC_FAST_MS : ASSOC_FULL_MS * 10;
+    } else {
+        assoc_ms = ASSOC_FULL_MS;
+    }
+    assoc_ms += (int64_t)(sim_random() * ASSOC_JITTER_MS);
+
+    s_connecting = true;
+    s_connected = false;
+    s_connect_at_us = sim_now_us() + assoc_ms * 1000;
+    pthread_cond_broadcast(&s_changed);
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info) {
+    if (!sim_wifi_connected()) return ESP_FAIL;
+
+    memset(ap_info, 0, sizeof(*ap_info));
+    memcpy(ap_info->bssid, AP_BSSID, sizeof(AP_BSSID));
+    memcpy(ap_info->ssid, s_config.sta.ssid, sizeof(s_config.sta.ssid));
+    ap_info->primary = AP_CHANNEL;
+    ap_info->rssi = -61;
+    return ESP_OK;
+}
+
+// --- esp_netif ---
+
+esp_err_t esp_netif_init(void) {
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void) {
+    return &s_netif;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *netif) {
+    (void)netif;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *netif) {
+    (void)netif;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *netif, const esp_netif_ip_info_t *info) {
+    (void)netif;
+    (void)info;
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns) {
+    (void)netif;
+    (void)type;
+    dns->ip.type = ESP_IPADDR_TYPE_V4;
+    dns->ip.u_addr.ip4.addr = 0x0101A8C0u;     // 192.168.1.1
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *netif, esp_netif_dns_type_t type, esp_netif_dns_info_t *dns) {
+    (void)netif;
+    (void)type;
+    (void)dns;
+    return ESP_OK;
+}
+
+// --- SNTP ---
+
+// Odpowiedź serwera czasu po tylu ms od startu (o ile jest połączenie)
+#define SNTP_RESPONSE_MS    150
+#define SNTP_POLL_S         3600
+
+static bool s_sntp_running = false;
+static int64_t s_sntp_due_us = 0;
+
+void esp_sntp_setoperatingmode(int mode) {
+    (void)mode;
+}
+
+void esp_sntp_setservername(int idx, const char *server) {
+    (void)idx;
+    (void)server;
+}
+
+void esp_sntp_init(void) {
+    s_sntp_running = true;
+    s_sntp_due_us = sim_now_us() + SNTP_RESPONSE_MS * 1000;
+}
+
+void esp_sntp_stop(void) {
+    s_sntp_running = false;
+}
+
+sntp_sync_status_t sntp_get_sync_status(void) {
+    if (!s_sntp_running || sim_now_us() < s_sntp_due_us || !sim_wifi_connected() || !sim_link_up()) {
+        return SNTP_SYNC_STATUS_RESET;
+    }
+    sim_wall_sync();
+    s_sntp_due_us = sim_now_us() + (int64_t)SNTP_POLL_S * 1000000;
+    return SNTP_SYNC_STATUS_COMPLETED;
+}
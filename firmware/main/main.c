@@ -1,7 +1,10 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "nvs_flash.h"
@@ -10,21 +13,58 @@
 #include <sys/time.h>
 #include <time.h>         
 #include "esp_sntp.h"     
-
-#include "onewire_bus.h"
-#include "ds18b20.h"
+#include "esp_sleep.h"
 
 #include "storage_manager.h"
+#include "sensor_manager.h"
 #include "offline_buffer.h"
 #include "wifi_connect.h"
 #include "ble_config.h"
 #include "mqtt_handler.h"
+#include "mqtt_ota.h"
+#include "rtc_cache.h"
+#include "scheduler.h"
+#include "alarm_engine.h"
+#include "report_filter.h"
+#include "aggregator.h"
+#include "record_seq.h"
+#include "diag.h"
 
 static const char *TAG = "MAIN_SYSTEM";
 
 // Konfiguracja
-#define SENSOR_GPIO  GPIO_NUM_4
-#define MAX_SENSORS  10  
+#define MAX_SENSOR_BUSES  4     // każda magistrala OneWire zajmuje 2 z 8 kanałów RMT
+#define BUTTON_GPIO  GPIO_NUM_0
+
+#define RESCAN_PERIOD_S    CONFIG_HIVE_DS18B20_RESCAN_S
+
+// Rekordy z jednego cyklu: pomiary, a przy agregacji zamknięte okna + surowe pomiary przy alarmie
+#define MAX_CYCLE_RECORDS  (2 * SENSOR_MANAGER_MAX_SENSORS)
+
+// Magistrale OneWire z listy GPIO w Kconfig, np. "4,16,17"
+static int parse_sensor_gpios(gpio_num_t *gpios, int max) {
+    const char *p = CONFIG_HIVE_ONEWIRE_GPIOS;
+    int n = 0;
+    while (*p != '\0' && n < max) {
+        char *end;
+        long gpio = strtol(p, &end, 10);
+        if (end == p) {
+            p++;    // separator
+            continue;
+        }
+        gpios[n++] = (gpio_num_t)gpio;
+        p = end;
+    }
+    return n;
+}
+
+static bool time_is_set(void) {
+    time_t now;
+    struct tm timeinfo;
+    time(&now);
+    localtime_r(&now, &timeinfo);
+    return timeinfo.tm_year > (2020 - 1900);
+}
 
 // --- FUNKCJA DO POBIERANIA CZASU---
 static void obtain_time(void) {
@@ -38,6 +78,7 @@ static void obtain_time(void) {
     }
 
     ESP_LOGI(TAG, "Czas nieaktualny (Rok 1970). Inicjalizacja SNTP...");
+    int64_t start_us = esp_timer_get_time();
 
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, "pool.ntp.org");
@@ -50,6 +91,8 @@ static void obtain_time(void) {
         vTaskDelay(pdMS_TO_TICKS(1000));
     }
     
+    diag_phase_add(DIAG_PHASE_SNTP, start_us);
+
     setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
     tzset();
 
@@ -64,90 +107,424 @@ static void obtain_time(void) {
     }
 }
 
-SensorData get_ds18b20_reading(ds18b20_device_handle_t sensor_handle) {
-    SensorData d;
-    
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    d.timestamp = (int64_t)tv.tv_sec;
+// Pełny skan magistrali; nowe sondy dostają kolejne ID, więc moduły per czujnik muszą je poznać
+static void rescan_sensors(void) {
+    int before = sensor_manager_count();
+    sensor_manager_rescan();
+
+    int count = sensor_manager_count();
+    if (count != before) {
+        ESP_LOGW(TAG, "Nowe czujniki: %d -> %d ID.", before, count);
+        alarm_engine_init(count);
+#if !CONFIG_HIVE_DEEP_SLEEP
+        scheduler_init(count);
+#endif
+    }
+}
 
-    d.temp = -127.0; 
-    d.pressure = 0;  
-    d.sensor_id = -1;
+// Zaległości z bufora offline - dopiero po bieżących pomiarach i w ograniczonej porcji,
+// żeby po długiej awarii sieci pojedynczy cykl nie trwał minutami
+static void drain_backlog(void) {
+    static const offline_drain_budget_t budget = {
+        .max_records = CONFIG_HIVE_BACKLOG_MAX_RECORDS,
+        .max_ms = CONFIG_HIVE_BACKLOG_MAX_MS,
+#if CONFIG_HIVE_BACKLOG_NEWEST_FIRST
+        .order = OFFLINE_DRAIN_NEWEST_FIRST,
+#else
+        .order = OFFLINE_DRAIN_OLDEST_FIRST,
+#endif
+    };
 
-    if (sensor_handle == NULL) {
-        ESP_LOGE(TAG, "Uchwyt czujnika jest NULL");
-        return d;
+    int64_t start_us = esp_timer_get_time();
+    size_t sent = 0;
+    if (offline_buffer_count() > 0) {
+        ESP_LOGW(TAG, "Wysyłanie bufora offline...");
+        sent = offline_process_queue(mqtt_send_sensor_batch, &budget);
     }
 
-    ESP_ERROR_CHECK(ds18b20_trigger_temperature_conversion(sensor_handle));
-    
-    vTaskDelay(pdMS_TO_TICKS(800));
+    // Zakres zlecony przez serwer - w tym, co zostało z budżetu
+    if (offline_resend_pending() && (budget.max_records == 0 || sent < budget.max_records)) {
+        offline_drain_budget_t rest = budget;
+        if (rest.max_records > 0) rest.max_records -= sent;
+        offline_process_resend(mqtt_send_sensor_batch, &rest);
+    }
+    diag_phase_add(DIAG_PHASE_BACKLOG, start_us);
+}
 
-    float temperature;
-    if (ds18b20_get_temperature(sensor_handle, &temperature) == ESP_OK) {
-        d.temp = temperature;
+// Polecenie z serwera "resend <od> <do>" (czas Unix): ponowna wysyłka zakresu z bufora offline,
+// np. po utracie danych w bazie. Tu tylko zapis zlecenia - wysyłka w drain_backlog().
+static void resend_command(const char *args) {
+    char *mid, *end;
+    long long from = strtoll(args, &mid, 10);
+    long long to = strtoll(mid, &end, 10);
+
+    if (mid == args || end == mid || offline_buffer_request_resend(from, to) != ESP_OK) {
+        ESP_LOGW(TAG, "Bledne polecenie resend: '%s'", args);
+    }
+}
+
+#if CONFIG_HIVE_AGGREGATION
+// Surowe pomiary zasilają okna (aggregator.h), w readings[] zostają zamknięte okna,
+// a z keep_raw także surowe pomiary. readings[] musi mieć miejsce na MAX_CYCLE_RECORDS.
+static size_t aggregate_readings(SensorData *readings, size_t count, bool keep_raw) {
+    static SensorData raw[SENSOR_MANAGER_MAX_SENSORS];     // woła tylko jeden task
+    memcpy(raw, readings, count * sizeof(SensorData));
+
+    size_t n = aggregator_add(raw, count, readings, SENSOR_MANAGER_MAX_SENSORS);
+    if (keep_raw) {
+        memcpy(&readings[n], raw, count * sizeof(SensorData));
+        n += count;
+    }
+    return n;
+}
+#endif
+
+#if CONFIG_HIVE_DEEP_SLEEP
+// --- TRYB DEEP SLEEP ---
+// Każde wybudzenie: pomiar -> pamięć RTC. Radio tylko co N wybudzeń albo przy zmianie
+// stanu alarmu (alarm_engine.h); wtedy cała pamięć RTC idzie jedną serią do MQTT (reszta do flasha).
+
+#define SLEEP_INTERVAL_US       ((uint64_t)CONFIG_HIVE_SLEEP_INTERVAL_S * 1000000ULL)
+#define UPLINK_EVERY_N_WAKES    CONFIG_HIVE_DEEP_SLEEP_UPLINK_EVERY
+#define ALARM_WATCH_US          ((uint64_t)CONFIG_HIVE_ALARM_WATCH_PERIOD_S * 1000000ULL)
+#define BUTTON_WAKE_WINDOW_MS   6000
+
+static bool s_offline_ready = false;
+
+static void ensure_offline_buffer(void) {
+    if (!s_offline_ready) {
+        s_offline_ready = (offline_buffer_init() == ESP_OK);
+    }
+}
+
+// Przenosi pamięć RTC do bufora offline na flashu (jedna seria = skompresowane bloki)
+static void flush_cache_to_flash(void) {
+    size_t count = rtc_cache_count();
+    if (count == 0) return;
+
+    ensure_offline_buffer();
+    if (s_offline_ready && offline_buffer_add_batch(rtc_cache_data(), count) == ESP_OK) {
+        ESP_LOGI(TAG, "[RTC] %zu pomiarow przeniesionych do flasha.", count);
     } else {
-        ESP_LOGE(TAG, "Błąd odczytu temperatury (CRC/Timeout)");
+        ESP_LOGE(TAG, "[RTC] Zapis do flasha nieudany - %zu pomiarow utraconych.", count);
     }
-    
-    return d;
+    rtc_cache_clear();
 }
 
-void app_main(void) {
-    esp_err_t ret = nvs_flash_init();
-    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-      ESP_ERROR_CHECK(nvs_flash_erase());
-      ret = nvs_flash_init();
+// Pomiary sprzed SNTP mają czas od 1970 - po synchronizacji przesuwamy je o skok zegara
+static void restamp_after_sync(SensorData *data, size_t count, time_t unsynced_s, int64_t unsynced_us) {
+    if (count == 0 || !time_is_set()) return;
+
+    int64_t elapsed_s = (esp_timer_get_time() - unsynced_us) / 1000000;
+    int64_t shift_s = (int64_t)time(NULL) - ((int64_t)unsynced_s + elapsed_s);
+    for (size_t i = 0; i < count; i++) {
+        data[i].timestamp += shift_s;
     }
-    ESP_ERROR_CHECK(ret);
+    ESP_LOGI(TAG, "Skorygowano czas %zu pomiarow sprzed SNTP (+%" PRId64 " s).", count, shift_s);
+}
+
+static void uplink(SensorData *live, size_t live_count) {
+    bool mqtt_ready = false;
 
-    storage_init();
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    offline_buffer_init();
-    ble_config_init(GPIO_NUM_0); 
     wifi_connect_init();
+    if (wifi_connect_start() == ESP_OK) {
+        time_t unsynced_s = time(NULL);
+        int64_t unsynced_us = esp_timer_get_time();
+        obtain_time();
+        restamp_after_sync(live, live_count, unsynced_s, unsynced_us);
+
+        if (mqtt_app_start()) {
+            mqtt_ready = true;
+
+            int64_t publish_start_us = esp_timer_get_time();
+            size_t cached = rtc_cache_count();
+            size_t sent = (cached > 0) ? mqtt_send_sensor_batch(rtc_cache_data(), cached) : 0;
+            ESP_LOGI(TAG, "[RTC] Wysłano %zu/%zu pomiarow z pamieci RTC.", sent, cached);
+
+            if (sent < cached) {
+                // Niepotwierdzona końcówka zostaje na flashu
+                ensure_offline_buffer();
+                if (s_offline_ready) {
+                    offline_buffer_add_batch(rtc_cache_data() + sent, cached - sent);
+                }
+            }
+            rtc_cache_clear();
 
-    onewire_bus_handle_t bus = NULL;
-    onewire_bus_config_t bus_config = {
-        .bus_gpio_num = SENSOR_GPIO,
-    };
-    onewire_bus_rmt_config_t rmt_config = {
-        .max_rx_bytes = 10, 
-    };
-    
-    ESP_LOGI(TAG, "Inicjalizacja OneWire na GPIO %d...", SENSOR_GPIO);
-    ESP_ERROR_CHECK(onewire_new_bus_rmt(&bus_config, &rmt_config, &bus));
-
-    int ds18b20_device_num = 0;
-    ds18b20_device_handle_t ds18b20s[MAX_SENSORS];
-    onewire_device_iter_handle_t iter = NULL;
-    onewire_device_t next_onewire_device;
-    esp_err_t search_result = ESP_OK;
-
-    ESP_ERROR_CHECK(onewire_new_device_iter(bus, &iter));
-    ESP_LOGI(TAG, "Szukanie urządzeń...");
-
-    do {
-        search_result = onewire_device_iter_get_next(iter, &next_onewire_device);
-        if (search_result == ESP_OK) { 
-            ds18b20_config_t ds_cfg = {};
-            if (ds18b20_new_device_from_enumeration(&next_onewire_device, &ds_cfg, &ds18b20s[ds18b20_device_num]) == ESP_OK) {
-                ESP_LOGI(TAG, "Znaleziono DS18B20 -> ID: %d", ds18b20_device_num);
-                ds18b20_device_num++;
+            // Pomiary bez poprawnego czasu nie trafiły do cache - tylko wysyłka na żywo
+            if (live_count > 0) {
+                mqtt_send_sensor_batch(live, live_count);
             }
+            diag_phase_add(DIAG_PHASE_PUBLISH, publish_start_us);
+
+            // Zaległości na końcu - bieżące dane już wysłane
+            ensure_offline_buffer();
+            if (s_offline_ready && sent == cached) {
+                drain_backlog();
+            }
+#if CONFIG_HIVE_DIAG
+            // Obejmuje też wybudzenia bez radia od poprzedniej wysyłki
+            mqtt_send_diag();
+#endif
+#if CONFIG_HIVE_OTA
+            // Restartuje po kompletnym obrazie - dane z cyklu są już wysłane
+            mqtt_ota_process(CONFIG_HIVE_OTA_SESSION_S * 1000);
+#endif
         }
-    } while (search_result != ESP_ERR_NOT_FOUND && ds18b20_device_num < MAX_SENSORS);
-    
-    ESP_ERROR_CHECK(onewire_del_device_iter(iter));
-    ESP_LOGI(TAG, "Znaleziono łącznie: %d czujników.", ds18b20_device_num);
+    } else {
+        ESP_LOGE(TAG, "Brak WiFi (Offline).");
+    }
+
+    if (!mqtt_ready) {
+        flush_cache_to_flash();
+    }
+
+    mqtt_app_stop();
+    wifi_connect_stop();
+}
+
+static void deep_sleep_cycle(void) {
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    uint32_t wake = rtc_cache_next_wake();
+    ESP_LOGI(TAG, "\n================ WYBUDZENIE #%lu (przyczyna %d) ================", (unsigned long)wake, cause);
+    diag_watch_task(NULL);
+
+    // Przycisk = ktoś majstruje przy urządzeniu (np. dołożył sondę)
+    uint32_t rescan_every = RESCAN_PERIOD_S / CONFIG_HIVE_SLEEP_INTERVAL_S;
+    if (cause == ESP_SLEEP_WAKEUP_EXT0 ||
+        (RESCAN_PERIOD_S > 0 && wake % (rescan_every > 0 ? rescan_every : 1) == 0)) {
+        rescan_sensors();
+    }
+
+    static SensorData readings[MAX_CYCLE_RECORDS];
+    size_t n = sensor_manager_read_all(readings, SENSOR_MANAGER_MAX_SENSORS);
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    bool alarm_changed = alarm_engine_update(readings, n, tv.tv_sec);
+    bool time_valid = time_is_set();
+
+#if CONFIG_HIVE_AGGREGATION
+    // Bez poprawnego czasu okna nie mają sensu - taki pomiar idzie tylko na żywo
+    if (time_valid) {
+        n = aggregate_readings(readings, n, alarm_changed);
+    }
+#endif
+
+#if CONFIG_HIVE_DEADBAND
+    n = report_filter_apply(readings, n, alarm_changed);
+#endif
+
+    // Numer nadany raz - ponowne wysyłki tego samego rekordu backend rozpozna
+    record_seq_assign(readings, n);
+
+    if (time_valid && n > 0 && !rtc_cache_add(readings, n)) {
+        // Pamięć RTC pełna - zrzut na flash bez włączania radia
+        flush_cache_to_flash();
+        rtc_cache_add(readings, n);
+    }
+
+    // Zimny start / przycisk / brak czasu (trzeba SNTP) też wymuszają połączenie
+    bool do_uplink = (wake % UPLINK_EVERY_N_WAKES == 0) || alarm_changed ||
+                     cause != ESP_SLEEP_WAKEUP_TIMER || !time_valid;
+#if CONFIG_HIVE_OTA
+    do_uplink = do_uplink || mqtt_ota_active();     // rozpoczęty transfer obrazu - kolejna porcja
+#endif
+
+    if (do_uplink) {
+        if (alarm_changed) {
+            ESP_LOGW(TAG, "[ALARM] Zmiana stanu alarmu -> natychmiastowa wysyłka.");
+        }
+        uplink(readings, time_valid ? 0 : n);
+    } else {
+        ESP_LOGI(TAG, "[RTC] Pomiar w pamieci RTC (%zu). Radio wylaczone.", rtc_cache_count());
+    }
+
+    // Po wybudzeniu przyciskiem dajemy czas na przytrzymanie (start BLE)
+    if (cause == ESP_SLEEP_WAKEUP_EXT0) {
+        vTaskDelay(pdMS_TO_TICKS(BUTTON_WAKE_WINDOW_MS));
+    }
+    while (ble_config_is_active()) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+    }
+
+    // Wybudzenie w chwili wyrównanej do zegara (np. :00, :05), nie "interwał od teraz"
+    int64_t sleep_us = scheduler_us_until_aligned(CONFIG_HIVE_SLEEP_INTERVAL_S);
+    if (sleep_us < 1000000LL) sleep_us += SLEEP_INTERVAL_US;
+
+    // Przekroczenie w toku - sprawdzamy wcześniej, żeby alarm nie czekał całego interwału
+    if (ALARM_WATCH_US > 0 && alarm_engine_pending() && sleep_us > (int64_t)ALARM_WATCH_US) {
+        sleep_us = ALARM_WATCH_US;
+    }
+
+    ESP_LOGI(TAG, "[SLEEP] Deep sleep na %" PRId64 " ms...", sleep_us / 1000);
+    esp_sleep_enable_timer_wakeup((uint64_t)sleep_us);
+    esp_sleep_enable_ext0_wakeup(BUTTON_GPIO, 0);
+    diag_cycle_end();
+    esp_deep_sleep_start();
+}
+#endif
+
+// --- TRYB CIĄGŁY: TASK POMIARÓW + TASK WYSYŁKI ---
+// Pomiary idą wg harmonogramu (scheduler.h) na jednym rdzeniu, sieć (WiFi/SNTP/TLS/bufor offline)
+// na drugim. W chwili wysyłki task pomiarów budzi task wysyłki, więc zestawianie połączenia
+// trwa równolegle z konwersją DS18B20; gotowe pomiary przechodzą przez kolejkę.
+// Paczki leżą w stałej puli, kolejki przenoszą tylko wskaźniki.
+
+#define SAMPLE_POOL_LEN         4       // paczek w obiegu (~2.6 KB każda, razem ~10 KB)
+#define SAMPLE_WAIT_MS          5000    // ile wysyłka czeka na pomiary z bieżącego cyklu
+#define SAMPLING_CORE           1       // APP_CPU
+#define UPLINK_CORE             0       // PRO_CPU - tam działa stos WiFi
+#define SAMPLING_TASK_STACK     4096
+#define UPLINK_TASK_STACK       6144
+#define ALARM_WATCH_MS          (CONFIG_HIVE_ALARM_WATCH_PERIOD_S * 1000)
+
+typedef struct {
+    SensorData readings[MAX_CYCLE_RECORDS];
+    size_t count;
+    int64_t sampled_us;     // esp_timer w chwili pomiaru - do korekty czasu sprzed SNTP
+    uint32_t cycle;         // numer cyklu, w którym zrobiono pomiar
+} sample_batch_t;
+
+static sample_batch_t s_sample_pool[SAMPLE_POOL_LEN];
+static QueueHandle_t s_free_queue = NULL;      // wolne paczki z puli
+static QueueHandle_t s_sample_queue = NULL;    // paczki czekające na wysyłkę
+static TaskHandle_t s_uplink_task = NULL;
+
+// Pomiary zrobione przed synchronizacją SNTP dostają czas liczony wstecz od teraz
+static bool fix_timestamps(sample_batch_t *batch) {
+    if (batch->count == 0 || batch->readings[0].timestamp >= MIN_VALID_TIMESTAMP) {
+        return true;
+    }
+    if (!time_is_set()) {
+        return false;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t age_s = (esp_timer_get_time() - batch->sampled_us) / 1000000;
+    for (size_t i = 0; i < batch->count; i++) {
+        batch->readings[i].timestamp = (int64_t)tv.tv_sec - age_s;
+    }
+    ESP_LOGI(TAG, "Skorygowano czas pomiarow sprzed SNTP (%" PRId64 " s temu).", age_s);
+    return true;
+}
+
+static void store_offline(sample_batch_t *batch, size_t from) {
+    if (from >= batch->count) return;
+
+    if (fix_timestamps(batch)) {
+        ESP_LOGI(TAG, "Offline -> Zapis do bufora.");
+        offline_buffer_add_batch(&batch->readings[from], batch->count - from);
+    } else {
+        ESP_LOGW(TAG, "Offline + Zły czas -> Dane odrzucone.");
+    }
+}
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    int cycle_counter = 0;
+// Wolna paczka z puli; gdy wszystkie czekają na zawieszoną wysyłkę, najstarsza idzie na flash
+static sample_batch_t *take_free_batch(void) {
+    sample_batch_t *batch = NULL;
+    if (xQueueReceive(s_free_queue, &batch, 0) == pdTRUE) {
+        return batch;
+    }
+    if (xQueueReceive(s_sample_queue, &batch, 0) == pdTRUE) {
+        ESP_LOGW(TAG, "Kolejka wysylki pelna.");
+        store_offline(batch, 0);
+        return batch;
+    }
+    return NULL;
+}
+
+static void sampling_task(void *pvParam) {
+    (void)pvParam;
+    uint32_t cycle_counter = 0;
+    sample_batch_t *batch = NULL;
+    int64_t next_rescan_us = (int64_t)RESCAN_PERIOD_S * 1000000LL;
 
     while (1) {
+        scheduler_slot_t slot = scheduler_wait_next(ALARM_WATCH_MS);
         cycle_counter++;
-        ESP_LOGI(TAG, "\n================ CYKL #%d ================", cycle_counter);
+        if (slot.watch) {
+            ESP_LOGD(TAG, "Pomiar kontrolny alarmow (cykl #%lu)", (unsigned long)cycle_counter);
+        } else {
+            ESP_LOGI(TAG, "\n================ CYKL #%lu (%s%s) ================", (unsigned long)cycle_counter,
+                     slot.sensor_mask ? "pomiar" : "", slot.uplink ? " wysyłka" : "");
+        }
+
+        // Start zestawiania połączenia równolegle z konwersją.
+        // Wartość powiadomienia: numer cyklu, na którego pomiar wysyłka ma poczekać (0 = brak pomiaru)
+        if (slot.uplink) {
+            xTaskNotify(s_uplink_task, slot.sensor_mask ? cycle_counter : 0, eSetValueWithOverwrite);
+        }
+        if (slot.sensor_mask == 0 && !slot.watch) continue;
+
+        // Okresowe sprawdzenie podłączeń (hot-plug); nowa sonda wchodzi do harmonogramu od kolejnego slotu
+        if (RESCAN_PERIOD_S > 0 && esp_timer_get_time() >= next_rescan_us) {
+            rescan_sensors();
+            next_rescan_us = esp_timer_get_time() + (int64_t)RESCAN_PERIOD_S * 1000000LL;
+        }
+
+        // Paczka zostaje w tym tasku, dopóki nie trafi do kolejki (pominięte cykle użyją jej ponownie)
+        if (batch == NULL && (batch = take_free_batch()) == NULL) {
+            ESP_LOGE(TAG, "Brak wolnej paczki - pomiar pominiety.");
+            continue;
+        }
+        batch->sampled_us = esp_timer_get_time();
+        batch->cycle = cycle_counter;
+        // Jedna wspólna konwersja dla całej magistrali (czas zależny od rozdzielczości, nie od liczby czujników)
+        batch->count = sensor_manager_read(slot.watch ? UINT32_MAX : slot.sensor_mask,
+                                          batch->readings, SENSOR_MANAGER_MAX_SENSORS);
+
+        // Znacznik czasu = zaplanowana chwila, więc pomiary różnych urządzeń się pokrywają
+        if (slot.synced) {
+            for (size_t i = 0; i < batch->count; i++) {
+                batch->readings[i].timestamp = slot.at;
+            }
+        }
+
+        bool alarm_changed = alarm_engine_update(batch->readings, batch->count, slot.at);
+        if (slot.watch && !alarm_changed) continue; // pomiar kontrolny bez zmian - nie zapisujemy
+
+        if (alarm_changed && !slot.uplink) {
+            // Wysyłka poza harmonogramem - alarm nie czeka na kolejny cykl
+            ESP_LOGW(TAG, "[ALARM] Zmiana stanu alarmu -> natychmiastowa wysyłka.");
+            xTaskNotify(s_uplink_task, cycle_counter, eSetValueWithOverwrite);
+        }
+
+        if (batch->count == 0) {
+            ESP_LOGE(TAG, "BRAK CZUJNIKÓW!");
+            continue;
+        }
+
+#if CONFIG_HIVE_AGGREGATION
+        // Dalej idą tylko zamknięte okna (przed synchronizacją czasu - surowe pomiary)
+        if (slot.synced) {
+            batch->count = aggregate_readings(batch->readings, batch->count, alarm_changed);
+        }
+#endif
+
+#if CONFIG_HIVE_DEADBAND
+        // Tylko istotne zmiany (lub heartbeat)
+        batch->count = report_filter_apply(batch->readings, batch->count, alarm_changed);
+#endif
+
+        // Pusta paczka idzie dalej tylko gdy wysyłka czeka na ten cykl
+        if (batch->count == 0 && !slot.uplink) continue;
+
+        // Numer nadany raz - ponowne wysyłki tego samego rekordu backend rozpozna
+        record_seq_assign(batch->readings, batch->count);
+
+        // Kolejka mieści całą pulę - wysłanie zawsze się udaje
+        xQueueSend(s_sample_queue, &batch, 0);
+        batch = NULL;
+    }
+}
+
+static void uplink_task(void *pvParam) {
+    (void)pvParam;
+    while (1) {
+        uint32_t wait_for_cycle = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &wait_for_cycle, portMAX_DELAY);
+        diag_cycle_start();
 
         ESP_LOGI(TAG, "[WiFi] Próba połączenia...");
         bool is_online = false;
@@ -161,64 +538,112 @@ void app_main(void) {
             ESP_LOGI(TAG, "[SYSTEM] ONLINE. Start MQTT...");
             if (mqtt_app_start()) {
                 mqtt_ready = true;
-                
-                if (offline_buffer_count() > 0) {
-                    ESP_LOGW(TAG, "Wysyłanie bufora offline...");
-                    offline_process_queue(mqtt_send_sensor_data);
-                }
             }
         } else {
             ESP_LOGE(TAG, "Brak WiFi (Offline).");
         }
 
-        time_t now;
-        struct tm timeinfo;
-        time(&now);
-        localtime_r(&now, &timeinfo);
-        
-        bool time_is_valid = (timeinfo.tm_year > (2020 - 1900));
-        
-        if (!time_is_valid) {
+        if (!time_is_set()) {
              ESP_LOGW(TAG, "⚠️ CZAS NIEPRAWIDŁOWY (1970). Dane nie będą buforowane!");
         }
 
-        if (ds18b20_device_num > 0) {
-            for (int i = 0; i < ds18b20_device_num; i++) {
-                ESP_LOGI(TAG, "--- Czujnik %d ---", i);
-
-                SensorData current_data = get_ds18b20_reading(ds18b20s[i]);
-                current_data.sensor_id = i; 
-
-                ESP_LOGI(TAG, "Odczyt ID[%d]: %.2f st. C", i, current_data.temp);
-
-                if (mqtt_ready) {
-                    if (!mqtt_send_sensor_data(current_data)) {
-                        ESP_LOGE(TAG, "Błąd MQTT. Próba buforowania...");
-                        if (time_is_valid) offline_buffer_add(current_data);
-                    } else {
-                        ESP_LOGI(TAG, "Wysłano OK.");
-                    }
+        // Pomiary z bieżącego cyklu (i zebrane od poprzedniej wysyłki)
+        sample_batch_t *batch;
+        bool live_ok = true;
+        TickType_t wait = wait_for_cycle ? pdMS_TO_TICKS(SAMPLE_WAIT_MS) : 0;
+        while (xQueueReceive(s_sample_queue, &batch, wait) == pdTRUE) {
+            if (batch->cycle >= wait_for_cycle) wait = 0;
+            if (batch->count == 0) {
+                xQueueSend(s_free_queue, &batch, 0);
+                continue;
+            }
+            fix_timestamps(batch);
+
+            // Wszystkie czujniki z cyklu w jednej serii (jedna paczka MQTT)
+            size_t sent = 0;
+            if (mqtt_ready) {
+                int64_t publish_start_us = esp_timer_get_time();
+                sent = mqtt_send_sensor_batch(batch->readings, batch->count);
+                diag_phase_add(DIAG_PHASE_PUBLISH, publish_start_us);
+                if (sent < batch->count) {
+                    live_ok = false;
+                    ESP_LOGE(TAG, "Błąd MQTT. Próba buforowania...");
                 } else {
-                    if (time_is_valid) {
-                        ESP_LOGI(TAG, "Offline -> Zapis do bufora.");
-                        offline_buffer_add(current_data);
-                    } else {
-                        ESP_LOGW(TAG, "Offline + Zły czas -> Dane odrzucone.");
-                    }
+                    ESP_LOGI(TAG, "Wysłano OK.");
                 }
-
-                vTaskDelay(pdMS_TO_TICKS(100)); 
             }
-        } else {
-            ESP_LOGE(TAG, "BRAK CZUJNIKÓW!");
+            store_offline(batch, sent);
+            xQueueSend(s_free_queue, &batch, 0);
         }
 
+        // Bieżące pomiary i alarmy poszły pierwsze; zaległości w porcji na cykl
+        if (mqtt_ready && live_ok) {
+            drain_backlog();
+        }
+#if CONFIG_HIVE_DIAG
+        if (mqtt_ready) {
+            mqtt_send_diag();
+        }
+#endif
+#if CONFIG_HIVE_OTA
+        if (mqtt_ready && live_ok) {
+            // Blokuje tylko task wysyłki - pomiary idą dalej do kolejki
+            mqtt_ota_process(CONFIG_HIVE_OTA_SESSION_S * 1000);
+        }
+#endif
+
+#if !CONFIG_HIVE_MQTT_PERSISTENT
         if (is_online) {
             mqtt_app_stop();
             wifi_connect_stop();
         }
+#endif
+    }
+}
 
-        ESP_LOGI(TAG, "[SLEEP] Czekam 5 minut...");
-        vTaskDelay(pdMS_TO_TICKS(300000));
+void app_main(void) {
+    diag_cycle_start();     // w deep sleep: wybudzenie
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+      ESP_ERROR_CHECK(nvs_flash_erase());
+      ret = nvs_flash_init();
     }
-}
\ No newline at end of file
+    ESP_ERROR_CHECK(ret);
+
+    storage_init();
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ble_config_init(BUTTON_GPIO); 
+    gpio_num_t sensor_gpios[MAX_SENSOR_BUSES];
+    sensor_manager_init(sensor_gpios, parse_sensor_gpios(sensor_gpios, MAX_SENSOR_BUSES));
+    alarm_engine_init(sensor_manager_count());
+    report_filter_init();
+    record_seq_init();
+#if CONFIG_HIVE_AGGREGATION
+    aggregator_init();
+#endif
+    mqtt_register_command("resend", resend_command);
+#if CONFIG_HIVE_OTA
+    mqtt_ota_init();
+#endif
+
+#if CONFIG_HIVE_DEEP_SLEEP
+    // Nie wraca - kończy się esp_deep_sleep_start(); flash i WiFi inicjalizowane tylko gdy potrzebne
+    deep_sleep_cycle();
+#endif
+
+    offline_buffer_init();
+    wifi_connect_init();
+    scheduler_init(sensor_manager_count());
+
+    s_sample_queue = xQueueCreate(SAMPLE_POOL_LEN, sizeof(sample_batch_t *));
+    s_free_queue = xQueueCreate(SAMPLE_POOL_LEN, sizeof(sample_batch_t *));
+    for (size_t i = 0; i < SAMPLE_POOL_LEN; i++) {
+        sample_batch_t *batch = &s_sample_pool[i];
+        xQueueSend(s_free_queue, &batch, 0);
+    }
+    TaskHandle_t sampling = NULL;
+    xTaskCreatePinnedToCore(uplink_task, "uplink", UPLINK_TASK_STACK, NULL, 5, &s_uplink_task, UPLINK_CORE);
+    xTaskCreatePinnedToCore(sampling_task, "sampling", SAMPLING_TASK_STACK, NULL, 6, &sampling, SAMPLING_CORE);
+    diag_watch_task(s_uplink_task);
+    diag_watch_task(sampling);
+}